@@ -0,0 +1,157 @@
+// Block compression benchmark: the scalar reference encoder (bc_encoder.h) against the runtime SIMD encoder on one
+// thread and on all threads, with throughput in megapixels per second and PSNR of the decoded result.
+
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <resources.h>
+
+#include "render/texture/bc_encoder.h"
+#include "render/texture/block_compressor.h"
+#include "render/texture/image_decoder.h"
+
+static const int iterations = 5;
+
+static double measure(const std::function<void()> &fn)
+{
+    fn(); // Warm-up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static uint32_t readBits(const uint8_t *bytes, int &position, int count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++, position++)
+        value |= static_cast<uint32_t>((bytes[position >> 3] >> (position & 7)) & 1) << i;
+    return value;
+}
+
+// Decode the blocks both encoders emit (BC1 four-color, BC7 mode 6) back to RGBA
+static std::vector<uint8_t> decodeBlocks(const std::vector<uint8_t> &blocks, int width, int height, bool bc7)
+{
+    static const int bc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            const uint8_t *block = blocks.data() + (static_cast<size_t>(by) * blocksX + bx) * (bc7 ? 16 : 8);
+            int palette[16][4];
+            int indices[16];
+            if (bc7)
+            {
+                int position = 7, endpoints[2][4];
+                for (int c = 0; c < 4; c++)
+                    for (int e = 0; e < 2; e++)
+                        endpoints[e][c] = static_cast<int>(readBits(block, position, 7)) << 1;
+                for (int e = 0; e < 2; e++)
+                {
+                    int pBit = static_cast<int>(readBits(block, position, 1));
+                    for (int c = 0; c < 4; c++)
+                        endpoints[e][c] |= pBit;
+                }
+                for (int i = 0; i < 16; i++)
+                    indices[i] = static_cast<int>(readBits(block, position, i == 0 ? 3 : 4));
+                for (int w = 0; w < 16; w++)
+                    for (int c = 0; c < 4; c++)
+                        palette[w][c] = ((64 - bc7Weights[w]) * endpoints[0][c] + bc7Weights[w] * endpoints[1][c] + 32) >> 6;
+            }
+            else
+            {
+                uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+                uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+                unpackRGB565(c0, palette[0]);
+                unpackRGB565(c1, palette[1]);
+                for (int c = 0; c < 3; c++)
+                {
+                    palette[2][c] = c0 > c1 ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = c0 > c1 ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+                }
+                for (int p = 0; p < 4; p++)
+                    palette[p][3] = 255;
+                for (int i = 0; i < 16; i++)
+                    indices[i] = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                int x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if (x < width && y < height)
+                    for (int c = 0; c < 4; c++)
+                        rgba[(static_cast<size_t>(y) * width + x) * 4 + c] = static_cast<uint8_t>(palette[indices[i]][c]);
+            }
+        }
+    }
+    return rgba;
+}
+
+static double psnr(const uint8_t *a, const std::vector<uint8_t> &b, int channels)
+{
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < b.size(); i += 4)
+    {
+        for (int c = 0; c < channels; c++, count++)
+        {
+            double d = static_cast<double>(a[i + c]) - b[i + c];
+            sum += d * d;
+        }
+    }
+    double mse = sum / count;
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+static bool isImage(const std::string &name)
+{
+    for (const char *extension : {".jpg", ".jpeg", ".png"})
+    {
+        std::string ext = extension;
+        if (name.size() > ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0)
+            return true;
+    }
+    return false;
+}
+
+int main()
+{
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t r = 0; r < embeddedResourceCount; r++)
+    {
+        const EmbeddedResource &resource = embeddedResources[r];
+        DecodedImage image;
+        if (!isImage(resource.name) || !decodeImage(resource.data, resource.size, 4, image))
+            continue;
+
+        const double megapixels = static_cast<double>(image.width) * image.height / 1e6;
+        for (bool bc7 : {false, true})
+        {
+            const BlockFormat format = bc7 ? BlockFormat::BC7 : BlockFormat::BC1;
+            const int channels = bc7 ? 4 : 3;
+            std::vector<uint8_t> reference, single, parallel;
+            double referenceMs = measure([&]
+                                         { reference = compressImageBC(image.data(), image.width, image.height, bc7); });
+            double singleMs = measure([&]
+                                      { single = compressBlocks(image.data(), image.width, image.height, format, 1); });
+            double parallelMs = measure([&]
+                                        { parallel = compressBlocks(image.data(), image.width, image.height, format, threads); });
+
+            spdlog::info("{} ({}x{}) {}: reference {:7.1f} MP/s {:5.2f} dB | SIMD {:7.1f} MP/s {:5.2f} dB | {} threads {:7.1f} MP/s",
+                         resource.name, image.width, image.height, bc7 ? "BC7" : "BC1", megapixels / (referenceMs / 1000.0),
+                         psnr(image.data(), decodeBlocks(reference, image.width, image.height, bc7), channels),
+                         megapixels / (singleMs / 1000.0),
+                         psnr(image.data(), decodeBlocks(single, image.width, image.height, bc7), channels), threads,
+                         megapixels / (parallelMs / 1000.0));
+            if (parallel != single)
+                spdlog::error("Threaded output differs from single-threaded output");
+        }
+    }
+    return 0;
+}
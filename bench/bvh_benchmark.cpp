@@ -0,0 +1,159 @@
+// BVH benchmark: build, frustum, ray and box queries, and local refits, in milliseconds per call. The
+// frustum query is checked against the flat SIMD culling of the same boxes, the ray query against a
+// brute-force search.
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "scene/bvh.h"
+
+static const int iterations = 20;
+
+static double measure(const std::function<void()> &fn)
+{
+    fn(); // Warm-up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(50.0f, 0.0f, 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = extractFrustum(projection * view);
+
+    for (size_t count : {1000u, 100000u, 1000000u})
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f), size(0.2f, 2.0f), unit(-1.0f, 1.0f);
+        BoxArrays boxes;
+        boxes.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            boxes.centerX[i] = position(random);
+            boxes.centerY[i] = position(random) * 0.05f;
+            boxes.centerZ[i] = position(random);
+            boxes.extentX[i] = size(random);
+            boxes.extentY[i] = size(random);
+            boxes.extentZ[i] = size(random);
+        }
+
+        Bvh bvh;
+        auto start = std::chrono::steady_clock::now();
+        bvh.build(boxes);
+        double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // Frustum: same set as the flat cull
+        std::vector<uint32_t> visible(count), reference(count);
+        size_t visibleCount = 0, referenceCount = 0;
+        double flatMs = measure([&]
+                                { referenceCount = cullBoxes(frustum, boxes, reference.data()); });
+        double frustumMs = measure([&]
+                                   { visibleCount = bvh.cullFrustum(frustum, visible.data()); });
+        std::sort(visible.begin(), visible.begin() + visibleCount);
+        if (visibleCount != referenceCount || !std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin()))
+            spdlog::error("BVH frustum query differs from the flat cull ({} vs {})", visibleCount, referenceCount);
+
+        // Rays from above into the field: nearest box, checked against brute force for the first few
+        std::vector<glm::vec3> origins(256), directions(256);
+        for (size_t i = 0; i < origins.size(); i++)
+        {
+            origins[i] = glm::vec3(position(random), 50.0f, position(random));
+            directions[i] = glm::normalize(glm::vec3(unit(random) * 0.3f, -1.0f, unit(random) * 0.3f));
+        }
+        size_t hits = 0;
+        double rayMs = measure([&]
+                               {
+                                   hits = 0;
+                                   for (size_t i = 0; i < origins.size(); i++)
+                                   {
+                                       uint32_t object;
+                                       float distance;
+                                       hits += bvh.raycast(origins[i], directions[i], 1000.0f, nullptr, object, distance);
+                                   } }) /
+                       origins.size();
+        for (size_t i = 0; i < 16; i++)
+        {
+            uint32_t object = UINT32_MAX;
+            float distance = 1000.0f, nearest = 1000.0f;
+            bvh.raycast(origins[i], directions[i], 1000.0f, nullptr, object, distance);
+            for (size_t b = 0; b < count; b++)
+            {
+                glm::vec3 center(boxes.centerX[b], boxes.centerY[b], boxes.centerZ[b]);
+                glm::vec3 extent(boxes.extentX[b], boxes.extentY[b], boxes.extentZ[b]);
+                glm::vec3 t0 = (center - extent - origins[i]) / directions[i], t1 = (center + extent - origins[i]) / directions[i];
+                glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+                float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+                float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+                if (entry <= exit && entry < nearest)
+                    nearest = entry;
+            }
+            if (std::abs(nearest - distance) > 1e-3f)
+                spdlog::error("BVH ray {} hit at {} but brute force finds {}", i, distance, nearest);
+        }
+
+        // Box query: a 20 unit cube around a random point
+        std::vector<uint32_t> overlapping;
+        size_t overlapCount = 0;
+        double boxMs = measure([&]
+                               {
+                                   overlapCount = 0;
+                                   for (int i = 0; i < 64; i++)
+                                   {
+                                       glm::vec3 center(position(random), 0.0f, position(random));
+                                       bvh.queryBox(center - glm::vec3(10.0f), center + glm::vec3(10.0f), overlapping);
+                                       overlapCount += overlapping.size();
+                                   } }) /
+                       64;
+
+        // 1% of the objects drift a little every "frame"
+        const size_t movers = std::max<size_t>(count / 100, 1);
+        std::vector<glm::vec3> centers(count);
+        for (size_t i = 0; i < count; i++)
+            centers[i] = glm::vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        double refitMs = measure([&]
+                                 {
+                                     for (size_t m = 0; m < movers; m++)
+                                     {
+                                         size_t i = (m * 7919) % count;
+                                         centers[i] += glm::vec3(unit(random), 0.0f, unit(random)) * 0.1f;
+                                         bvh.update(static_cast<uint32_t>(i), centers[i],
+                                                    glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]));
+                                     }
+                                     bvh.maintain(); });
+
+        // Let the background rebuild those refits triggered land
+        start = std::chrono::steady_clock::now();
+        while (bvh.rebuilding())
+        {
+            bvh.maintain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        double rebuildWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        for (size_t i = 0; i < count; i++)
+        {
+            boxes.centerX[i] = centers[i].x;
+            boxes.centerZ[i] = centers[i].z;
+        }
+        referenceCount = cullBoxes(frustum, boxes, reference.data());
+        visibleCount = bvh.cullFrustum(frustum, visible.data());
+        std::sort(visible.begin(), visible.begin() + visibleCount);
+        if (visibleCount != referenceCount || !std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin()))
+            spdlog::error("BVH frustum query after refits and rebuild differs from the flat cull");
+
+        spdlog::info("{:>8} objects, {:>6} nodes: build {:7.2f} ms | frustum {:6.3f} ms ({} visible, flat {:6.3f} ms) | "
+                     "ray {:6.4f} ms ({} / {} hit) | box {:6.4f} ms ({:.0f} found) | refit {} {:6.3f} ms | rebuild wait {:.0f} ms",
+                     count, bvh.nodeCount(), buildMs, frustumMs, visibleCount, flatMs, rayMs, hits, origins.size(), boxMs,
+                     overlapCount / 64.0, movers, refitMs, rebuildWaitMs);
+    }
+    return 0;
+}
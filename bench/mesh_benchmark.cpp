@@ -0,0 +1,172 @@
+// Mesh import benchmark: a tessellated sphere is written as an OBJ with its triangles shuffled, then
+// imported the way MeshImporter does it (parse, dedup, vertex cache, overdraw, vertex fetch, pack)
+// and compared with loading the resulting cache file through a memory mapping. Reports the time of
+// every pass and the post-transform cache efficiency (ACMR, lower is better) before and after, and
+// checks that the passes keep every triangle. Needs no GL context.
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "io/mapped_file.h"
+#include "render/mesh/mesh_format.h"
+#include "render/mesh/mesh_optimizer.h"
+#include "render/mesh/obj_loader.h"
+
+static const int runs = 5;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// UV sphere with rings x segments quads, triangles in random order
+static void writeSphereObj(const char *path, int rings, int segments)
+{
+    std::ofstream out(path);
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        const float theta = 3.14159265f * ring / rings;
+        for (int segment = 0; segment <= segments; segment++)
+        {
+            const float phi = 2.0f * 3.14159265f * segment / segments;
+            out << "v " << std::sin(theta) * std::cos(phi) << ' ' << std::cos(theta) << ' '
+                << std::sin(theta) * std::sin(phi) << '\n';
+            out << "vt " << static_cast<float>(segment) / segments << ' ' << static_cast<float>(ring) / rings << '\n';
+        }
+    }
+
+    std::vector<std::array<int, 3>> triangles;
+    for (int ring = 0; ring < rings; ring++)
+        for (int segment = 0; segment < segments; segment++)
+        {
+            const int a = ring * (segments + 1) + segment + 1, b = a + segments + 1; // OBJ counts from 1
+            triangles.push_back({a, b, a + 1});
+            triangles.push_back({a + 1, b, b + 1});
+        }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+    for (const std::array<int, 3> &t : triangles)
+        out << "f " << t[0] << '/' << t[0] << ' ' << t[1] << '/' << t[1] << ' ' << t[2] << '/' << t[2] << '\n';
+}
+
+// Triangles as sorted position triples, for comparing meshes whatever their vertex and triangle order
+static std::vector<std::array<float, 9>> triangleSet(const MeshData &mesh)
+{
+    std::vector<std::array<float, 9>> set;
+    for (size_t t = 0; t < mesh.triangleCount(); t++)
+    {
+        std::array<std::array<float, 3>, 3> corners;
+        for (int c = 0; c < 3; c++)
+        {
+            const Vertex &v = mesh.vertices[mesh.indices[t * 3 + c]];
+            corners[c] = {v.pos[0], v.pos[1], v.pos[2]};
+        }
+        // Rotate the smallest corner first, keeping the winding
+        const int first = static_cast<int>(std::min_element(corners.begin(), corners.end()) - corners.begin());
+        std::array<float, 9> key;
+        for (int c = 0; c < 3; c++)
+            for (int i = 0; i < 3; i++)
+                key[c * 3 + i] = corners[(first + c) % 3][i];
+        set.push_back(key);
+    }
+    std::sort(set.begin(), set.end());
+    return set;
+}
+
+int main()
+{
+    const char *objPath = "mesh_benchmark.obj";
+    const char *cachePath = "mesh_benchmark.mesh";
+    for (int size : {64, 256})
+    {
+        writeSphereObj(objPath, size, size * 2);
+
+        double parseMs = 0.0, dedupMs = 0.0, cacheMs = 0.0, overdrawMs = 0.0, fetchMs = 0.0, packMs = 0.0,
+               writeMs = 0.0, loadMs = 0.0;
+        VertexCacheStats before, after;
+        size_t sourceVertices = 0, vertices = 0, triangles = 0, cacheBytes = 0;
+        bool sameTriangles = true, loadedIntact = true;
+        for (int run = 0; run < runs; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            MeshData mesh;
+            if (!loadObj(objPath, mesh))
+                return 1;
+            parseMs += millisecondsSince(start);
+            sourceVertices = mesh.vertices.size();
+            const std::vector<std::array<float, 9>> reference = triangleSet(mesh);
+
+            start = std::chrono::steady_clock::now();
+            deduplicateVertices(mesh);
+            dedupMs += millisecondsSince(start);
+            before = analyzeVertexCache(mesh); // Of the source's triangle order
+            start = std::chrono::steady_clock::now();
+            optimizeVertexCache(mesh);
+            cacheMs += millisecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            optimizeOverdraw(mesh);
+            overdrawMs += millisecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            optimizeVertexFetch(mesh);
+            fetchMs += millisecondsSince(start);
+            after = analyzeVertexCache(mesh);
+            sameTriangles = sameTriangles && triangleSet(mesh) == reference;
+
+            start = std::chrono::steady_clock::now();
+            std::vector<PackedVertex> packed(mesh.vertices.size());
+            for (size_t i = 0; i < packed.size(); i++)
+                convertVertex(mesh.vertices[i], packed[i]);
+            const GLenum indexType = mesh.vertices.size() <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            std::vector<unsigned char> image = buildMeshCache(MeshCacheHeader{}, packed, mesh.indices, indexType);
+            packMs += millisecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            std::ofstream(cachePath, std::ios::binary)
+                .write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+            writeMs += millisecondsSince(start);
+
+            // What a later run does instead of all of the above: map, check, touch every page
+            start = std::chrono::steady_clock::now();
+            MappedFile file;
+            MeshCacheView view;
+            if (!file.open(cachePath) || !parseMeshCache(file.data(), file.size(), view))
+                return 1;
+            unsigned checksum = 0;
+            for (size_t offset = 0; offset < file.size(); offset += 4096)
+                checksum += file.data()[offset];
+            loadMs += millisecondsSince(start);
+            volatile unsigned sink = checksum; // Keeps the page reads
+            (void)sink;
+            loadedIntact = loadedIntact && file.size() == image.size() &&
+                           std::equal(image.begin(), image.end(), file.data());
+
+            vertices = mesh.vertices.size();
+            triangles = mesh.triangleCount();
+            cacheBytes = image.size();
+        }
+
+        const double importMs = parseMs + dedupMs + cacheMs + overdrawMs + fetchMs + packMs + writeMs;
+        spdlog::info("{} triangles, {} -> {} vertices, cache file {:.1f} KB", triangles, sourceVertices, vertices,
+                     cacheBytes / 1024.0);
+        spdlog::info("  ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", before.acmr, after.acmr, before.atvr, after.atvr);
+        spdlog::info("  import {:8.2f} ms: parse {:.2f}, dedup {:.2f}, vertex cache {:.2f}, overdraw {:.2f}, "
+                     "vertex fetch {:.2f}, pack {:.2f}, write {:.2f}",
+                     importMs / runs, parseMs / runs, dedupMs / runs, cacheMs / runs, overdrawMs / runs,
+                     fetchMs / runs, packMs / runs, writeMs / runs);
+        spdlog::info("  cache load {:8.2f} ms ({:.0f}x faster)", loadMs / runs, importMs / std::max(loadMs, 1e-6));
+        if (!sameTriangles)
+            spdlog::error("  The optimization passes changed the triangles");
+        if (!loadedIntact)
+            spdlog::error("  The mapped cache file differs from the image written");
+        if (after.acmr >= before.acmr)
+            spdlog::error("  Vertex cache optimization did not lower the ACMR");
+    }
+    std::remove(objPath);
+    std::remove(cachePath);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Mip chain generation benchmark: glGenerateMipmap vs the CPU builder (box / Kaiser, 1 vs N threads).
+// Timings include the texture upload and a glFinish so driver-side work is counted.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <resources.h>
+
+#include "render/texture/image_decoder.h"
+#include "render/texture/mipmap.h"
+
+static const int iterations = 10;
+
+static double measure(const std::function<void()> &fn)
+{
+    fn(); // Warm-up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        fn();
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main()
+{
+    if (!glfwInit())
+        return 1;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow *window = glfwCreateWindow(64, 64, "mipmap_benchmark", NULL, NULL);
+    if (!window)
+    {
+        spdlog::error("Failed to create GLFW window");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    spdlog::info("Renderer: {}", reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (const char *name : {"resources/textures/wood.jpg", "resources/textures/concrete.jpg"})
+    {
+        const EmbeddedResource *resource = findEmbeddedResource(name);
+        DecodedImage image;
+        if (!resource || !decodeImage(resource->data, resource->size, 3, image))
+        {
+            spdlog::error("Failed to decode {}", name);
+            continue;
+        }
+        const uint8_t *pixels = image.data();
+        const int width = image.width;
+        const int height = image.height;
+
+        auto upload = [&](const std::vector<MipLevel> &levels)
+        {
+            for (size_t level = 0; level < levels.size(); level++)
+                glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGB, levels[level].width, levels[level].height, 0,
+                             GL_RGB, GL_UNSIGNED_BYTE, levels[level].pixels.data());
+        };
+
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        double glTime = measure([&]
+                                {
+                                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+                                    glGenerateMipmap(GL_TEXTURE_2D);
+                                    glFinish(); });
+        double boxSingle = measure([&]
+                                   { upload(buildMipChain(pixels, width, height, 3, MipFilter::Box, true, 1)); glFinish(); });
+        double boxParallel = measure([&]
+                                     { upload(buildMipChain(pixels, width, height, 3, MipFilter::Box, true, threads)); glFinish(); });
+        double kaiserParallel = measure([&]
+                                        { upload(buildMipChain(pixels, width, height, 3, MipFilter::Kaiser, true, threads)); glFinish(); });
+
+        spdlog::info("{} ({}x{}):", name, width, height);
+        spdlog::info("  glGenerateMipmap          {:8.2f} ms", glTime);
+        spdlog::info("  CPU box, 1 thread         {:8.2f} ms", boxSingle);
+        spdlog::info("  CPU box, {:2} threads       {:8.2f} ms", threads, boxParallel);
+        spdlog::info("  CPU Kaiser, {:2} threads    {:8.2f} ms", threads, kaiserParallel);
+    }
+
+    glDeleteTextures(1, &texture);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -7,9 +7,7 @@
 #include <unordered_map>
 #include "../../render/text/text_renderer.h"
 #include "../../config.h"
-
-// Declare external variables
-extern bool cubePOVMode; // Add this to access cubePOVMode from main.cpp
+#include "../../scene/scene.h"
 
 static TextRenderer *keyboardTextRenderer = nullptr;
 static bool renderDebugText = false; // Flag to control debug text rendering
@@ -22,6 +20,8 @@ static bool pressing_up = false;     // Flag to control looking up
 static bool pressing_down = false;   // Flag to control looking down
 static bool pressing_left = false;   // Flag to control looking left
 static bool pressing_right = false;  // Flag to control looking right
+static bool screenshotRequested = false; // Set by F12, taken by the main loop
+static bool cubePOVMode = false;         // Toggled with V, taken into the simulation's input
 
 // Key state tracking structure
 struct KeyState
@@ -169,6 +169,12 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
         break;
     }
 
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+    {
+        screenshotRequested = true;
+        return;
+    }
+
     if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
     {
         mode = (mode == debug) ? release : debug;
@@ -7,6 +7,10 @@
 #include <spdlog/spdlog.h>
 
 #include "../../config.h"
+#include "../../scene/scene.h"
+
+// Total cursor motion, taken into the simulation's input
+static glm::dvec2 mouseTravel(0.0);
 
 static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
@@ -32,9 +36,6 @@ static void mouse_button_callback(GLFWwindow *window, int button, int action, in
 }
 
 // Mouse callback for camera rotation
-static glm::vec2 rotationAngles(0.0f, 0.0f);
-static glm::vec2 mouseDelta(0.0f);
-
 static void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 {
     static bool firstMouse = true;
@@ -49,24 +50,10 @@ static void mouse_callback(GLFWwindow *window, double xpos, double ypos)
     glm::vec2 currentMousePos(xpos, ypos);
     if (lastPos != glm::vec2(0.0f)) // Skip first frame
     {
-        mouseDelta += currentMousePos - lastPos;
+        mouseTravel += glm::dvec2(currentMousePos - lastPos); // The simulation turns it into camera rotation
     }
     lastPos = currentMousePos;
 
-    glm::vec2 currentPos(xpos, ypos);
-    glm::vec2 delta = currentPos - lastPos;
-
-    // Sensitivity
-    float sensitivity = 0.1f;
-    delta *= sensitivity;
-
-    // Update rotation angles (yaw and pitch)
-    rotationAngles.y += delta.x;                                    // Yaw (left/right)
-    rotationAngles.x -= delta.y;                                    // Pitch (up/down)
-    rotationAngles.x = glm::clamp(rotationAngles.x, -89.0f, 89.0f); // Limit pitch to avoid flipping
-
-    lastPos = currentPos;
-
     // Capture mouse for continuous movement
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 }
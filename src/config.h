@@ -1,6 +1,9 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <cstddef>
+#include <string>
+
 #define debug 1
 #define release 0
 int mode = release;
@@ -12,4 +15,35 @@ static int targetFPS = 144;
 
 // Initial target frame time based on target FPS
 static double targetFrameTime = 1.0 / targetFPS;
+
+// Baked virtual texture for the ground (--vt <file.vt>); empty = regular streamed texture
+static std::string virtualTexturePath;
+
+// Directory watched for texture edits (--watch <dir>); stands for "resources/" in resource paths
+static std::string resourceWatchDirectory = "resources";
+
+// Hard ceiling for GPU texture memory in bytes (--texture-budget <MB>); 0 = unlimited
+static size_t textureMemoryBudget = 0;
+
+// Video played on the cube (--video <file.y4m|file.yuv>); headerless .yuv needs --video-size WxH
+static std::string videoPath;
+static int videoRawWidth = 0;
+static int videoRawHeight = 0;
+
+// Extra cubes drawn with one instanced call (--cubes N); 0 = only the draggable cube
+static int cubeCount = 0;
+
+// Mesh drawn in place of the extra cubes (--mesh <file.obj|file.gltf|file.glb>); imported once, then
+// loaded from its cache in meshCacheDirectory
+static std::string meshPath;
+static std::string meshCacheDirectory = "cache/meshes";
+
+// Draw the extra cubes with multi-draw indirect (--mdi), optionally culled by a compute pass
+// (--gpu-culling, implies --mdi); both need OpenGL 4.3
+static bool useIndirectDraw = false;
+static bool useGpuCulling = false;
+
+// Threads building the frame's draw lists, the main thread included (--record-threads N); 0 = one
+// per hardware thread
+static int recordThreads = 0;
 #endif /* CONFIG_H */
@@ -0,0 +1,146 @@
+#include "file_watcher.h"
+
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+FileWatcher::FileWatcher(const std::string &directory) : root(directory)
+{
+    std::error_code error;
+    if (!fs::is_directory(root, error))
+    {
+        spdlog::warn("File watcher: {} is not a directory", root);
+        return;
+    }
+
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        spdlog::warn("File watcher: inotify_init1 failed");
+        return;
+    }
+    addWatches(root);
+#else
+    scan(false);
+#endif
+    watching = true;
+    thread = std::thread(&FileWatcher::run, this);
+    spdlog::info("Watching {} for changes", root);
+}
+
+FileWatcher::~FileWatcher()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+#endif
+}
+
+std::set<std::string> FileWatcher::takeChanges()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::set<std::string> taken;
+    taken.swap(changes);
+    return taken;
+}
+
+void FileWatcher::report(const std::string &relativePath)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    changes.insert(relativePath);
+}
+
+#ifdef __linux__
+void FileWatcher::addWatches(const fs::path &directory)
+{
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    int wd = inotify_add_watch(inotifyFd, directory.string().c_str(), mask);
+    if (wd < 0)
+        return;
+    std::string relative = fs::relative(directory, root).generic_string();
+    watchDirectories[wd] = relative == "." ? "" : relative + "/";
+
+    std::error_code error;
+    for (const fs::directory_entry &entry : fs::directory_iterator(directory, error))
+    {
+        if (entry.is_directory(error))
+            addWatches(entry.path());
+    }
+}
+
+void FileWatcher::run()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (running)
+    {
+        // Short timeout so shutdown never waits on a quiet directory
+        pollfd descriptor{inotifyFd, POLLIN, 0};
+        if (poll(&descriptor, 1, 200) <= 0)
+            continue;
+
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            auto it = watchDirectories.find(event->wd);
+            if (it == watchDirectories.end() || event->len == 0)
+                continue;
+
+            std::string relative = it->second + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    addWatches(fs::path(root) / relative);
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                report(relative);
+            }
+        }
+    }
+}
+#else
+void FileWatcher::scan(bool notify)
+{
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(root, error), end; it != end; it.increment(error))
+    {
+        if (error || !it->is_regular_file(error))
+            continue;
+        std::string relative = fs::relative(it->path(), root).generic_string();
+        fs::file_time_type time = it->last_write_time(error);
+        auto [entry, inserted] = modificationTimes.try_emplace(relative, time);
+        if (!inserted && entry->second != time)
+        {
+            entry->second = time;
+            if (notify)
+                report(relative);
+        }
+        else if (inserted && notify)
+        {
+            report(relative);
+        }
+    }
+}
+
+void FileWatcher::run()
+{
+    while (running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        scan(true);
+    }
+}
+#endif
@@ -0,0 +1,50 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Recursive directory watcher running on its own thread. Linux uses inotify (close-after-write
+// and rename-into events, so half-written files are never reported); other platforms poll
+// modification times twice a second.
+class FileWatcher
+{
+public:
+    explicit FileWatcher(const std::string &directory);
+    ~FileWatcher();
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    bool valid() const { return watching; }
+    const std::string &directory() const { return root; }
+
+    // Files changed since the last call, relative to the directory with '/' separators
+    std::set<std::string> takeChanges();
+
+private:
+    void run();
+    void report(const std::string &relativePath);
+#ifdef __linux__
+    void addWatches(const std::filesystem::path &directory);
+
+    int inotifyFd = -1;
+    std::unordered_map<int, std::string> watchDirectories; // Watch descriptor -> relative directory
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> modificationTimes;
+    void scan(bool notify);
+#endif
+
+    std::string root;
+    bool watching = false;
+    std::atomic<bool> running{true};
+    std::thread thread;
+    std::mutex mutex;
+    std::set<std::string> changes;
+};
+
+#endif /* FILE_WATCHER_H */
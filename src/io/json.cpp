@@ -0,0 +1,346 @@
+#include "json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static const JsonValue nullValue;
+static const std::string emptyString;
+
+const std::string &JsonValue::asString() const
+{
+    return kind == String ? text : emptyString;
+}
+
+size_t JsonValue::size() const
+{
+    return kind == Array ? elements.size() : kind == Object ? objectMembers.size() : 0;
+}
+
+const JsonValue &JsonValue::operator[](size_t index) const
+{
+    return kind == Array && index < elements.size() ? elements[index] : nullValue;
+}
+
+const JsonValue &JsonValue::operator[](const char *key) const
+{
+    for (const auto &member : objectMembers)
+        if (member.first == key)
+            return member.second;
+    return nullValue;
+}
+
+bool JsonValue::has(const char *key) const
+{
+    for (const auto &member : objectMembers)
+        if (member.first == key)
+            return true;
+    return false;
+}
+
+// Recursive descent over the whole buffer; nesting is capped so hostile input cannot overflow the stack
+class JsonParser
+{
+public:
+    JsonParser(const char *data, size_t size) : cursor(data), end(data + size), begin(data) {}
+
+    bool parseDocument(JsonValue &value, std::string &error)
+    {
+        skipSpace();
+        if (!parseValue(value, 0))
+        {
+            error = message + " at offset " + std::to_string(cursor - begin);
+            return false;
+        }
+        skipSpace();
+        if (cursor != end)
+        {
+            error = "trailing characters at offset " + std::to_string(cursor - begin);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const int maxDepth = 256;
+
+    bool fail(const char *what)
+    {
+        message = what;
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+            cursor++;
+    }
+
+    bool consume(const char *literal)
+    {
+        size_t length = std::strlen(literal);
+        if (static_cast<size_t>(end - cursor) < length || std::memcmp(cursor, literal, length) != 0)
+            return false;
+        cursor += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue &value, int depth)
+    {
+        if (cursor >= end)
+            return fail("unexpected end");
+        switch (*cursor)
+        {
+        case '{':
+            return parseObject(value, depth);
+        case '[':
+            return parseArray(value, depth);
+        case '"':
+            value.kind = JsonValue::String;
+            return parseString(value.text);
+        case 't':
+        case 'f':
+            value.kind = JsonValue::Boolean;
+            value.boolean = *cursor == 't';
+            return consume(value.boolean ? "true" : "false") || fail("invalid literal");
+        case 'n':
+            value.kind = JsonValue::Null;
+            return consume("null") || fail("invalid literal");
+        default:
+            return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue &value, int depth)
+    {
+        if (depth >= maxDepth)
+            return fail("nesting too deep");
+        value.kind = JsonValue::Object;
+        cursor++; // {
+        skipSpace();
+        if (cursor < end && *cursor == '}')
+        {
+            cursor++;
+            return true;
+        }
+        while (true)
+        {
+            skipSpace();
+            if (cursor >= end || *cursor != '"')
+                return fail("expected a key");
+            value.objectMembers.emplace_back();
+            if (!parseString(value.objectMembers.back().first))
+                return false;
+            skipSpace();
+            if (cursor >= end || *cursor != ':')
+                return fail("expected ':'");
+            cursor++;
+            skipSpace();
+            if (!parseValue(value.objectMembers.back().second, depth + 1))
+                return false;
+            skipSpace();
+            if (cursor < end && *cursor == ',')
+            {
+                cursor++;
+                continue;
+            }
+            if (cursor < end && *cursor == '}')
+            {
+                cursor++;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue &value, int depth)
+    {
+        if (depth >= maxDepth)
+            return fail("nesting too deep");
+        value.kind = JsonValue::Array;
+        cursor++; // [
+        skipSpace();
+        if (cursor < end && *cursor == ']')
+        {
+            cursor++;
+            return true;
+        }
+        while (true)
+        {
+            skipSpace();
+            value.elements.emplace_back();
+            if (!parseValue(value.elements.back(), depth + 1))
+                return false;
+            skipSpace();
+            if (cursor < end && *cursor == ',')
+            {
+                cursor++;
+                continue;
+            }
+            if (cursor < end && *cursor == ']')
+            {
+                cursor++;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseHex4(unsigned &code)
+    {
+        if (end - cursor < 4)
+            return fail("truncated escape");
+        code = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            char c = *cursor++;
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            else
+                return fail("invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string &out, unsigned code)
+    {
+        if (code < 0x80)
+            out += static_cast<char>(code);
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string &out)
+    {
+        cursor++; // "
+        while (cursor < end && *cursor != '"')
+        {
+            char c = *cursor++;
+            if (static_cast<unsigned char>(c) < 0x20)
+                return fail("control character in string");
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (cursor >= end)
+                return fail("truncated escape");
+            char escape = *cursor++;
+            switch (escape)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                out += escape;
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+            {
+                unsigned code;
+                if (!parseHex4(code))
+                    return false;
+                // A high surrogate must be followed by its low half
+                if (code >= 0xD800 && code < 0xDC00)
+                {
+                    unsigned low;
+                    if (!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                        return fail("unpaired surrogate");
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+        if (cursor >= end)
+            return fail("unterminated string");
+        cursor++; // "
+        return true;
+    }
+
+    bool parseNumber(JsonValue &value)
+    {
+        // Validate the JSON grammar first; strtod alone would accept hex, inf, leading '+' ...
+        const char *start = cursor;
+        if (cursor < end && *cursor == '-')
+            cursor++;
+        if (cursor >= end || *cursor < '0' || *cursor > '9')
+            return fail("unexpected character");
+        if (*cursor == '0')
+            cursor++;
+        else
+            while (cursor < end && *cursor >= '0' && *cursor <= '9')
+                cursor++;
+        if (cursor < end && *cursor == '.')
+        {
+            cursor++;
+            if (cursor >= end || *cursor < '0' || *cursor > '9')
+                return fail("invalid number");
+            while (cursor < end && *cursor >= '0' && *cursor <= '9')
+                cursor++;
+        }
+        if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+        {
+            cursor++;
+            if (cursor < end && (*cursor == '+' || *cursor == '-'))
+                cursor++;
+            if (cursor >= end || *cursor < '0' || *cursor > '9')
+                return fail("invalid number");
+            while (cursor < end && *cursor >= '0' && *cursor <= '9')
+                cursor++;
+        }
+        // The buffer need not be null-terminated
+        std::string digits(start, cursor);
+        value.kind = JsonValue::Number;
+        value.number = std::strtod(digits.c_str(), nullptr);
+        return true;
+    }
+
+    const char *cursor;
+    const char *end;
+    const char *begin;
+    std::string message;
+};
+
+bool parseJson(const char *data, size_t size, JsonValue &value, std::string &error)
+{
+    value = JsonValue();
+    JsonParser parser(data, size);
+    return parser.parseDocument(value, error);
+}
@@ -0,0 +1,58 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Parsed JSON document tree, enough for glTF: no streaming, no writer, numbers are doubles. Lookups
+// of missing keys or indices return a shared null value, so chains like doc["a"][0]["b"] are safe.
+class JsonValue
+{
+public:
+    enum Type
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type() const { return kind; }
+    bool isNull() const { return kind == Null; }
+    bool isNumber() const { return kind == Number; }
+    bool isString() const { return kind == String; }
+    bool isArray() const { return kind == Array; }
+    bool isObject() const { return kind == Object; }
+
+    // Value of the right type, or the fallback
+    bool asBool(bool fallback = false) const { return kind == Boolean ? boolean : fallback; }
+    double asNumber(double fallback = 0.0) const { return kind == Number ? number : fallback; }
+    const std::string &asString() const;
+
+    // Elements of an array, members of an object, 0 otherwise
+    size_t size() const;
+    const JsonValue &operator[](size_t index) const;
+    const JsonValue &operator[](int index) const { return (*this)[static_cast<size_t>(index)]; } // v[0] is no key
+    const JsonValue &operator[](const char *key) const;
+    bool has(const char *key) const;
+    const std::vector<std::pair<std::string, JsonValue>> &members() const { return objectMembers; }
+
+private:
+    friend class JsonParser;
+
+    Type kind = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> objectMembers; // In document order
+};
+
+// Parse a whole document; on failure `error` says what and where
+bool parseJson(const char *data, size_t size, JsonValue &value, std::string &error);
+
+#endif /* JSON_H */
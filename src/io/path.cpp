@@ -0,0 +1,29 @@
+#include "path.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+std::string normalizePath(const std::string &path)
+{
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    normalized = std::filesystem::path(normalized).lexically_normal().generic_string();
+#ifdef _WIN32
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                   [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+#endif
+    return normalized;
+}
+
+uint64_t hashPath(const std::string &normalizedPath)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : normalizedPath)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
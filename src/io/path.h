@@ -0,0 +1,14 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <cstdint>
+#include <string>
+
+// Resource path in one canonical spelling: forward slashes, "." and ".." resolved, and lowercase
+// on Windows, where paths are case-insensitive. Use it to compare or key paths.
+std::string normalizePath(const std::string &path);
+
+// FNV-1a 64-bit hash of a normalized path, e.g. for cache file names
+uint64_t hashPath(const std::string &normalizedPath);
+
+#endif /* PATH_H */
@@ -0,0 +1,42 @@
+#ifndef RESOURCE_LOADER_H
+#define RESOURCE_LOADER_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <resources.h>
+
+// Bytes of a resource: points straight into the executable when embedded, otherwise at `storage`
+struct ResourceData
+{
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+    bool embedded = false;
+    std::vector<unsigned char> storage;
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+// Resolve a resource path against the embedded table first, then fall back to the filesystem
+inline bool loadResource(const std::string &path, ResourceData &resource)
+{
+    if (const EmbeddedResource *embedded = findEmbeddedResource(path))
+    {
+        resource.data = embedded->data;
+        resource.size = embedded->size;
+        resource.embedded = true;
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    resource.storage.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    resource.data = resource.storage.data();
+    resource.size = resource.storage.size();
+    resource.embedded = false;
+    return true;
+}
+
+#endif /* RESOURCE_LOADER_H */
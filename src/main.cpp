@@ -6,12 +6,16 @@
 #include <spdlog/spdlog.h>
 #include <string>
 #include <thread>
+#include <vector>
+#include <cstring>
 #include <chrono>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/msvc_sink.h>
 #include <algorithm>
+#include <array>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <base64/base64.h>
 
 // Include Tracy header
@@ -24,8 +28,12 @@
 #include "mouse/mouse_position/get_mouse_position.h"
 #include "render/vertex/vertex.h"
 #include "render/text/text_renderer.h"
-#include "render/texture/texture.h"
+#include "render/texture/texture_memory.h"
+#include "render/culling/frustum_culling.h"
+#include "render/state/gl_state.h"
 #include "config.h"
+#include "scene/scene.h"
+#include "scene/simulation.h"
 
 #ifdef min
 #undef min
@@ -33,21 +41,16 @@
 #ifdef max
 #undef max
 #endif
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image/stb_image.h"
 #include "render/setup/setupRenderer.h"
 
 // Global variables
-static glm::vec3 SquarePos(0.0f);
 static glm::vec2 lastMousePos(0.0f);
 static double lastTime = 0.0;
 static int frameCount = 0;
 static double currentFPS = 0.0;
 static TextRenderer *textRenderer = nullptr;
-
-// Start at the plane just in front of the cube
-static glm::vec3 cameraPos = glm::vec3(5.0f, 0.0f, 5.0f);
-static bool cubePOVMode = false; // New flag for cube POV mode
+static glm::mat4 renderedViewProjection(1.0f); // Of the last rendered frame, for picking in the simulation
+static std::unique_ptr<SimulationThread<InputSnapshot, SceneSnapshot>> simulation;
 
 // Error callback
 static void error_callback(int error, const char *description)
@@ -55,52 +58,137 @@ static void error_callback(int error, const char *description)
     fprintf(stderr, "Error: %s\n", description);
 }
 
-// Mouse-cube intersection
-bool isPointInCube(glm::vec2 mousePos, const glm::mat4 &mvp, int width, int height)
+// Entity under the mouse: a ray through the cursor against the BVH, confirmed against the oriented box
+// of each entity whose world box it enters. Returns the entity index, or -1.
+int pickEntity(glm::vec2 mousePos, const glm::mat4 &viewProjection, int width, int height)
 {
     ZoneScoped; // Tracy: Profile this function
-    glm::vec4 screenVertices[8];
-    for (int i = 0; i < 8; i++)
+    glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    float x = mousePos.x / width * 2.0f - 1.0f;
+    float y = 1.0f - mousePos.y / height * 2.0f;
+    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+    float length = glm::length(direction);
+    if (!(length > 0.0f))
+        return -1;
+    direction /= length;
+
+    // In the entity's local space the oriented box is an axis-aligned one around the origin
+    auto hitsOrientedBox = [&](uint32_t index, float &distance)
+    {
+        glm::mat4 model;
+        scene.entities.writeModelMatrices(&model, index, 1);
+        glm::mat4 toLocal = glm::inverse(model);
+        glm::vec3 localOrigin = glm::vec3(toLocal * glm::vec4(origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(toLocal * glm::vec4(direction, 0.0f)); // Same ray parameter
+        glm::vec3 half = scene.entities.colliders()[index].halfExtents;
+        glm::vec3 t0 = (-half - localOrigin) / localDirection;
+        glm::vec3 t1 = (half - localOrigin) / localDirection;
+        glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+        float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+        distance = entry;
+        return entry <= exit;
+    };
+
+    uint32_t object;
+    float distance;
+    if (!scene.bvh.raycast(origin, direction, length, hitsOrientedBox, object, distance))
+        return -1;
+    return static_cast<int>(object);
+}
+
+// World box of one entity after it moved: the culling arrays and a local refit of its BVH leaf
+void refreshEntityBounds(size_t index)
+{
+    updateWorldBoxes(scene.entities, index, 1, entityBoxes);
+    scene.bvh.update(static_cast<uint32_t>(index),
+                     glm::vec3(entityBoxes.centerX[index], entityBoxes.centerY[index], entityBoxes.centerZ[index]),
+                     glm::vec3(entityBoxes.extentX[index], entityBoxes.extentY[index], entityBoxes.extentZ[index]));
+}
+
+// Oriented box vs oriented box on the 15 separating axes. When they overlap, push is the shortest
+// translation that moves entity a out of entity b.
+bool areEntitiesColliding(size_t a, size_t b, glm::vec3 &push)
+{
+    const glm::vec3 *position = scene.entities.positions();
+    const glm::quat *rotation = scene.entities.rotations();
+    const glm::vec3 *scale = scene.entities.scales();
+    const Collider *collider = scene.entities.colliders();
+    glm::mat3 axesA = glm::mat3_cast(rotation[a]), axesB = glm::mat3_cast(rotation[b]);
+    glm::vec3 halfA = scale[a] * collider[a].halfExtents, halfB = scale[b] * collider[b].halfExtents;
+    glm::vec3 offset = position[b] - position[a];
+
+    std::array<glm::vec3, 15> testAxes;
+    for (int i = 0; i < 3; i++)
     {
-        glm::vec4 vertex(vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2], 1.0f);
-        screenVertices[i] = mvp * vertex;
-        screenVertices[i] /= screenVertices[i].w;
-        screenVertices[i].x = (screenVertices[i].x + 1.0f) * width * 0.5f;
-        screenVertices[i].y = (1.0f - screenVertices[i].y) * height * 0.5f;
+        testAxes[i] = axesA[i];
+        testAxes[3 + i] = axesB[i];
+        for (int j = 0; j < 3; j++)
+            testAxes[6 + i * 3 + j] = glm::cross(axesA[i], axesB[j]);
     }
 
-    auto pointInTriangle = [](glm::vec2 p, glm::vec2 v1, glm::vec2 v2, glm::vec2 v3)
+    float smallestOverlap = std::numeric_limits<float>::max();
+    for (glm::vec3 axis : testAxes)
     {
-        float d1 = (p.x - v2.x) * (v1.y - v2.y) - (v1.x - v2.x) * (p.y - v2.y);
-        float d2 = (p.x - v3.x) * (v2.y - v3.y) - (v2.x - v3.x) * (p.y - v3.y);
-        float d3 = (p.x - v1.x) * (v3.y - v1.y) - (v3.x - v1.x) * (p.y - v1.y);
-        bool has_neg = (d1 < 0) || (d2 < 0) || (d3 < 0);
-        bool has_pos = (d1 > 0) || (d2 > 0) || (d3 > 0);
-        return !(has_neg && has_pos);
-    };
+        float length = glm::length(axis);
+        if (length < 1e-4f) // Parallel edges: covered by the face axes
+            continue;
+        axis /= length;
 
-    glm::vec2 screenVertices2D[8];
-    for (int i = 0; i < 8; i++)
+        float radiusA = 0.0f, radiusB = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            radiusA += std::abs(glm::dot(axesA[i], axis)) * halfA[i];
+            radiusB += std::abs(glm::dot(axesB[i], axis)) * halfB[i];
+        }
+        float distance = glm::dot(offset, axis);
+        float overlap = radiusA + radiusB - std::abs(distance);
+        if (overlap <= 0.0f)
+            return false;
+        if (overlap < smallestOverlap)
+        {
+            smallestOverlap = overlap;
+            push = axis * (distance > 0.0f ? -overlap : overlap);
+        }
+    }
+    return true;
+}
+
+// Broadphase through the BVH (entities whose world boxes overlap), then the exact test and push-out.
+// Getting out of one cube can push into its neighbour, so a few passes per step.
+void resolveEntityCollisions(size_t index)
+{
+    ZoneScoped; // Tracy: Profile this function
+    static std::vector<uint32_t> candidates;
+    bool moved = true;
+    for (int pass = 0; pass < 4 && moved; pass++)
     {
-        screenVertices2D[i] = glm::vec2(screenVertices[i].x, screenVertices[i].y);
-    }
-
-    return pointInTriangle(mousePos, screenVertices2D[0], screenVertices2D[1], screenVertices2D[2]) ||
-           pointInTriangle(mousePos, screenVertices2D[2], screenVertices2D[3], screenVertices2D[0]) ||
-           pointInTriangle(mousePos, screenVertices2D[1], screenVertices2D[5], screenVertices2D[6]) ||
-           pointInTriangle(mousePos, screenVertices2D[6], screenVertices2D[2], screenVertices2D[1]) ||
-           pointInTriangle(mousePos, screenVertices2D[5], screenVertices2D[4], screenVertices2D[7]) ||
-           pointInTriangle(mousePos, screenVertices2D[7], screenVertices2D[6], screenVertices2D[5]) ||
-           pointInTriangle(mousePos, screenVertices2D[4], screenVertices2D[0], screenVertices2D[3]) ||
-           pointInTriangle(mousePos, screenVertices2D[3], screenVertices2D[7], screenVertices2D[4]) ||
-           pointInTriangle(mousePos, screenVertices2D[3], screenVertices2D[2], screenVertices2D[6]) ||
-           pointInTriangle(mousePos, screenVertices2D[6], screenVertices2D[7], screenVertices2D[3]) ||
-           pointInTriangle(mousePos, screenVertices2D[0], screenVertices2D[4], screenVertices2D[5]) ||
-           pointInTriangle(mousePos, screenVertices2D[5], screenVertices2D[1], screenVertices2D[0]);
+        refreshEntityBounds(index);
+        glm::vec3 center(entityBoxes.centerX[index], entityBoxes.centerY[index], entityBoxes.centerZ[index]);
+        glm::vec3 extent(entityBoxes.extentX[index], entityBoxes.extentY[index], entityBoxes.extentZ[index]);
+        scene.bvh.queryBox(center - extent, center + extent, candidates);
+
+        moved = false;
+        for (uint32_t other : candidates)
+        {
+            glm::vec3 push;
+            if (other != index && areEntitiesColliding(index, other, push))
+            {
+                scene.entities.positions()[index] += push;
+                moved = true;
+            }
+        }
+    }
+    if (moved)
+        refreshEntityBounds(index);
 }
 
 // Cube-plane collision
-bool isCubeCollidingWithPlane(const glm::mat4 &model, const Vertex *cubeVertices, const Vertex *planeVertices)
+bool isCubeCollidingWithPlane(const glm::mat4 &model, const Vertex *cubeVertices, const Vertex *planeVertices,
+                              bool debugMode)
 {
     ZoneScoped; // Tracy: Profile this function
     std::array<glm::vec3, 8> cubeWorldVertices;
@@ -120,7 +208,7 @@ bool isCubeCollidingWithPlane(const glm::mat4 &model, const Vertex *cubeVertices
         planeWorldVertices[i] = glm::vec3(worldPos.x, worldPos.y, worldPos.z);
     }
 
-    if (mode == debug)
+    if (debugMode)
     {
         // spdlog::info("Plane vertices (world space):");
         // for (int i = 0; i < 4; i++) {
@@ -231,15 +319,17 @@ GLFWwindow *initializeWindow()
     }
 
     glfwSwapInterval(1);
-    glEnable(GL_DEPTH_TEST);
+    glState().enable(GL_DEPTH_TEST);
     return window;
 }
 
-void SimpleGravity(float deltaTime, glm::mat4 &model, const Vertex *vertices, const Vertex *planeVertices)
+void SimpleGravity(float deltaTime, glm::mat4 &model, const Vertex *vertices, const Vertex *planeVertices, bool debugMode)
 {
-    // Gravity and collision
-    SquarePos.y -= 0.1f * static_cast<float>(deltaTime); // Simple gravity
-    if (isCubeCollidingWithPlane(model, vertices, planeVertices))
+    // Gravity and collision; integrate moves every entity through the dense position/velocity arrays
+    scene.entities.velocity(scene.cube).y = -0.1f; // Simple gravity
+    scene.entities.integrate(deltaTime);
+    glm::vec3 &cubePos = scene.entities.position(scene.cube);
+    if (isCubeCollidingWithPlane(model, vertices, planeVertices, debugMode))
     {
         float lowestY = std::numeric_limits<float>::max();
         for (int i = 0; i < 8; i++)
@@ -250,149 +340,181 @@ void SimpleGravity(float deltaTime, glm::mat4 &model, const Vertex *vertices, co
         }
         float planeY = -1.0f;
         if (lowestY < planeY)
-            SquarePos.y += (planeY - lowestY);
+            cubePos.y += (planeY - lowestY);
     }
+
+    // Then the other cubes
+    resolveEntityCollisions(scene.entities.indexOf(scene.cube));
 }
 
-// Handle input and update cube state
-void updateCube(GLFWwindow *window, glm::mat4 &model, glm::mat4 &mvp, int width, int height, float ratio, float deltaTime)
+// Handle input and update cube state: one simulation step, on the simulation thread
+void updateCube(const InputSnapshot &input, glm::mat4 &model, float deltaTime)
 {
     ZoneScoped; // Tracy: Profile this function
+    Camera &camera = scene.camera;
+    glm::vec3 &cubePos = scene.entities.position(scene.cube);
+    camera.cubePOV = input.cubePOV;
+    camera.viewProjection = input.viewProjection;
+    const float ratio = input.width / (float)input.height;
+
+    // Cursor motion since the last step feeds the smoothed mouse delta
+    static glm::dvec2 appliedMouseTravel(0.0);
+    camera.mouseDelta += glm::vec2(input.mouseTravel - appliedMouseTravel);
+    appliedMouseTravel = input.mouseTravel;
+
     // Camera and cube movement
     float baseSpeed = static_cast<float>(deltaTime) * 12.0f; // Base speed of 12 units per second
     float speed = baseSpeed;                                 // Default speed, adjusted for POV mode if needed
 
     glm::vec3 direction;
-    direction.x = cos(glm::radians(rotationAngles.y)) * cos(glm::radians(rotationAngles.x));
-    direction.y = sin(glm::radians(rotationAngles.x)); // Pitch affects vertical look
-    direction.z = sin(glm::radians(rotationAngles.y)) * cos(glm::radians(rotationAngles.x));
+    direction.x = cos(glm::radians(camera.angles.y)) * cos(glm::radians(camera.angles.x));
+    direction.y = sin(glm::radians(camera.angles.x)); // Pitch affects vertical look
+    direction.z = sin(glm::radians(camera.angles.y)) * cos(glm::radians(camera.angles.x));
     direction = glm::normalize(direction);
 
     glm::vec3 right = glm::normalize(glm::cross(direction, glm::vec3(0.0f, 1.0f, 0.0f)));
-    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f); // Ensure up vector is consistent
 
-    if (cubePOVMode)
+    if (camera.cubePOV)
     {
         speed = static_cast<float>(deltaTime) * 3.0f;        // Slower speed in POV mode for precision
-        SquarePos.y = -0.5f;                                 // Keep cube on the plane (plane at y = -1, cube height = 1)
-        cameraPos = SquarePos + glm::vec3(0.0f, 0.5f, 0.0f); // Camera at cube center
+        cubePos.y = -0.5f;                                       // Keep cube on the plane (plane at y = -1, cube height = 1)
+        camera.position = cubePos + glm::vec3(0.0f, 0.5f, 0.0f); // Camera at cube center
     }
 
     // Use WASD for movement in both modes
-    if (pressing_w)
+    if (input.moveForward)
     {
-        if (cubePOVMode)
-            SquarePos += direction * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
+        if (camera.cubePOV)
+            cubePos += direction * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
         else
-            cameraPos += direction * speed;
+            camera.position += direction * speed;
     }
-    if (pressing_s)
+    if (input.moveBackward)
     {
-        if (cubePOVMode)
-            SquarePos -= direction * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
+        if (camera.cubePOV)
+            cubePos -= direction * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
         else
-            cameraPos -= direction * speed;
+            camera.position -= direction * speed;
     }
-    if (pressing_a)
+    if (input.moveLeft)
     {
-        if (cubePOVMode)
-            SquarePos -= right * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
+        if (camera.cubePOV)
+            cubePos -= right * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
         else
-            cameraPos -= right * speed;
+            camera.position -= right * speed;
     }
-    if (pressing_d)
+    if (input.moveRight)
     {
-        if (cubePOVMode)
-            SquarePos += right * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
+        if (camera.cubePOV)
+            cubePos += right * speed * (float)deltaTime * 60.0f; // Speed up in POV mode
         else
-            cameraPos += right * speed;
+            camera.position += right * speed;
     }
 
     // Smooth rotation with mouse
     float rotationSpeed = 1.0f;                                                       // Degrees per second per pixel
-    rotationAngles.y += static_cast<float>(mouseDelta.x) * rotationSpeed * deltaTime; // Yaw
-    rotationAngles.x -= static_cast<float>(mouseDelta.y) * rotationSpeed * deltaTime; // Pitch (inverted)
-    mouseDelta *= 0.9f;
+    camera.angles.y += static_cast<float>(camera.mouseDelta.x) * rotationSpeed * deltaTime; // Yaw
+    camera.angles.x -= static_cast<float>(camera.mouseDelta.y) * rotationSpeed * deltaTime; // Pitch (inverted)
+    camera.mouseDelta *= 0.9f;
 
     // Dampen delta over time (adjustable)
-    if (pressing_up)
-        rotationAngles.x -= rotationSpeed; // Pitch up
-    if (pressing_down)
-        rotationAngles.x += rotationSpeed; // Pitch down
-    if (pressing_left)
-        rotationAngles.y -= rotationSpeed; // Yaw left
-    if (pressing_right)
-        rotationAngles.y += rotationSpeed; // Yaw right
+    if (input.lookUp)
+        camera.angles.x -= rotationSpeed; // Pitch up
+    if (input.lookDown)
+        camera.angles.x += rotationSpeed; // Pitch down
+    if (input.lookLeft)
+        camera.angles.y -= rotationSpeed; // Yaw left
+    if (input.lookRight)
+        camera.angles.y += rotationSpeed; // Yaw right
 
     // Clamp pitch
-    rotationAngles.x = glm::clamp(rotationAngles.x, -89.0f, 89.0f);
+    camera.angles.x = glm::clamp(camera.angles.x, -89.0f, 89.0f);
 
-    if (!cubePOVMode)
+    const int cubeIndex = static_cast<int>(scene.entities.indexOf(scene.cube));
+    const glm::vec2 mousePos = input.mousePosition;
+    if (!camera.cubePOV)
     {
         // Mouse dragging in free mode
-        glm::vec2 mousePos = GetMouse::getMousePosition(window);
-        bool isMouseOverCube = isPointInCube(mousePos, mvp, width, height);
-        if (isDragging && isMouseOverCube)
+        bool isMouseOverCube = pickEntity(mousePos, camera.viewProjection, input.width, input.height) == cubeIndex;
+        if (input.dragging && isMouseOverCube)
         {
             glm::vec2 delta = mousePos - lastMousePos;
-            SquarePos.x += delta.x * 0.002f * static_cast<float>(deltaTime) * 60.0f;
-            SquarePos.z -= delta.y * glm::clamp(0.002f * ratio, 0.002f, 0.01f) * static_cast<float>(deltaTime) * 60.0f;
+            cubePos.x += delta.x * 0.002f * static_cast<float>(deltaTime) * 60.0f;
+            cubePos.z -= delta.y * glm::clamp(0.002f * ratio, 0.002f, 0.01f) * static_cast<float>(deltaTime) * 60.0f;
         }
         lastMousePos = mousePos;
     }
 
     // Mouse dragging in POV mode (optional, can be adjusted or removed)
-    glm::vec2 mousePos = GetMouse::getMousePosition(window);
-    bool isMouseOverCube = isPointInCube(mousePos, mvp, width, height);
-    if (isDragging && isMouseOverCube)
+    bool isMouseOverCube = pickEntity(mousePos, camera.viewProjection, input.width, input.height) == cubeIndex;
+    if (input.dragging && isMouseOverCube)
     {
         glm::vec2 delta = mousePos - lastMousePos;
-        SquarePos.x += delta.x * 0.002f;
-        SquarePos.z -= delta.y * glm::clamp(0.002f * ratio, 0.002f, 0.01f);
-        if (mode == debug)
-            spdlog::info("Cube position: ({}, {}, {})", SquarePos.x, SquarePos.y, SquarePos.z);
+        cubePos.x += delta.x * 0.002f;
+        cubePos.z -= delta.y * glm::clamp(0.002f * ratio, 0.002f, 0.01f);
+        if (input.debugMode)
+            spdlog::info("Cube position: ({}, {}, {})", cubePos.x, cubePos.y, cubePos.z);
     }
     lastMousePos = mousePos;
 
     // Simple gravity and collision
-    SimpleGravity(deltaTime, model, vertices, planeVertices);
+    SimpleGravity(deltaTime, model, vertices, planeVertices, input.debugMode);
 
-    model = glm::translate(glm::mat4(1.0f), SquarePos);
-    model = glm::rotate(model, glm::radians(rotationAngles.x), glm::vec3(1.0f, 0.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotationAngles.y), glm::vec3(0.0f, 1.0f, 0.0f));
-    if (mode == debug)
-    {
-        model = glm::translate(model, glm::mat3(model) * glm::vec3(0.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
-    }
+    // Pitch and yaw follow the camera, plus a spin over time
+    scene.entities.rotation(scene.cube) = glm::angleAxis(glm::radians(camera.angles.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+                                          glm::angleAxis(glm::radians(camera.angles.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                                          glm::angleAxis((float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = scene.entities.modelMatrix(scene.cube);
+    refreshEntityBounds(cubeIndex); // Local refit of its BVH leaf
 
-    if (mode == release)
-    {
-        model = glm::translate(model, glm::mat3(model) * glm::vec3(0.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
-    }
+    // Swap in a background BVH rebuild, or start one once refits have loosened the tree
+    scene.bvh.maintain();
+}
 
-    // invert the camera position for the cube POV mode
-    glm::mat4 view = glm::lookAt(cameraPos, SquarePos, up / 2.0f);
+// The state the renderer needs, copied out after a batch of steps on the simulation thread
+void publishSceneSnapshot(const InputSnapshot &input, const glm::mat4 &model, SceneSnapshot &snapshot)
+{
+    const size_t cubeIndex = scene.entities.indexOf(scene.cube);
+    snapshot.camera = scene.camera;
+    snapshot.cubeIndex = cubeIndex;
+    snapshot.cubePosition = scene.entities.position(scene.cube);
+    snapshot.cubeModel = model;
+    snapshot.cubeBoxCenter = glm::vec3(entityBoxes.centerX[cubeIndex], entityBoxes.centerY[cubeIndex], entityBoxes.centerZ[cubeIndex]);
+    snapshot.cubeBoxExtent = glm::vec3(entityBoxes.extentX[cubeIndex], entityBoxes.extentY[cubeIndex], entityBoxes.extentZ[cubeIndex]);
+    snapshot.cubeOnPlane = isCubeCollidingWithPlane(model, vertices, planeVertices, input.debugMode);
+    snapshot.mouseOverCube = pickEntity(input.mousePosition, input.viewProjection, input.width, input.height) == static_cast<int>(cubeIndex);
+}
 
-    // look in the direction of the cube
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), ratio, 0.1f, 100.0f);
-    mvp = projection * view * model;
+// The window's input for the simulation; the callbacks only ever run on the main thread
+void publishInput(GLFWwindow *window, TripleBuffer<InputSnapshot> &inputs)
+{
+    InputSnapshot &input = inputs.back();
+    input.moveForward = pressing_w;
+    input.moveBackward = pressing_s;
+    input.moveLeft = pressing_a;
+    input.moveRight = pressing_d;
+    input.lookUp = pressing_up;
+    input.lookDown = pressing_down;
+    input.lookLeft = pressing_left;
+    input.lookRight = pressing_right;
+    input.dragging = isDragging;
+    input.cubePOV = cubePOVMode;
+    input.debugMode = mode == debug;
+    input.mousePosition = GetMouse::getMousePosition(window);
+    input.mouseTravel = mouseTravel;
+    glfwGetFramebufferSize(window, &input.width, &input.height);
+    input.viewProjection = renderedViewProjection;
+    inputs.publish();
 }
 
 // Calculate FPS and enforce frame rate
-void updateFrameTiming(double &previousTime, double &deltaTime, double &accumulator)
+void updateFrameTiming(double &previousTime, double &deltaTime)
 {
     ZoneScoped; // Tracy: Profile this function
     double currentTime = glfwGetTime();
     deltaTime = currentTime - previousTime;
     previousTime = currentTime;
 
-    // Cap deltaTime to avoid large jumps (e.g., when window is moved)
-    deltaTime = std::min(deltaTime, 0.1); // Max 100ms per frame
-
-    accumulator += deltaTime;
-
     // FPS calculation
     frameCount++;
     if (currentTime - lastTime >= 1.0)
@@ -403,75 +525,230 @@ void updateFrameTiming(double &previousTime, double &deltaTime, double &accumula
     }
 }
 
+// Upload streams of the recorded command lists
+enum SceneUploadStream
+{
+    InstanceModelStream, // Transforms of the visible instanced cubes
+    IndirectSlotStream,  // Slots of the visible indirect cubes, when culled on the CPU
+    UploadStreamCount
+};
+
+// Render queue callbacks for the cube batches; the queue has bound the scene program and material
+static void drawCubeInstances(const DrawPacket &, void *)
+{
+    glUniform1i(useInstancesLocation, 1);
+    cubeInstances->draw();
+    glUniform1i(useInstancesLocation, 0);
+}
+
+static void drawIndirectCubes(const DrawPacket &, void *)
+{
+    glUniform1i(useInstancesLocation, 2);
+    indirectCubes->draw();
+    glUniform1i(useInstancesLocation, 0);
+}
+
 // Render the scene
-void renderScene(GLFWwindow *window, GLuint program, GLint mvp_location, GLuint vertex_array, GLuint element_buffer, GLuint planeVertexArray, GLuint planeElementBuffer, const glm::mat4 &model, float ratio)
+void renderScene(GLFWwindow *window, GLuint program, GLint model_location, GLuint vertex_array, GLuint planeVertexArray, const SceneSnapshot &snapshot, float ratio)
 {
     ZoneScoped; // Tracy: Profile this function
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glState().enable(GL_DEPTH_TEST); // The text pass at the end leaves it off and blending on
+    glState().disable(GL_BLEND);
+    const Camera &camera = snapshot.camera;
+    const glm::vec3 &cubePos = snapshot.cubePosition;
+    const glm::mat4 &model = snapshot.cubeModel;
 
     // Use camera-based view
     glm::vec3 direction;
-    direction.x = cos(glm::radians(rotationAngles.y)) * cos(glm::radians(rotationAngles.x));
-    direction.y = sin(glm::radians(rotationAngles.x));
-    direction.z = sin(glm::radians(rotationAngles.y)) * cos(glm::radians(rotationAngles.x));
+    direction.x = cos(glm::radians(camera.angles.y)) * cos(glm::radians(camera.angles.x));
+    direction.y = sin(glm::radians(camera.angles.x));
+    direction.z = sin(glm::radians(camera.angles.y)) * cos(glm::radians(camera.angles.x));
     direction = glm::normalize(direction);
-    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);                         // Up vector (assuming plane is horizontal)
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + direction, up); // Adjusted to look in direction
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);                                     // Up vector (assuming plane is horizontal)
+    glm::mat4 view = glm::lookAt(camera.position, camera.position + direction, up); // Adjusted to look in direction
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), ratio, 0.1f, 100.0f);
 
-    glUseProgram(program);
+    glm::mat4 planeModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+
+    // One upload per frame; the shaders apply view and projection to each object's model matrix
+    cameraUniforms->update(view, projection, camera.position);
+
+    // Frustum culling: the draw stage below only sees entities whose world box touches the view.
+    // The BVH rejects and accepts whole subtrees, so the cost follows what is near the view.
+    glm::mat4 viewProjection = projection * view;
+    renderedViewProjection = viewProjection; // For picking in the simulation
+    Frustum frustum = extractFrustum(viewProjection);
+    const bool planeVisible = isBoxVisible(frustum, glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(5.0f, 0.0f, 5.0f));
+    const bool cubeVisible = isBoxVisible(frustum, snapshot.cubeBoxCenter, snapshot.cubeBoxExtent);
+
+    // The compute culling pass binds its own program, so it goes before the scene program
+    if (indirectCubes && useGpuCulling)
+        indirectCubes->cull(frustum);
+
+    // Virtual texture feedback: which ground tiles this view needs (read back a few frames later).
+    // The ground under the cube is hidden, so the cube's position stream goes in first as an occluder.
+    if (groundVirtualTexture)
+    {
+        std::vector<VirtualTexture::Occluder> occluders;
+        if (!camera.cubePOV && cubeVisible && cubeMesh.positionArray)
+            occluders.push_back({model, cubeMesh.positionArray, cubeMesh.indexCount, cubeMesh.indexType});
+        groundVirtualTexture->renderFeedback(planeModel, planeVertexArray, planeMesh.indexCount, planeMesh.indexType,
+                                             width, height, occluders);
+    }
+
+    glState().useProgram(program);
     GLint useTextureLocation = glGetUniformLocation(program, "useTexture");
 
-    // Render plane (with texture)
-    glm::mat4 planeModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
-    glm::mat4 planeMVP = projection * view * planeModel;
-    glUniform1i(useTextureLocation, 1);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, planeTexture);
-    glUniform1i(textureLocation, 0);
-    glUniformMatrix4fv(mvp_location, 1, GL_FALSE, glm::value_ptr(planeMVP));
-    glBindVertexArray(planeVertexArray);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeElementBuffer);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-    // Render cube only if not in cubePOVMode
-    if (!cubePOVMode)
-    {
-        // Render cube (with texture)
-        glm::mat4 cubeMVP = projection * view * model;
-        glUniform1i(useTextureLocation, 1); // Important to enable texture or else it will render as gray or black
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        glUniform1i(textureLocation, 0);
-        glUniformMatrix4fv(mvp_location, 1, GL_FALSE, glm::value_ptr(cubeMVP));
-        glBindVertexArray(vertex_array);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    }
-
-    // Render text
-    glDisable(GL_DEPTH_TEST);
-    bool isColliding = isCubeCollidingWithPlane(model, vertices, planeVertices);
+    // All scene materials live in one array texture: bind once, pick layers per draw
+    glUniform1i(useTextureLocation, 1); // Important to enable texture or else it will render as gray or black
+    materialTextures->bind(0);
+    if (groundTexture && planeMaterial == -1)
+    {
+        textureStreamer->touch(groundTexture);
+        glState().bindTexture(1, GL_TEXTURE_2D, groundTexture->textureID);
+    }
+    if (groundVirtualTexture)
+        groundVirtualTexture->bind(program, 2, 3);
+    if (cubeVideo)
+        cubeVideo->bind(program, 4);
+
+    // The scene's draws go through the render queue, which orders them by program and material and
+    // then front to back. Depth is the distance along the view direction.
+    auto viewDepth = [&](const glm::vec3 &point)
+    { return glm::dot(point - camera.position, direction); };
+    DrawPacket scenePacket;
+    scenePacket.program = program;
+    scenePacket.materialLocation = materialLayerLocation;
+    scenePacket.modelLocation = model_location;
+
+    // The frame is built off the GL thread: each job culls one BVH subtree and records the
+    // transforms (or indirect slots) of its visible cubes into its own command list, and job 0 also
+    // records the single draws. The lists are replayed here once every job is done.
+    cullingBvh.splitSubtrees(commandRecorder->threadCount() * 4, cullSubtrees); // Extra jobs even out the load
+    subtreeVisibleCounts.assign(cullSubtrees.size(), 0);
+    const RenderHandle *render = entityRenderHandles.data();
+    const bool gatherInstances = cubeInstances || (indirectCubes && !useGpuCulling);
+    auto recordJob = [&](size_t job, CommandList &list)
+    {
+        ZoneScopedN("Record commands");
+        if (job == 0)
+        {
+            // Plane (with texture)
+            if (planeVisible)
+            {
+                DrawPacket plane = scenePacket;
+                plane.material = planeMaterial;
+                plane.model = planeModel;
+                plane.vertexArray = planeVertexArray;
+                plane.indexCount = planeMesh.indexCount;
+                plane.indexType = planeMesh.indexType;
+                list.submit(plane, viewDepth(glm::vec3(0.0f, -1.0f, 0.0f)));
+            }
+
+            // Cube only if not in cube POV mode
+            if (!camera.cubePOV && cubeVisible)
+            {
+                DrawPacket cube = scenePacket;
+                cube.material = cubeMaterial;
+                cube.model = model;
+                cube.vertexArray = vertex_array;
+                cube.indexCount = cubeMesh.indexCount;
+                cube.indexType = cubeMesh.indexType;
+                list.submit(cube, viewDepth(cubePos));
+            }
+
+            // Every visible extra cube in one draw: their transforms are packed into the instance buffer,
+            // or one indirect command per visible cube, all submitted by a single multi-draw
+            if (cubeInstances || indirectCubes)
+            {
+                DrawPacket cubes = scenePacket;
+                cubes.material = cubeMaterial;
+                cubes.modelLocation = -1; // Per instance, or from the storage buffer
+                cubes.execute = cubeInstances ? drawCubeInstances : drawIndirectCubes;
+                list.submit(cubes, 0.0f);
+            }
+        }
+        if (job >= cullSubtrees.size())
+            return;
+
+        const Bvh::Subtree &subtree = cullSubtrees[job];
+        uint32_t *visible = visibleEntities.data() + subtree.first;
+        const size_t visibleCount = cullingBvh.cullFrustum(frustum, visible, subtree.node);
+        subtreeVisibleCounts[job] = visibleCount;
+        if (!gatherInstances)
+            return;
+
+        size_t instanceCount = 0;
+        for (size_t i = 0; i < visibleCount; i++)
+            instanceCount += render[visible[i]].instance >= 0;
+        if (cubeInstances)
+        {
+            glm::mat4 *models = static_cast<glm::mat4 *>(list.upload(InstanceModelStream, instanceCount * sizeof(glm::mat4)));
+            for (size_t i = 0; i < visibleCount; i++)
+                if (render[visible[i]].instance >= 0)
+                    *models++ = instanceModels[render[visible[i]].instance];
+        }
+        else
+        {
+            uint32_t *slots = static_cast<uint32_t *>(list.upload(IndirectSlotStream, instanceCount * sizeof(uint32_t)));
+            for (size_t i = 0; i < visibleCount; i++)
+                if (render[visible[i]].instance >= 0)
+                    *slots++ = static_cast<uint32_t>(render[visible[i]].instance);
+        }
+    };
+    size_t visibleCount = 0;
+    {
+        ZoneScopedN("Frustum culling and recording");
+        commandRecorder->record(std::max<size_t>(cullSubtrees.size(), 1), recordJob);
+        for (size_t count : subtreeVisibleCounts)
+            visibleCount += count;
+        char counts[64];
+        int length = snprintf(counts, sizeof(counts), "%zu / %zu visible", visibleCount, entityRenderHandles.size());
+        ZoneText(counts, length);
+        ZoneValue(visibleCount);
+    }
+
+    UploadStream streams[UploadStreamCount];
+    if (cubeInstances)
+    {
+        streams[InstanceModelStream].begin = [](size_t bytes)
+        { cubeInstances->begin(bytes / sizeof(glm::mat4)); };
+        streams[InstanceModelStream].write = [](size_t offset, const void *data, size_t bytes)
+        { cubeInstances->write(offset / sizeof(glm::mat4), static_cast<const glm::mat4 *>(data), bytes / sizeof(glm::mat4)); };
+    }
+    if (indirectCubes && !useGpuCulling)
+    {
+        streams[IndirectSlotStream].write = [](size_t offset, const void *data, size_t bytes)
+        { std::memcpy(reinterpret_cast<unsigned char *>(visibleInstanceSlots.data()) + offset, data, bytes); };
+        streams[IndirectSlotStream].end = [](size_t bytes)
+        { indirectCubes->setVisible(visibleInstanceSlots.data(), bytes / sizeof(uint32_t)); };
+    }
+    commandRecorder->replay(*renderQueue, streams, UploadStreamCount);
+
+    renderQueue->execute();
+
+    // Render text (the text renderer sets its own blend and depth state)
+    bool isColliding = snapshot.cubeOnPlane;
     glm::vec2 mousePos = GetMouse::getMousePosition(window);
-    glm::mat4 cubeMVP = projection * view * model; // For mouse intersection check
-    bool isMouseOverCube = isPointInCube(mousePos, cubeMVP, width, height);
+    bool isMouseOverCube = snapshot.mouseOverCube;
 
     if (renderDebugText)
     {
         char debugText[128];
         char versionText[64];
         std::string retString = fmt::format("Cube position: ({:.2f}, {:.2f}, {:.2f}) [Rotation: ({:.1f}, {:.1f})]",
-                                            SquarePos.x, SquarePos.y, SquarePos.z, rotationAngles.x, rotationAngles.y);
+                                            cubePos.x, cubePos.y, cubePos.z, camera.angles.x, camera.angles.y);
         snprintf(debugText, sizeof(debugText), "%s", retString.c_str());
         textRenderer->renderText(debugText, 10.0f, 10.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
         snprintf(versionText, sizeof(versionText), "%s", glGetString(GL_VERSION));
         textRenderer->renderText(versionText, width - 170.0f, height - 30.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
     }
 
-    if (isMouseOverCube && !cubePOVMode) // Only show if not in POV mode
+    if (isMouseOverCube && !camera.cubePOV) // Only show if not in POV mode
     {
         char cursorText[64];
         snprintf(cursorText, sizeof(cursorText), "Cursor position: (%.2f, %.2f)", mousePos.x, mousePos.y);
@@ -493,34 +770,107 @@ void renderScene(GLFWwindow *window, GLuint program, GLint mvp_location, GLuint
     snprintf(hardwareText, sizeof(hardwareText), "GPU: %s", glGetString(GL_RENDERER));
     textRenderer->renderText(hardwareText, 10.0f, height - 50.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
 
-    glEnable(GL_DEPTH_TEST);
+    char memoryText[64];
+    if (textureMemoryBudget > 0)
+        snprintf(memoryText, sizeof(memoryText), "Textures: %.1f / %.1f MB", textureMemoryUsed() / 1048576.0,
+                 textureMemoryBudget / 1048576.0);
+    else
+        snprintf(memoryText, sizeof(memoryText), "Textures: %.1f MB", textureMemoryUsed() / 1048576.0);
+    textRenderer->renderText(memoryText, 10.0f, height - 70.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
+
+    char cullingText[64];
+    snprintf(cullingText, sizeof(cullingText), "Visible cubes: %zu / %zu", visibleCount, entityRenderHandles.size());
+    textRenderer->renderText(cullingText, 10.0f, height - 90.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
+
+    // Last frame's, since this one is still drawing
+    const GLStateCache::Counts &stateCounts = glState().lastFrame();
+    char stateText[64];
+    snprintf(stateText, sizeof(stateText), "GL state calls: %zu, skipped %zu", stateCounts.totalIssued(),
+             stateCounts.totalElided());
+    textRenderer->renderText(stateText, 10.0f, height - 110.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
+
+    const RenderQueue::Stats &queueStats = renderQueue->lastStats();
+    char queueText[128];
+    snprintf(queueText, sizeof(queueText), "Draws: %zu, %zu program / %zu material changes, recorded on %u threads",
+             queueStats.packets, queueStats.programChanges, queueStats.materialChanges, commandRecorder->threadCount());
+    textRenderer->renderText(queueText, 10.0f, height - 130.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
+
+    char simulationText[64];
+    snprintf(simulationText, sizeof(simulationText), "Simulation step: %.2f ms (%llu steps)",
+             simulation->stepMilliseconds(), static_cast<unsigned long long>(simulation->stepCount()));
+    textRenderer->renderText(simulationText, 10.0f, height - 150.0f, 0.5f, glm::vec3(1.0f, 1.0f, 1.0f));
 }
 
 // Cleanup resources
-void cleanup(GLuint program, GLuint vertex_array, GLuint vertex_buffer, GLuint element_buffer,
-             GLuint planeVertexArray, GLuint planeVertexBuffer, GLuint planeElementBuffer)
+void cleanup(GLuint program)
 {
     ZoneScoped; // Tracy: Profile this function
-    glDeleteTextures(1, &planeTexture);
-    glDeleteTextures(1, &cubeTexture); // Delete cube texture
-    glDeleteVertexArrays(1, &vertex_array);
-    glDeleteBuffers(1, &vertex_buffer);
-    glDeleteBuffers(1, &element_buffer);
-    glDeleteVertexArrays(1, &planeVertexArray);
-    glDeleteBuffers(1, &planeVertexBuffer);
-    glDeleteBuffers(1, &planeElementBuffer);
-    glDeleteProgram(program);
+    simulation.reset(); // Stops stepping before anything it uses goes away
+    textureReloader.reset(); // Its callbacks reference the textures below
+    reloadTargets.clear();
+    meshImporter.reset();    // Finishes the import in flight, if any
+    screenshotCapture.reset(); // Writes out captures still in flight
+    groundVirtualTexture.reset();
+    cubeVideo.reset();
+    cubeInstances.reset();
+    indirectCubes.reset();
+    cameraUniforms.reset();
+    renderQueue.reset();
+    commandRecorder.reset();
+    groundTexture.reset();
+    textureStreamer.reset();
+    materialTextures.reset();
+    destroyMesh(cubeMesh);
+    destroyMesh(planeMesh);
+    destroyMesh(importedMesh);
+    glState().deleteProgram(program);
     delete textRenderer;
     glfwTerminate();
 }
 
+// Consume "--option value" flags and return the positional arguments (target FPS, mode)
+static std::vector<std::string> parseArguments(int argc, char *argv[])
+{
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--vt" && i + 1 < argc)
+            virtualTexturePath = argv[++i];
+        else if (arg == "--watch" && i + 1 < argc)
+            resourceWatchDirectory = argv[++i];
+        else if (arg == "--video" && i + 1 < argc)
+            videoPath = argv[++i];
+        else if (arg == "--video-size" && i + 1 < argc)
+            std::sscanf(argv[++i], "%dx%d", &videoRawWidth, &videoRawHeight);
+        else if (arg == "--cubes" && i + 1 < argc)
+            cubeCount = std::max(std::atoi(argv[++i]), 0);
+        else if (arg == "--mesh" && i + 1 < argc)
+            meshPath = argv[++i];
+        else if (arg == "--mdi")
+            useIndirectDraw = true;
+        else if (arg == "--gpu-culling")
+            useIndirectDraw = useGpuCulling = true;
+        else if (arg == "--record-threads" && i + 1 < argc)
+            recordThreads = std::max(std::atoi(argv[++i]), 0);
+        else if (arg == "--texture-budget" && i + 1 < argc)
+            textureMemoryBudget = static_cast<size_t>(std::max(std::atof(argv[++i]), 0.0) * 1024 * 1024);
+        else if (arg.rfind("--", 0) == 0)
+            spdlog::warn("Unknown option: {}", arg);
+        else
+            positional.push_back(arg);
+    }
+    return positional;
+}
+
 // Main function
 int main(int argc, char *argv[])
 {
     ZoneScoped; // Tracy: Profile the main function
-    if (argc > 1)
+    std::vector<std::string> args = parseArguments(argc, argv);
+    if (args.size() > 0)
     {
-        targetFPS = std::atoi(argv[1]);
+        targetFPS = std::atoi(args[0].c_str());
         if (targetFPS <= 0)
         {
             spdlog::warn("Invalid FPS value provided. Using default: 144");
@@ -530,9 +880,9 @@ int main(int argc, char *argv[])
         targetFrameTime = 1.0 / targetFPS;
     }
 
-    if (argc > 2)
+    if (args.size() > 1)
     {
-        if (std::string(argv[2]) == "debug" ? mode = debug : mode = release)
+        if (args[1] == "debug" ? mode = debug : mode = release)
             spdlog::info("Mode: {}", mode);
         if (mode == release)
         {
@@ -541,17 +891,18 @@ int main(int argc, char *argv[])
     }
 
     // Set initial rotation to look downward at the plane
-    rotationAngles.x = 45.0f; // Pitch down 45 degrees to see the plane
-    rotationAngles.y = 0.0f;  // Yaw straight ahead
+    scene.camera.angles.x = 45.0f; // Pitch down 45 degrees to see the plane
+    scene.camera.angles.y = 0.0f;  // Yaw straight ahead
+
+    // The draggable cube is the first entity; --cubes adds the rest in setupRendering
+    scene.entities.reserve(1 + cubeCount);
+    scene.cube = scene.entities.create(glm::vec3(0.0f));
 
     GLFWwindow *window = initializeWindow();
 
-    GLuint program, vertex_array, vertex_buffer, element_buffer;
-    GLuint planeVertexArray, planeVertexBuffer, planeElementBuffer;
-    GLint mvp_location, vpos_location, vcol_location;
-    setupRendering(program, mvp_location, vpos_location, vcol_location,
-                   vertex_array, vertex_buffer, element_buffer,
-                   planeVertexArray, planeVertexBuffer, planeElementBuffer);
+    GLuint program, vertex_array, planeVertexArray;
+    GLint model_location, vpos_location, vcol_location;
+    setupRendering(program, model_location, vpos_location, vcol_location, vertex_array, planeVertexArray);
 
     try
     {
@@ -559,46 +910,74 @@ int main(int argc, char *argv[])
     }
     catch (const std::exception &)
     {
-        cleanup(program, vertex_array, vertex_buffer, element_buffer,
-                planeVertexArray, planeVertexBuffer, planeElementBuffer);
+        cleanup(program);
         return -1;
     }
 
-    double previousTime = glfwGetTime();
-    glm::mat4 model;
-    double accumulator = 0.0;
-    const double fixedDeltaTime = 1.0 / 60.0; // Fixed 60 Hz update rate for physics/movement
+    // From here on the scene belongs to the simulation thread; this thread renders its snapshots
+    glm::mat4 model = scene.entities.modelMatrix(scene.cube); // Of the simulation
+    const double fixedDeltaTime = 1.0 / 60.0;                 // Fixed 60 Hz update rate for physics/movement
+    simulation = std::make_unique<SimulationThread<InputSnapshot, SceneSnapshot>>(
+        fixedDeltaTime,
+        [&model](const InputSnapshot &input, float deltaTime)
+        { updateCube(input, model, deltaTime); },
+        [&model](const InputSnapshot &input, SceneSnapshot &snapshot)
+        { publishSceneSnapshot(input, model, snapshot); });
+    publishInput(window, simulation->input());
+    simulation->start();
 
+    double previousTime = glfwGetTime();
     while (!glfwWindowShouldClose(window))
     {
         ZoneScoped; // Tracy: Profile the main loop iteration
         double deltaTime;
 
-        updateFrameTiming(previousTime, deltaTime, accumulator);
+        updateFrameTiming(previousTime, deltaTime);
 
         int width, height;
         glfwGetFramebufferSize(window, &width, &height);
         float ratio = width / (float)height;
 
-        glm::mat4 mvp;
-
-        // Process updates in fixed steps
-        while (accumulator >= fixedDeltaTime)
+        // Latest state of the simulation; the culling BVH follows the cube
+        TripleBuffer<SceneSnapshot> &snapshots = simulation->output();
+        if (snapshots.acquire())
         {
-            updateCube(window, model, mvp, width, height, ratio, (float)fixedDeltaTime);
-            accumulator -= fixedDeltaTime;
+            const SceneSnapshot &latest = snapshots.front();
+            cullingBvh.update(static_cast<uint32_t>(latest.cubeIndex), latest.cubeBoxCenter, latest.cubeBoxExtent);
         }
-
-        renderScene(window, program, mvp_location, vertex_array, element_buffer,
-                    planeVertexArray, planeElementBuffer, model, ratio);
+        cullingBvh.maintain();
+
+        // Upload whatever texture levels the streaming worker finished since last frame
+        textureStreamer->update();
+        if (groundVirtualTexture)
+            groundVirtualTexture->update();
+        if (cubeVideo)
+            cubeVideo->update(glfwGetTime());
+        textureReloader->update();
+        if (meshImporter)
+            meshImporter->update();
+
+        renderScene(window, program, model_location, vertex_array, planeVertexArray, snapshots.front(), ratio);
+
+        // Read back the finished frame before the swap; the PNG is written a few frames later
+        if (screenshotRequested)
+        {
+            screenshotCapture->request();
+            screenshotRequested = false;
+        }
+        screenshotCapture->update(width, height);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        publishInput(window, simulation->input());
+
+        glState().endFrame();
+        TracyPlot("GL state calls", static_cast<int64_t>(glState().lastFrame().totalIssued()));
+        TracyPlot("GL state calls skipped", static_cast<int64_t>(glState().lastFrame().totalElided()));
 
         FrameMark; // Tracy: Mark the end of a frame
     }
 
-    cleanup(program, vertex_array, vertex_buffer, element_buffer,
-            planeVertexArray, planeVertexBuffer, planeElementBuffer);
+    cleanup(program);
     return 0;
 }
\ No newline at end of file
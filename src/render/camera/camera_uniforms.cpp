@@ -0,0 +1,45 @@
+#include "camera_uniforms.h"
+
+#include "../state/gl_state.h"
+
+static const char *cameraBlockText =
+    "layout(std140) uniform Camera\n"
+    "{\n"
+    "    mat4 view;\n"
+    "    mat4 projection;\n"
+    "    mat4 viewProjection;\n"
+    "    vec4 cameraPosition; // w unused\n"
+    "};\n";
+
+CameraUniforms::CameraUniforms()
+{
+    glGenBuffers(1, &buffer);
+    glState().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+    glState().bindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+}
+
+CameraUniforms::~CameraUniforms()
+{
+    glState().deleteBuffers(1, &buffer);
+}
+
+void CameraUniforms::update(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &position)
+{
+    Block block{view, projection, projection * view, glm::vec4(position, 1.0f)};
+    glState().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+    glState().bindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+}
+
+void CameraUniforms::bindProgram(GLuint program)
+{
+    GLuint index = glGetUniformBlockIndex(program, "Camera");
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, bindingPoint);
+}
+
+const char *CameraUniforms::shaderSource()
+{
+    return cameraBlockText;
+}
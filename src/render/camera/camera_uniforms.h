@@ -0,0 +1,43 @@
+#ifndef CAMERA_UNIFORMS_H
+#define CAMERA_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Per-frame camera data in one std140 uniform buffer. Every scene program declares the block from
+// shaderSource() and reads it from the same binding point, so the camera is uploaded once per frame
+// and objects only send their model matrix.
+class CameraUniforms
+{
+public:
+    static const GLuint bindingPoint = 0;
+
+    CameraUniforms();
+    ~CameraUniforms();
+    CameraUniforms(const CameraUniforms &) = delete;
+    CameraUniforms &operator=(const CameraUniforms &) = delete;
+
+    // Upload this frame's camera and bind the buffer to bindingPoint
+    void update(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &position);
+
+    // Point a linked program's Camera block at bindingPoint (programs without the block are skipped)
+    static void bindProgram(GLuint program);
+
+    // GLSL declaring the Camera block (view, projection, viewProjection, cameraPosition); paste it
+    // after the version line of any shader that needs the camera
+    static const char *shaderSource();
+
+private:
+    // Mirrors the std140 block: three mat4s and a vec3 padded to a vec4
+    struct Block
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 position;
+    };
+
+    GLuint buffer = 0;
+};
+
+#endif /* CAMERA_UNIFORMS_H */
@@ -0,0 +1,262 @@
+#include "frustum_culling.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CULL_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CULL_SSE2 1
+#endif
+
+void BoxArrays::resize(size_t count)
+{
+    centerX.resize(count);
+    centerY.resize(count);
+    centerZ.resize(count);
+    extentX.resize(count);
+    extentY.resize(count);
+    extentZ.resize(count);
+}
+
+Frustum extractFrustum(const glm::mat4 &viewProjection)
+{
+    // glm is column major: row r of the matrix is (m[0][r], m[1][r], m[2][r], m[3][r])
+    auto row = [&viewProjection](int r)
+    { return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]); };
+
+    Frustum frustum;
+    frustum.planes[0] = row(3) + row(0); // Left
+    frustum.planes[1] = row(3) - row(0); // Right
+    frustum.planes[2] = row(3) + row(1); // Bottom
+    frustum.planes[3] = row(3) - row(1); // Top
+    frustum.planes[4] = row(3) + row(2); // Near
+    frustum.planes[5] = row(3) - row(2); // Far
+    for (glm::vec4 &plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+void updateWorldBoxes(const EntityStore &entities, size_t first, size_t count, BoxArrays &boxes)
+{
+    if (boxes.size() < entities.size())
+        boxes.resize(entities.size());
+
+    const glm::vec3 *position = entities.positions();
+    const glm::quat *rotation = entities.rotations();
+    const glm::vec3 *scale = entities.scales();
+    const Collider *collider = entities.colliders();
+    for (size_t i = first; i < first + count; i++)
+    {
+        // Extent of a rotated box along each world axis: |R| * (scale * halfExtents)
+        glm::mat3 r = glm::mat3_cast(rotation[i]);
+        glm::vec3 half = scale[i] * collider[i].halfExtents;
+        glm::vec3 extent = glm::abs(r[0]) * half.x + glm::abs(r[1]) * half.y + glm::abs(r[2]) * half.z;
+        boxes.centerX[i] = position[i].x;
+        boxes.centerY[i] = position[i].y;
+        boxes.centerZ[i] = position[i].z;
+        boxes.extentX[i] = extent.x;
+        boxes.extentY[i] = extent.y;
+        boxes.extentZ[i] = extent.z;
+    }
+}
+
+#if defined(CULL_AVX2)
+// For every 8-bit lane mask: the set lanes' indices packed to the front (3 bits each) and their count
+// in the top byte, so compaction is one permute and one unaligned store
+struct CompactTable
+{
+    uint32_t entries[256];
+
+    CompactTable()
+    {
+        for (uint32_t mask = 0; mask < 256; mask++)
+        {
+            uint32_t packed = 0, count = 0;
+            for (uint32_t lane = 0; lane < 8; lane++)
+                if (mask & (1u << lane))
+                    packed |= lane << (3 * count++);
+            entries[mask] = packed | (count << 24);
+        }
+    }
+};
+static const CompactTable compactTable;
+
+// Append base + lane for the set lanes of mask. Writes eight entries, which stay inside the output as
+// long as fewer than base entries were appended before.
+static inline size_t appendVisible8(int mask, uint32_t base, uint32_t *visible, size_t count)
+{
+    const uint32_t entry = compactTable.entries[mask];
+    const __m256i lanes = _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(entry)), _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21));
+    const __m256i indices = _mm256_add_epi32(_mm256_and_si256(lanes, _mm256_set1_epi32(7)), _mm256_set1_epi32(static_cast<int>(base)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(visible + count), indices);
+    return count + (entry >> 24);
+}
+
+// d + r for one plane, fused when the compiler may use FMA (ENABLE_AVX2 turns it on)
+static inline __m256 planeDistance8(__m256 nx, __m256 ny, __m256 nz, __m256 w, __m256 ax, __m256 ay, __m256 az,
+                                    __m256 x, __m256 y, __m256 z, __m256 sx, __m256 sy, __m256 sz)
+{
+#if defined(__FMA__)
+    __m256 d = _mm256_fmadd_ps(nx, x, _mm256_fmadd_ps(ny, y, _mm256_fmadd_ps(nz, z, w)));
+    return _mm256_fmadd_ps(ax, sx, _mm256_fmadd_ps(ay, sy, _mm256_fmadd_ps(az, sz, d)));
+#else
+    __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, x), _mm256_mul_ps(ny, y)), _mm256_add_ps(_mm256_mul_ps(nz, z), w));
+    __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, sx), _mm256_mul_ps(ay, sy)), _mm256_mul_ps(az, sz));
+    return _mm256_add_ps(d, r);
+#endif
+}
+#endif
+
+// Append base + b for every set bit b of mask without branching: each index is written, and the
+// count only advances past the visible ones
+static inline size_t appendVisible(int mask, int lanes, uint32_t base, uint32_t *visible, size_t count)
+{
+    for (int b = 0; b < lanes; b++)
+    {
+        visible[count] = base + b;
+        count += (mask >> b) & 1;
+    }
+    return count;
+}
+
+size_t cullBoxes(const Frustum &frustum, const BoxArrays &boxes, uint32_t *visible)
+{
+    const size_t count = boxes.size();
+    const float *cx = boxes.centerX.data(), *cy = boxes.centerY.data(), *cz = boxes.centerZ.data();
+    const float *ex = boxes.extentX.data(), *ey = boxes.extentY.data(), *ez = boxes.extentZ.data();
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+    // A box is outside when, for some plane, even its corner furthest along the normal is behind it:
+    // dot(n, center) + w + dot(|n|, extent) < 0
+#if defined(CULL_AVX2)
+    __m256 nx8[6], ny8[6], nz8[6], w8[6], ax8[6], ay8[6], az8[6];
+    for (int p = 0; p < 6; p++)
+    {
+        const glm::vec4 &plane = frustum.planes[p];
+        nx8[p] = _mm256_set1_ps(plane.x);
+        ny8[p] = _mm256_set1_ps(plane.y);
+        nz8[p] = _mm256_set1_ps(plane.z);
+        w8[p] = _mm256_set1_ps(plane.w);
+        ax8[p] = _mm256_set1_ps(std::fabs(plane.x));
+        ay8[p] = _mm256_set1_ps(std::fabs(plane.y));
+        az8[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+    const __m256 zero8 = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+        const __m256 sx = _mm256_loadu_ps(ex + i), sy = _mm256_loadu_ps(ey + i), sz = _mm256_loadu_ps(ez + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = planeDistance8(nx8[p], ny8[p], nz8[p], w8[p], ax8[p], ay8[p], az8[p], x, y, z, sx, sy, sz);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero8, _CMP_GE_OQ));
+            // Neighbouring objects tend to leave through the same side plane; stop once all eight have
+            if (p == 1 && _mm256_movemask_ps(inside) == 0)
+                break;
+        }
+        visibleCount = appendVisible8(_mm256_movemask_ps(inside), static_cast<uint32_t>(i), visible, visibleCount);
+    }
+#endif
+#if defined(CULL_SSE2)
+    __m128 nx4[6], ny4[6], nz4[6], w4[6], ax4[6], ay4[6], az4[6];
+    for (int p = 0; p < 6; p++)
+    {
+        const glm::vec4 &plane = frustum.planes[p];
+        nx4[p] = _mm_set1_ps(plane.x);
+        ny4[p] = _mm_set1_ps(plane.y);
+        nz4[p] = _mm_set1_ps(plane.z);
+        w4[p] = _mm_set1_ps(plane.w);
+        ax4[p] = _mm_set1_ps(std::fabs(plane.x));
+        ay4[p] = _mm_set1_ps(std::fabs(plane.y));
+        az4[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+    const __m128 zero4 = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+        const __m128 sx = _mm_loadu_ps(ex + i), sy = _mm_loadu_ps(ey + i), sz = _mm_loadu_ps(ez + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx4[p], x), _mm_mul_ps(ny4[p], y)),
+                                  _mm_add_ps(_mm_mul_ps(nz4[p], z), w4[p]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax4[p], sx), _mm_mul_ps(ay4[p], sy)), _mm_mul_ps(az4[p], sz));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero4));
+            if (p == 1 && _mm_movemask_ps(inside) == 0)
+                break;
+        }
+        visibleCount = appendVisible(_mm_movemask_ps(inside), 4, static_cast<uint32_t>(i), visible, visibleCount);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (isBoxVisible(frustum, glm::vec3(cx[i], cy[i], cz[i]), glm::vec3(ex[i], ey[i], ez[i])))
+            visible[visibleCount++] = static_cast<uint32_t>(i);
+    }
+    return visibleCount;
+}
+
+size_t cullSpheres(const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ,
+                   const float *radius, size_t count, uint32_t *visible)
+{
+    size_t visibleCount = 0;
+    size_t i = 0;
+#if defined(CULL_AVX2)
+    const __m256 zero8 = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(centerX + i), y = _mm256_loadu_ps(centerY + i);
+        const __m256 z = _mm256_loadu_ps(centerZ + i), r = _mm256_loadu_ps(radius + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), x),
+                                                   _mm256_mul_ps(_mm256_set1_ps(plane.y), y)),
+                                     _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), z), _mm256_set1_ps(plane.w)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero8, _CMP_GE_OQ));
+        }
+        visibleCount = appendVisible8(_mm256_movemask_ps(inside), static_cast<uint32_t>(i), visible, visibleCount);
+    }
+#endif
+#if defined(CULL_SSE2)
+    const __m128 zero4 = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(centerX + i), y = _mm_loadu_ps(centerY + i);
+        const __m128 z = _mm_loadu_ps(centerZ + i), r = _mm_loadu_ps(radius + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), z), _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero4));
+        }
+        visibleCount = appendVisible(_mm_movemask_ps(inside), 4, static_cast<uint32_t>(i), visible, visibleCount);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        bool inside = true;
+        for (const glm::vec4 &plane : frustum.planes)
+            inside = inside && plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w + radius[i] >= 0.0f;
+        if (inside)
+            visible[visibleCount++] = static_cast<uint32_t>(i);
+    }
+    return visibleCount;
+}
+
+bool isBoxVisible(const Frustum &frustum, const glm::vec3 &center, const glm::vec3 &extent)
+{
+    for (const glm::vec4 &plane : frustum.planes)
+    {
+        glm::vec3 normal(plane);
+        if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent) < 0.0f)
+            return false;
+    }
+    return true;
+}
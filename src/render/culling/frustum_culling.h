@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../../scene/entity_store.h"
+
+// Six planes (left, right, bottom, top, near, far) as (normal, distance), normalized so that a
+// point p is inside a plane when dot(normal, p) + distance >= 0
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+// World-space axis-aligned boxes as structure of arrays, so eight boxes load into one AVX2 register
+// per coordinate. Index i matches entity index i of the store they were computed from.
+struct BoxArrays
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ; // Half sizes
+
+    size_t size() const { return centerX.size(); }
+    void resize(size_t count);
+};
+
+// Planes of the clip volume of projection * view (Gribb / Hartmann)
+Frustum extractFrustum(const glm::mat4 &viewProjection);
+
+// World boxes of entities [first, first + count) from their position, rotation, scale and collider;
+// boxes grows to entities.size()
+void updateWorldBoxes(const EntityStore &entities, size_t first, size_t count, BoxArrays &boxes);
+
+// Indices of the boxes touching the frustum, in ascending order; visible needs room for boxes.size().
+// Eight boxes per step with AVX2, four with SSE2. Returns the visible count.
+size_t cullBoxes(const Frustum &frustum, const BoxArrays &boxes, uint32_t *visible);
+
+// Same for spheres: centers and radii as arrays of count
+size_t cullSpheres(const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ,
+                   const float *radius, size_t count, uint32_t *visible);
+
+// One box, for things that are not in the arrays
+bool isBoxVisible(const Frustum &frustum, const glm::vec3 &center, const glm::vec3 &extent);
+
+#endif /* FRUSTUM_CULLING_H */
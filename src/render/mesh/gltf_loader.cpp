@@ -0,0 +1,479 @@
+#include "gltf_loader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../../io/json.h"
+#include "../../io/mapped_file.h"
+
+static const uint32_t glbMagic = 0x46546C67; // "glTF"
+static const uint32_t glbJsonChunk = 0x4E4F534A;
+static const uint32_t glbBinaryChunk = 0x004E4942;
+static const int maxNodeDepth = 64; // Node graphs must be trees; this also stops cycles
+
+enum GltfComponentType
+{
+    GltfByte = 5120,
+    GltfUnsignedByte = 5121,
+    GltfShort = 5122,
+    GltfUnsignedShort = 5123,
+    GltfUnsignedInt = 5125,
+    GltfFloat = 5126
+};
+
+static size_t componentSize(int componentType)
+{
+    switch (componentType)
+    {
+    case GltfByte:
+    case GltfUnsignedByte:
+        return 1;
+    case GltfShort:
+    case GltfUnsignedShort:
+        return 2;
+    case GltfUnsignedInt:
+    case GltfFloat:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// Array index or count held by a JSON value; `fallback` if it is missing or not a valid one
+static size_t toIndex(const JsonValue &value, size_t fallback = ~size_t(0))
+{
+    const double number = value.asNumber(-1.0);
+    return number >= 0.0 && number < 9007199254740992.0 ? static_cast<size_t>(number) : fallback;
+}
+
+template <typename T>
+static T readUnaligned(const unsigned char *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+static float readComponent(const unsigned char *data, int componentType, bool normalized)
+{
+    switch (componentType)
+    {
+    case GltfByte:
+    {
+        float value = readUnaligned<int8_t>(data);
+        return normalized ? std::max(value / 127.0f, -1.0f) : value;
+    }
+    case GltfUnsignedByte:
+    {
+        float value = readUnaligned<uint8_t>(data);
+        return normalized ? value / 255.0f : value;
+    }
+    case GltfShort:
+    {
+        float value = readUnaligned<int16_t>(data);
+        return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+    }
+    case GltfUnsignedShort:
+    {
+        float value = readUnaligned<uint16_t>(data);
+        return normalized ? value / 65535.0f : value;
+    }
+    case GltfUnsignedInt:
+        return static_cast<float>(readUnaligned<uint32_t>(data));
+    default:
+        return readUnaligned<float>(data);
+    }
+}
+
+static int base64Value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+' || c == '-')
+        return 62;
+    if (c == '/' || c == '_')
+        return 63;
+    return -1;
+}
+
+static bool decodeBase64(const std::string &text, size_t begin, std::vector<unsigned char> &out)
+{
+    out.clear();
+    out.reserve((text.size() - begin) / 4 * 3);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (size_t i = begin; i < text.size() && text[i] != '='; i++)
+    {
+        int value = base64Value(text[i]);
+        if (value < 0)
+            return false;
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            out.push_back(static_cast<unsigned char>(bits >> bitCount));
+        }
+    }
+    return true;
+}
+
+// Relative buffer URIs may be percent-encoded
+static std::string decodeUri(const std::string &uri)
+{
+    std::string decoded;
+    for (size_t i = 0; i < uri.size(); i++)
+    {
+        if (uri[i] == '%' && i + 2 < uri.size())
+        {
+            decoded += static_cast<char>(std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        }
+        else
+            decoded += uri[i];
+    }
+    return decoded;
+}
+
+// One load: the document, the storage behind its buffers and the mesh being filled
+class GltfReader
+{
+public:
+    GltfReader(const std::string &path, MeshData &mesh) : path(path), mesh(mesh) {}
+
+    bool load()
+    {
+        if (!file.open(path))
+            return fail("cannot open the file");
+        if (!parseContainer() || !resolveBuffers())
+            return false;
+
+        const JsonValue &scenes = json["scenes"];
+        if (scenes.size() > 0)
+        {
+            const JsonValue &nodes = scenes[toIndex(json["scene"], 0)]["nodes"];
+            for (size_t i = 0; i < nodes.size(); i++)
+                if (!appendNode(toIndex(nodes[i]), glm::mat4(1.0f), 0))
+                    return false;
+        }
+        else
+        {
+            // No scene: the meshes as they are
+            for (size_t i = 0; i < json["meshes"].size(); i++)
+                if (!appendMesh(i, glm::mat4(1.0f)))
+                    return false;
+        }
+        if (mesh.indices.empty())
+            return fail("no triangles");
+        return true;
+    }
+
+private:
+    struct Buffer
+    {
+        const unsigned char *data = nullptr;
+        size_t size = 0;
+    };
+
+    bool fail(const std::string &reason)
+    {
+        spdlog::error("Mesh {}: {}", path, reason);
+        return false;
+    }
+
+    // .glb: 12-byte header, a JSON chunk and optionally a binary chunk. Anything else is .gltf text.
+    bool parseContainer()
+    {
+        const unsigned char *data = file.data();
+        const size_t size = file.size();
+        const char *jsonText = reinterpret_cast<const char *>(data);
+        size_t jsonSize = size;
+        if (size >= 12 && readUnaligned<uint32_t>(data) == glbMagic)
+        {
+            if (readUnaligned<uint32_t>(data + 4) != 2)
+                return fail("unsupported GLB version");
+            const size_t length = std::min<size_t>(readUnaligned<uint32_t>(data + 8), size);
+            jsonSize = 0;
+            for (size_t offset = 12; offset + 8 <= length;)
+            {
+                const size_t chunkSize = readUnaligned<uint32_t>(data + offset);
+                const uint32_t chunkType = readUnaligned<uint32_t>(data + offset + 4);
+                if (chunkSize > length - offset - 8)
+                    return fail("truncated GLB chunk");
+                if (chunkType == glbJsonChunk && jsonSize == 0)
+                {
+                    jsonText = reinterpret_cast<const char *>(data + offset + 8);
+                    jsonSize = chunkSize;
+                }
+                else if (chunkType == glbBinaryChunk && !binaryChunk.data)
+                    binaryChunk = {data + offset + 8, chunkSize};
+                offset += 8 + (chunkSize + 3) / 4 * 4;
+            }
+            if (jsonSize == 0)
+                return fail("GLB without a JSON chunk");
+        }
+
+        if (jsonSize >= 3 && std::memcmp(jsonText, "\xEF\xBB\xBF", 3) == 0)
+        {
+            jsonText += 3; // UTF-8 byte order mark
+            jsonSize -= 3;
+        }
+        std::string error;
+        if (!parseJson(jsonText, jsonSize, json, error))
+            return fail("invalid JSON: " + error);
+        return true;
+    }
+
+    bool resolveBuffers()
+    {
+        const JsonValue &bufferList = json["buffers"];
+        buffers.resize(bufferList.size());
+        decoded.resize(bufferList.size());
+        externalFiles.resize(bufferList.size());
+        const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        for (size_t i = 0; i < bufferList.size(); i++)
+        {
+            const JsonValue &buffer = bufferList[i];
+            const std::string &uri = buffer["uri"].asString();
+            if (!buffer.has("uri"))
+            {
+                // The GLB binary chunk; it may be padded past byteLength
+                if (i != 0 || !binaryChunk.data)
+                    return fail("buffer " + std::to_string(i) + " has no data");
+                buffers[i] = binaryChunk;
+            }
+            else if (uri.compare(0, 5, "data:") == 0)
+            {
+                size_t comma = uri.find(";base64,");
+                if (comma == std::string::npos || !decodeBase64(uri, comma + 8, decoded[i]))
+                    return fail("buffer " + std::to_string(i) + " has an unsupported data URI");
+                buffers[i] = {decoded[i].data(), decoded[i].size()};
+            }
+            else
+            {
+                if (!externalFiles[i].open((directory / decodeUri(uri)).string()))
+                    return fail("cannot open buffer " + uri);
+                buffers[i] = {externalFiles[i].data(), externalFiles[i].size()};
+            }
+            if (buffer["byteLength"].asNumber(0) > static_cast<double>(buffers[i].size))
+                return fail("buffer " + std::to_string(i) + " is shorter than its byteLength");
+        }
+        return true;
+    }
+
+    // Start and stride of an accessor's elements, after checking they all lie inside its buffer
+    bool locateAccessor(const JsonValue &accessor, size_t elementSize, const unsigned char *&start, size_t &stride)
+    {
+        const size_t count = toIndex(accessor["count"], 0);
+        const JsonValue &view = json["bufferViews"][toIndex(accessor["bufferView"])];
+        const size_t bufferIndex = toIndex(view["buffer"]);
+        if (!view.isObject() || bufferIndex >= buffers.size())
+            return fail("accessor with an invalid buffer view");
+        const Buffer &buffer = buffers[bufferIndex];
+        const size_t viewOffset = toIndex(view["byteOffset"], 0);
+        const size_t viewLength = toIndex(view["byteLength"], 0);
+        const size_t offset = toIndex(accessor["byteOffset"], 0);
+        stride = toIndex(view["byteStride"], 0);
+        if (stride == 0)
+            stride = elementSize;
+        if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset || count > viewLength ||
+            (count > 0 && offset + stride * (count - 1) + elementSize > viewLength))
+            return fail("accessor out of its buffer's range");
+        start = buffer.data + viewOffset + offset;
+        return true;
+    }
+
+    // `components` floats per element; components the accessor lacks are left at `fill`
+    bool readAccessor(size_t index, int components, float fill, std::vector<float> &values, size_t &count)
+    {
+        const JsonValue &accessor = json["accessors"][index];
+        if (!accessor.isObject())
+            return fail("missing accessor " + std::to_string(index));
+        if (accessor.has("sparse"))
+            return fail("sparse accessors are not supported");
+        const std::string &type = accessor["type"].asString();
+        const int available = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+        const int componentType = static_cast<int>(accessor["componentType"].asNumber(0));
+        const size_t size = componentSize(componentType);
+        if (available == 0 || size == 0)
+            return fail("accessor " + std::to_string(index) + " has an unsupported type");
+
+        count = toIndex(accessor["count"], 0);
+        const unsigned char *start = nullptr;
+        size_t stride = 0;
+        if (accessor.has("bufferView") && !locateAccessor(accessor, size * available, start, stride))
+            return false;
+        values.assign(count * components, fill);
+        if (!start)
+            return true; // No buffer view: all zeros by the spec
+        const bool normalized = accessor["normalized"].asBool();
+        const int read = std::min(available, components);
+        for (size_t i = 0; i < count; i++)
+            for (int c = 0; c < read; c++)
+                values[i * components + c] = readComponent(start + i * stride + c * size, componentType, normalized);
+        return true;
+    }
+
+    bool readIndices(size_t index, size_t vertexCount, std::vector<uint32_t> &indices)
+    {
+        const JsonValue &accessor = json["accessors"][index];
+        const int componentType = static_cast<int>(accessor["componentType"].asNumber(0));
+        if (!accessor.has("bufferView") || accessor["type"].asString() != "SCALAR" ||
+            (componentType != GltfUnsignedByte && componentType != GltfUnsignedShort && componentType != GltfUnsignedInt))
+            return fail("accessor " + std::to_string(index) + " cannot be an index buffer");
+        const size_t size = componentSize(componentType);
+        const unsigned char *start;
+        size_t stride;
+        if (!locateAccessor(accessor, size, start, stride))
+            return false;
+        indices.resize(toIndex(accessor["count"], 0));
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            const unsigned char *element = start + i * stride;
+            indices[i] = componentType == GltfUnsignedByte    ? readUnaligned<uint8_t>(element)
+                         : componentType == GltfUnsignedShort ? readUnaligned<uint16_t>(element)
+                                                              : readUnaligned<uint32_t>(element);
+            if (indices[i] >= vertexCount)
+                return fail("index out of range");
+        }
+        return true;
+    }
+
+    static glm::mat4 localTransform(const JsonValue &node)
+    {
+        glm::mat4 local(1.0f);
+        const JsonValue &matrix = node["matrix"];
+        if (matrix.size() == 16)
+        {
+            for (size_t i = 0; i < 16; i++)
+                glm::value_ptr(local)[i] = static_cast<float>(matrix[i].asNumber()); // Both column-major
+            return local;
+        }
+        const JsonValue &t = node["translation"], &r = node["rotation"], &s = node["scale"];
+        glm::vec3 translation(t[0].asNumber(0), t[1].asNumber(0), t[2].asNumber(0));
+        glm::quat rotation(static_cast<float>(r[3].asNumber(1)), static_cast<float>(r[0].asNumber(0)),
+                           static_cast<float>(r[1].asNumber(0)), static_cast<float>(r[2].asNumber(0)));
+        glm::vec3 scale(s[0].asNumber(1), s[1].asNumber(1), s[2].asNumber(1));
+        glm::mat4 translate(1.0f), scaling(1.0f);
+        translate[3] = glm::vec4(translation, 1.0f);
+        scaling[0][0] = scale.x;
+        scaling[1][1] = scale.y;
+        scaling[2][2] = scale.z;
+        return translate * glm::mat4_cast(rotation) * scaling;
+    }
+
+    bool appendNode(size_t index, const glm::mat4 &parent, int depth)
+    {
+        const JsonValue &node = json["nodes"][index];
+        if (!node.isObject())
+            return fail("missing node " + std::to_string(index));
+        if (depth > maxNodeDepth)
+            return fail("node hierarchy too deep (or cyclic)");
+        const glm::mat4 world = parent * localTransform(node);
+        if (node.has("mesh") && !appendMesh(toIndex(node["mesh"]), world))
+            return false;
+        const JsonValue &children = node["children"];
+        for (size_t i = 0; i < children.size(); i++)
+            if (!appendNode(toIndex(children[i]), world, depth + 1))
+                return false;
+        return true;
+    }
+
+    bool appendMesh(size_t index, const glm::mat4 &world)
+    {
+        const JsonValue &primitives = json["meshes"][index]["primitives"];
+        for (size_t i = 0; i < primitives.size(); i++)
+            if (!appendPrimitive(primitives[i], world))
+                return false;
+        return true;
+    }
+
+    bool appendPrimitive(const JsonValue &primitive, const glm::mat4 &world)
+    {
+        const JsonValue &attributes = primitive["attributes"];
+        if (primitive["mode"].asNumber(4) != 4 || !attributes.has("POSITION"))
+        {
+            spdlog::warn("Mesh {}: skipping a primitive that is not a triangle list", path);
+            return true;
+        }
+
+        size_t count, colorCount, texCoordCount;
+        if (!readAccessor(toIndex(attributes["POSITION"]), 3, 0.0f, positions, count))
+            return false;
+        colors.assign(count * 3, 1.0f);
+        texCoords.assign(count * 2, 0.0f);
+        if (attributes.has("COLOR_0") &&
+            (!readAccessor(toIndex(attributes["COLOR_0"]), 3, 1.0f, colors, colorCount) ||
+             colorCount != count))
+            return fail("COLOR_0 does not match POSITION");
+        if (attributes.has("TEXCOORD_0") &&
+            (!readAccessor(toIndex(attributes["TEXCOORD_0"]), 2, 0.0f, texCoords,
+                           texCoordCount) ||
+             texCoordCount != count))
+            return fail("TEXCOORD_0 does not match POSITION");
+
+        if (primitive.has("indices"))
+        {
+            if (!readIndices(toIndex(primitive["indices"]), count, primitiveIndices))
+                return false;
+        }
+        else
+        {
+            primitiveIndices.resize(count);
+            for (size_t i = 0; i < count; i++)
+                primitiveIndices[i] = static_cast<uint32_t>(i);
+        }
+
+        const uint32_t base = static_cast<uint32_t>(mesh.vertices.size());
+        for (size_t i = 0; i < count; i++)
+        {
+            Vertex vertex;
+            glm::vec3 position = glm::vec3(world * glm::vec4(glm::make_vec3(&positions[i * 3]), 1.0f));
+            for (int c = 0; c < 3; c++)
+            {
+                vertex.pos[c] = position[c];
+                vertex.col[c] = colors[i * 3 + c];
+            }
+            // glTF puts the texture origin top left; vertex data here has it bottom left like OBJ
+            vertex.texCoord[0] = texCoords[i * 2];
+            vertex.texCoord[1] = 1.0f - texCoords[i * 2 + 1];
+            mesh.vertices.push_back(vertex);
+        }
+        // A mirroring transform turns the triangles inside out; swap two corners to undo it
+        const bool mirrored = glm::determinant(glm::mat3(world)) < 0.0f;
+        for (size_t i = 0; i + 2 < primitiveIndices.size(); i += 3)
+        {
+            mesh.indices.push_back(base + primitiveIndices[i]);
+            mesh.indices.push_back(base + primitiveIndices[i + (mirrored ? 2 : 1)]);
+            mesh.indices.push_back(base + primitiveIndices[i + (mirrored ? 1 : 2)]);
+        }
+        return true;
+    }
+
+    std::string path;
+    MeshData &mesh;
+    MappedFile file;
+    JsonValue json;
+    Buffer binaryChunk;
+    std::vector<Buffer> buffers;
+    std::vector<std::vector<unsigned char>> decoded; // Data URI buffers
+    std::vector<MappedFile> externalFiles;
+    std::vector<float> positions, colors, texCoords; // Scratch, per primitive
+    std::vector<uint32_t> primitiveIndices;
+};
+
+bool loadGltf(const std::string &path, MeshData &mesh)
+{
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    GltfReader reader(path, mesh);
+    return reader.load();
+}
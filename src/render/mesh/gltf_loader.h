@@ -0,0 +1,12 @@
+#ifndef GLTF_LOADER_H
+#define GLTF_LOADER_H
+
+#include <string>
+#include "mesh_data.h"
+
+// glTF 2.0, as .gltf (buffers embedded as base64 data URIs or in files next to it) or binary .glb.
+// Every triangle primitive reachable from the default scene is flattened into one mesh with its
+// node transforms applied; POSITION, COLOR_0 and TEXCOORD_0 are read, anything else is ignored.
+bool loadGltf(const std::string &path, MeshData &mesh);
+
+#endif /* GLTF_LOADER_H */
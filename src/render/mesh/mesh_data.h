@@ -0,0 +1,18 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include <cstdint>
+#include <vector>
+#include "../vertex/vertex.h"
+
+// Indexed triangle list on the CPU, in the authoring vertex format, as loaders produce it and the
+// optimizer passes rework it
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices; // Three per triangle
+
+    size_t triangleCount() const { return indices.size() / 3; }
+};
+
+#endif /* MESH_DATA_H */
@@ -0,0 +1,107 @@
+#ifndef MESH_FORMAT_H
+#define MESH_FORMAT_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "../vertex/vertex.h"
+
+// Imported mesh cache (".mesh"): a header, the vertices as PackedVertex and the indices in the
+// header's index type, each section 16-byte aligned. Everything is stored exactly as it is uploaded,
+// so a mapped file goes to glBufferData as it is.
+
+static const char meshCacheMagic[4] = {'M', 'E', 'S', 'H'};
+static const uint32_t meshCacheVersion = 2; // 2: half-float texture coordinates
+static const size_t meshCacheAlignment = 16;
+
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize; // Size and last write time of the imported file: if either differs, it changed
+    int64_t sourceTime;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexType;    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t vertexStride; // sizeof(PackedVertex) when written; catches layout changes the version missed
+    float boundsCenter[3]; // Source position = boundsCenter + boundsScale * cached position
+    float boundsScale;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+};
+
+// Sections of a cache image; pointers are valid as long as the image is
+struct MeshCacheView
+{
+    MeshCacheHeader header;
+    const PackedVertex *vertices = nullptr;
+    const void *indices = nullptr;
+};
+
+inline size_t meshCacheAlign(size_t offset)
+{
+    return (offset + meshCacheAlignment - 1) / meshCacheAlignment * meshCacheAlignment;
+}
+
+// Whole cache image; the header's counts, offsets and index type are filled in here
+inline std::vector<unsigned char> buildMeshCache(MeshCacheHeader header, const std::vector<PackedVertex> &vertices,
+                                                 const std::vector<uint32_t> &indices, GLenum indexType)
+{
+    std::memcpy(header.magic, meshCacheMagic, sizeof(header.magic));
+    header.version = meshCacheVersion;
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.indexType = indexType;
+    header.vertexStride = sizeof(PackedVertex);
+    header.vertexOffset = meshCacheAlign(sizeof(MeshCacheHeader));
+    const size_t vertexBytes = vertices.size() * sizeof(PackedVertex);
+    header.indexOffset = meshCacheAlign(header.vertexOffset + vertexBytes);
+    const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    std::vector<unsigned char> image(header.indexOffset + indices.size() * indexSize, 0);
+    std::memcpy(image.data(), &header, sizeof(header));
+    if (vertexBytes > 0)
+        std::memcpy(image.data() + header.vertexOffset, vertices.data(), vertexBytes);
+    unsigned char *out = image.data() + header.indexOffset;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (indexType == GL_UNSIGNED_SHORT)
+        {
+            uint16_t index = static_cast<uint16_t>(indices[i]);
+            std::memcpy(out + i * sizeof(index), &index, sizeof(index));
+        }
+        else
+            std::memcpy(out + i * sizeof(uint32_t), &indices[i], sizeof(uint32_t));
+    }
+    return image;
+}
+
+// Check a cache image and locate its sections; false if it is not one this build can upload
+inline bool parseMeshCache(const unsigned char *data, size_t size, MeshCacheView &view)
+{
+    if (size < sizeof(MeshCacheHeader))
+        return false;
+    MeshCacheHeader &header = view.header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, meshCacheMagic, sizeof(header.magic)) != 0 || header.version != meshCacheVersion ||
+        header.vertexStride != sizeof(PackedVertex))
+        return false;
+    if (header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT)
+        return false;
+    const uint64_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    // Offsets come from the file: compare sizes against what is left, so a corrupt one cannot wrap around
+    if (header.vertexOffset % meshCacheAlignment != 0 || header.indexOffset % meshCacheAlignment != 0 ||
+        header.vertexOffset < sizeof(MeshCacheHeader) || header.indexOffset < header.vertexOffset ||
+        header.indexOffset > size)
+        return false;
+    if (static_cast<uint64_t>(header.vertexCount) * sizeof(PackedVertex) > header.indexOffset - header.vertexOffset ||
+        static_cast<uint64_t>(header.indexCount) * indexSize > size - header.indexOffset)
+        return false;
+
+    view.vertices = reinterpret_cast<const PackedVertex *>(data + header.vertexOffset);
+    view.indices = data + header.indexOffset;
+    return true;
+}
+
+#endif /* MESH_FORMAT_H */
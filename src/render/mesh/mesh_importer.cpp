@@ -0,0 +1,306 @@
+#include "mesh_importer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include "gltf_loader.h"
+#include "mesh_format.h"
+#include "mesh_optimizer.h"
+#include "obj_loader.h"
+#include "../../io/path.h"
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Size and modification time of the source, which a cache file must match
+static bool sourceStamp(const std::string &path, uint64_t &size, int64_t &time)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    auto writeTime = std::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+    time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+static std::string lowercaseExtension(const std::string &path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+MeshImporter::MeshImporter(const std::string &cacheDirectory, unsigned workerCount) : cacheDirectory(cacheDirectory)
+{
+    for (unsigned i = 0; i < std::max(workerCount, 1u); i++)
+        workers.emplace_back(&MeshImporter::workerLoop, this);
+}
+
+MeshImporter::~MeshImporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+std::string MeshImporter::cachePath(const std::string &path) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 ".mesh", hashPath(normalizePath(path)));
+    return cacheDirectory + "/" + name;
+}
+
+void MeshImporter::request(const std::string &path, GLuint program, Ready ready)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back({path, program, std::move(ready)});
+    jobAvailable.notify_one();
+}
+
+void MeshImporter::update()
+{
+    while (true)
+    {
+        Result result;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (results.empty())
+                return;
+            result = std::move(results.front());
+            results.pop_front();
+        }
+
+        ImportedMesh imported;
+        imported.path = result.job.path;
+        imported.fromCache = result.fromCache;
+        if (!result.ok)
+        {
+            totals.failures++;
+            result.job.ready(imported);
+            continue;
+        }
+        if (result.fromCache)
+        {
+            totals.cacheLoads++;
+            totals.cacheLoadMilliseconds += result.milliseconds;
+        }
+        else
+        {
+            totals.imports++;
+            totals.importMilliseconds += result.milliseconds;
+        }
+
+        // The worker validated the image, so this cannot fail; the mapping goes to the driver as it is
+        const unsigned char *data = result.fromCache ? result.file.data() : result.image.data();
+        const size_t size = result.fromCache ? result.file.size() : result.image.size();
+        MeshCacheView view;
+        parseMeshCache(data, size, view);
+        auto start = std::chrono::steady_clock::now();
+        imported.mesh = uploadMesh(vertexFormat<PackedVertex>(), view.vertices, view.header.vertexCount, view.indices,
+                                   view.header.indexType, view.header.indexCount, result.job.program);
+        const double uploadMilliseconds = millisecondsSince(start);
+        totals.uploadMilliseconds += uploadMilliseconds;
+        imported.center = glm::vec3(view.header.boundsCenter[0], view.header.boundsCenter[1], view.header.boundsCenter[2]);
+        imported.scale = view.header.boundsScale;
+        spdlog::info("Mesh uploaded: {} ({} vertices, {} triangles, {}-bit indices) in {:.2f} ms", imported.path,
+                     view.header.vertexCount, view.header.indexCount / 3,
+                     view.header.indexType == GL_UNSIGNED_SHORT ? 16 : 32, uploadMilliseconds);
+        result.job.ready(imported);
+    }
+}
+
+void MeshImporter::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]
+                              { return !running || !jobs.empty(); });
+            if (!running)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Result result;
+        result.job = std::move(job);
+        auto start = std::chrono::steady_clock::now();
+        result.fromCache = loadCache(result.job.path, result);
+        result.ok = result.fromCache || import(result.job.path, result);
+        result.milliseconds = millisecondsSince(start);
+        if (result.fromCache)
+            spdlog::info("Mesh cache loaded: {} in {:.2f} ms", result.job.path, result.milliseconds);
+        else if (result.ok)
+            spdlog::info("Mesh imported: {} in {:.2f} ms", result.job.path, result.milliseconds);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    }
+}
+
+bool MeshImporter::loadCache(const std::string &path, Result &result)
+{
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!sourceStamp(path, sourceSize, sourceTime))
+        return false;
+    const std::string cacheFile = cachePath(path);
+    if (!std::filesystem::exists(cacheFile))
+        return false;
+
+    MappedFile file;
+    MeshCacheView view;
+    if (!file.open(cacheFile) || !parseMeshCache(file.data(), file.size(), view))
+    {
+        spdlog::warn("Mesh cache unreadable, importing again: {}", cacheFile);
+        return false;
+    }
+    if (view.header.sourceSize != sourceSize || view.header.sourceTime != sourceTime)
+    {
+        spdlog::info("Mesh changed since it was cached, importing again: {}", path);
+        return false;
+    }
+
+    // A corrupt index would read past the vertex buffer on the GPU. Checking them reads the index
+    // pages in; the vertex pages are touched too, so the upload on the GL thread never faults.
+    const uint32_t vertexCount = view.header.vertexCount;
+    for (uint32_t i = 0; i < view.header.indexCount; i++)
+    {
+        uint32_t index;
+        if (view.header.indexType == GL_UNSIGNED_SHORT)
+            index = static_cast<const uint16_t *>(view.indices)[i];
+        else
+            index = static_cast<const uint32_t *>(view.indices)[i];
+        if (index >= vertexCount)
+        {
+            spdlog::warn("Mesh cache has an index out of range, importing again: {}", cacheFile);
+            return false;
+        }
+    }
+    const unsigned char *vertices = reinterpret_cast<const unsigned char *>(view.vertices);
+    unsigned char sum = 0;
+    for (size_t offset = 0; offset < vertexCount * sizeof(PackedVertex); offset += 4096)
+        sum ^= vertices[offset];
+    volatile unsigned char touched = sum; // Keeps the reads
+    (void)touched;
+
+    result.file = std::move(file);
+    return true;
+}
+
+bool MeshImporter::import(const std::string &path, Result &result)
+{
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!sourceStamp(path, sourceSize, sourceTime))
+    {
+        spdlog::error("Mesh not found: {}", path);
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MeshData mesh;
+    const std::string extension = lowercaseExtension(path);
+    bool loaded;
+    if (extension == ".obj")
+        loaded = loadObj(path, mesh);
+    else if (extension == ".gltf" || extension == ".glb")
+        loaded = loadGltf(path, mesh);
+    else
+    {
+        spdlog::error("Unsupported mesh format (expected .obj, .gltf or .glb): {}", path);
+        return false;
+    }
+    if (!loaded)
+        return false;
+    if (mesh.indices.empty())
+    {
+        spdlog::error("Mesh has no triangles: {}", path);
+        return false;
+    }
+    const double parseMilliseconds = millisecondsSince(start);
+
+    // Fit into [-0.5, 0.5]^3 around the center: the unit cube's space, and where half floats are precise
+    glm::vec3 lower(mesh.vertices[0].pos[0], mesh.vertices[0].pos[1], mesh.vertices[0].pos[2]);
+    glm::vec3 upper = lower;
+    for (const Vertex &vertex : mesh.vertices)
+    {
+        glm::vec3 position(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+        lower = glm::min(lower, position);
+        upper = glm::max(upper, position);
+    }
+    const glm::vec3 center = (lower + upper) * 0.5f;
+    const glm::vec3 size = upper - lower;
+    float scale = std::max(size.x, std::max(size.y, size.z));
+    if (!(scale > 0.0f))
+        scale = 1.0f;
+    for (Vertex &vertex : mesh.vertices)
+        for (int i = 0; i < 3; i++)
+            vertex.pos[i] = (vertex.pos[i] - center[i]) / scale;
+
+    start = std::chrono::steady_clock::now();
+    const size_t sourceVertices = mesh.vertices.size();
+    deduplicateVertices(mesh);
+    const VertexCacheStats before = analyzeVertexCache(mesh); // Of the source's triangle order
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+    const VertexCacheStats after = analyzeVertexCache(mesh);
+    const double optimizeMilliseconds = millisecondsSince(start);
+    spdlog::info("Mesh optimized: {} vertices -> {}, {} triangles, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                 sourceVertices, mesh.vertices.size(), mesh.triangleCount(), before.acmr, after.acmr, before.atvr,
+                 after.atvr);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<PackedVertex> packed(mesh.vertices.size());
+    for (size_t i = 0; i < packed.size(); i++)
+        convertVertex(mesh.vertices[i], packed[i]);
+    MeshCacheHeader header{};
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.boundsCenter[0] = center.x;
+    header.boundsCenter[1] = center.y;
+    header.boundsCenter[2] = center.z;
+    header.boundsScale = scale;
+    result.image = buildMeshCache(header, packed, mesh.indices, smallestIndexType(packed.size()));
+
+    // Written under a temporary name and renamed, so a crash never leaves half a cache behind
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    const std::string cacheFile = cachePath(path);
+    const std::string partialFile = cacheFile + ".partial";
+    {
+        std::ofstream out(partialFile, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(result.image.data()), static_cast<std::streamsize>(result.image.size()));
+        if (!out)
+            error = std::make_error_code(std::errc::io_error);
+    }
+    if (!error)
+        std::filesystem::rename(partialFile, cacheFile, error);
+    if (error)
+    {
+        std::filesystem::remove(partialFile, error);
+        spdlog::warn("Mesh cache not written (the mesh is still used): {}", cacheFile);
+    }
+    spdlog::info("Mesh import timings: parse {:.2f} ms, optimize {:.2f} ms, pack and write {:.2f} ms",
+                 parseMilliseconds, optimizeMilliseconds, millisecondsSince(start));
+    return true;
+}
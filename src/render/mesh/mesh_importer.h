@@ -0,0 +1,100 @@
+#ifndef MESH_IMPORTER_H
+#define MESH_IMPORTER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../io/mapped_file.h"
+#include "../vertex/mesh.h"
+
+// A mesh delivered by MeshImporter. Positions are centered and scaled into [-0.5, 0.5]^3, which keeps
+// half floats precise; center + scale * position gives back the source coordinates.
+struct ImportedMesh
+{
+    std::string path;
+    Mesh mesh; // vertexArray is 0 if the import failed
+    glm::vec3 center = glm::vec3(0.0f);
+    float scale = 1.0f;
+    bool fromCache = false;
+};
+
+// Loads OBJ (.obj) and glTF (.gltf, .glb) meshes on worker threads. An import parses the file, merges
+// duplicate vertices, reorders triangles for the post-transform cache and then for overdraw, reorders
+// vertices for fetch locality, packs them into PackedVertex with the smallest index type and writes
+// the result to the cache directory. Later runs map that file instead and upload it as it is; a
+// source whose size or modification time changed is imported again. Only the upload runs on the GL
+// thread.
+class MeshImporter
+{
+public:
+    // Totals so far (GL thread); imports and cache loads are timed separately, uploads on their own
+    struct Stats
+    {
+        size_t imports = 0;
+        size_t cacheLoads = 0;
+        size_t failures = 0;
+        double importMilliseconds = 0.0;
+        double cacheLoadMilliseconds = 0.0;
+        double uploadMilliseconds = 0.0;
+    };
+
+    // GL thread, from update(): the callee owns the mesh from here on (see destroyMesh)
+    using Ready = std::function<void(const ImportedMesh &mesh)>;
+
+    explicit MeshImporter(const std::string &cacheDirectory, unsigned workerCount = 1);
+    ~MeshImporter();
+    MeshImporter(const MeshImporter &) = delete;
+    MeshImporter &operator=(const MeshImporter &) = delete;
+
+    // Queue a mesh; its attributes will be bound for `program`
+    void request(const std::string &path, GLuint program, Ready ready);
+
+    // Upload every finished mesh and hand it over; once per frame
+    void update();
+
+    const Stats &stats() const { return totals; }
+
+    // Cache file used for a source path
+    std::string cachePath(const std::string &path) const;
+
+private:
+    struct Job
+    {
+        std::string path;
+        GLuint program;
+        Ready ready;
+    };
+
+    struct Result
+    {
+        Job job;
+        bool ok = false;
+        bool fromCache = false;
+        double milliseconds = 0.0;
+        MappedFile file;                 // The cache file, on a cache hit
+        std::vector<unsigned char> image; // The cache image built by an import
+    };
+
+    void workerLoop();
+    bool loadCache(const std::string &path, Result &result);
+    bool import(const std::string &path, Result &result);
+
+    std::string cacheDirectory;
+    Stats totals;
+
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{true};
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<Job> jobs;
+    std::deque<Result> results;
+};
+
+#endif /* MESH_IMPORTER_H */
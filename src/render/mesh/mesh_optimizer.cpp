@@ -0,0 +1,351 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// FIFO post-transform cache: a vertex hits if it missed less than `size` misses ago. reset() empties
+// it in constant time by moving the clock past every stamp.
+class FifoCache
+{
+public:
+    FifoCache(size_t vertexCount, unsigned size) : stamps(vertexCount, 0), size(size), time(size + 1) {}
+
+    void reset() { time += size + 1; }
+
+    // Misses of one triangle's three vertices
+    unsigned triangle(const uint32_t *corners)
+    {
+        return access(corners[0]) + access(corners[1]) + access(corners[2]);
+    }
+
+private:
+    unsigned access(uint32_t vertex)
+    {
+        if (time - stamps[vertex] <= size)
+            return 0;
+        stamps[vertex] = time++;
+        return 1;
+    }
+
+    std::vector<uint32_t> stamps;
+    uint32_t size;
+    uint32_t time;
+};
+
+VertexCacheStats analyzeVertexCache(const MeshData &mesh, unsigned cacheSize)
+{
+    VertexCacheStats stats;
+    const size_t triangleCount = mesh.triangleCount();
+    if (triangleCount == 0)
+        return stats;
+
+    FifoCache cache(mesh.vertices.size(), cacheSize);
+    std::vector<char> used(mesh.vertices.size(), 0);
+    size_t misses = 0;
+    size_t usedCount = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        misses += cache.triangle(&mesh.indices[t * 3]);
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t vertex = mesh.indices[t * 3 + k];
+            usedCount += used[vertex] ? 0 : 1;
+            used[vertex] = 1;
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(usedCount);
+    return stats;
+}
+
+// FNV-1a over the vertex's words, then a murmur finalizer so the low bits used for slots mix well
+static uint32_t hashVertex(const Vertex &vertex)
+{
+    uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+    std::memcpy(words, &vertex, sizeof(words));
+    uint32_t hash = 2166136261u;
+    for (uint32_t word : words)
+    {
+        hash ^= word;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+void deduplicateVertices(MeshData &mesh)
+{
+    const size_t count = mesh.vertices.size();
+    const uint32_t empty = ~0u;
+
+    // Open addressing over indices into `unique`, at most half full
+    size_t capacity = 1;
+    while (capacity < count * 2)
+        capacity <<= 1;
+    std::vector<uint32_t> table(capacity, empty);
+    std::vector<uint32_t> remap(count);
+    std::vector<Vertex> unique;
+    unique.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Vertex &vertex = mesh.vertices[i];
+        size_t slot = hashVertex(vertex) & (capacity - 1);
+        while (table[slot] != empty && std::memcmp(&unique[table[slot]], &vertex, sizeof(Vertex)) != 0)
+            slot = (slot + 1) & (capacity - 1);
+        if (table[slot] == empty)
+        {
+            table[slot] = static_cast<uint32_t>(unique.size());
+            unique.push_back(vertex);
+        }
+        remap[i] = table[slot];
+    }
+
+    for (uint32_t &index : mesh.indices)
+        index = remap[index];
+    mesh.vertices.swap(unique);
+}
+
+// Forsyth's scoring, with his published constants, for a simulated LRU cache of 32 entries
+static const unsigned forsythCacheSize = 32;
+
+static float forsythVertexScore(int cachePosition, uint32_t liveTriangles)
+{
+    if (liveTriangles == 0)
+        return -1.0f; // In no triangle left to emit
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The last triangle's vertices score the same, so the order within it does not matter
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (forsythCacheSize - 3), 1.5f);
+    }
+    // Favour vertices with few triangles left, so they are finished off and leave the cache for good
+    return score + 2.0f * std::pow(static_cast<float>(liveTriangles), -0.5f);
+}
+
+void optimizeVertexCache(MeshData &mesh)
+{
+    const size_t triangleCount = mesh.triangleCount();
+    const size_t vertexCount = mesh.vertices.size();
+    if (triangleCount == 0)
+        return;
+    const uint32_t *indices = mesh.indices.data();
+    const size_t none = ~size_t(0);
+
+    // Triangles of each vertex; the first liveCount[v] of them are not emitted yet
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        liveCount[indices[i]]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + liveCount[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = forsythVertexScore(-1, liveCount[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    size_t best = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[best])
+            best = t;
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    uint32_t cache[forsythCacheSize + 3];
+    uint32_t nextCache[forsythCacheSize + 3];
+    size_t cacheCount = 0;
+    size_t deadEndCursor = 0;
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Nothing left around the cache: carry on with the next triangle in input order
+        if (best == none)
+        {
+            while (emitted[deadEndCursor])
+                deadEndCursor++;
+            best = deadEndCursor;
+        }
+        const uint32_t *corners = indices + best * 3;
+        result.insert(result.end(), corners, corners + 3);
+        emitted[best] = 1;
+
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t *live = &adjacency[offsets[corners[k]]];
+            uint32_t &count = liveCount[corners[k]];
+            uint32_t *slot = std::find(live, live + count, static_cast<uint32_t>(best));
+            std::swap(*slot, live[count - 1]);
+            count--;
+        }
+
+        // The triangle's vertices move to the front, the rest shift back; the tail falls out
+        size_t nextCount = 0;
+        for (int k = 0; k < 3; k++)
+            if (std::find(nextCache, nextCache + nextCount, corners[k]) == nextCache + nextCount)
+                nextCache[nextCount++] = corners[k];
+        for (size_t i = 0; i < cacheCount; i++)
+            if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+                nextCache[nextCount++] = cache[i];
+
+        // Rescore every vertex whose position or live count changed, and its live triangles with it
+        for (size_t i = 0; i < nextCount; i++)
+        {
+            uint32_t vertex = nextCache[i];
+            cachePosition[vertex] = i < forsythCacheSize ? static_cast<int>(i) : -1;
+            float score = forsythVertexScore(cachePosition[vertex], liveCount[vertex]);
+            float delta = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+            const uint32_t *live = &adjacency[offsets[vertex]];
+            for (uint32_t j = 0; j < liveCount[vertex]; j++)
+                triangleScore[live[j]] += delta;
+        }
+        cacheCount = std::min<size_t>(nextCount, forsythCacheSize);
+        std::copy(nextCache, nextCache + cacheCount, cache);
+
+        best = none;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cacheCount; i++)
+        {
+            const uint32_t *live = &adjacency[offsets[cache[i]]];
+            for (uint32_t j = 0; j < liveCount[cache[i]]; j++)
+                if (triangleScore[live[j]] > bestScore)
+                {
+                    bestScore = triangleScore[live[j]];
+                    best = live[j];
+                }
+        }
+    }
+    mesh.indices.swap(result);
+}
+
+void optimizeOverdraw(MeshData &mesh, float threshold)
+{
+    const size_t triangleCount = mesh.triangleCount();
+    if (triangleCount < 2)
+        return;
+    const uint32_t *indices = mesh.indices.data();
+    FifoCache cache(mesh.vertices.size(), 16);
+
+    // Hard boundaries: a triangle missing on all three vertices starts a new patch of the surface
+    std::vector<size_t> patches;
+    for (size_t t = 0; t < triangleCount; t++)
+        if (cache.triangle(indices + t * 3) == 3 || t == 0)
+            patches.push_back(t);
+    patches.push_back(triangleCount);
+
+    // Soft boundaries: split a patch again wherever its running ACMR has come within `threshold` of
+    // the whole patch's, so the extra misses of a cold cache at each cluster start stay bounded
+    std::vector<size_t> clusters;
+    for (size_t p = 0; p + 1 < patches.size(); p++)
+    {
+        const size_t begin = patches[p];
+        const size_t end = patches[p + 1];
+        cache.reset();
+        size_t patchMisses = 0;
+        for (size_t t = begin; t < end; t++)
+            patchMisses += cache.triangle(indices + t * 3);
+        const float target = threshold * static_cast<float>(patchMisses) / static_cast<float>(end - begin);
+
+        cache.reset();
+        clusters.push_back(begin);
+        size_t start = begin;
+        size_t misses = 0;
+        for (size_t t = begin; t < end; t++)
+        {
+            misses += cache.triangle(indices + t * 3);
+            if (t + 1 < end && static_cast<float>(misses) <= target * static_cast<float>(t + 1 - start))
+            {
+                clusters.push_back(t + 1);
+                cache.reset();
+                start = t + 1;
+                misses = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Area-weighted centroid and normal of every cluster and of the whole mesh
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        glm::vec3 centroid;
+        glm::vec3 normal;
+        float key;
+    };
+    std::vector<Cluster> sorted(clusters.size() - 1);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c + 1 < clusters.size(); c++)
+    {
+        Cluster &cluster = sorted[c];
+        cluster.begin = clusters[c];
+        cluster.end = clusters[c + 1];
+        glm::vec3 weighted(0.0f), corners(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = cluster.begin; t < cluster.end; t++)
+        {
+            glm::vec3 p0 = glm::make_vec3(mesh.vertices[indices[t * 3]].pos);
+            glm::vec3 p1 = glm::make_vec3(mesh.vertices[indices[t * 3 + 1]].pos);
+            glm::vec3 p2 = glm::make_vec3(mesh.vertices[indices[t * 3 + 2]].pos);
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            float triangleArea = glm::length(cross);
+            weighted += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            corners += (p0 + p1 + p2) / 3.0f;
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += weighted;
+        meshArea += area;
+        cluster.centroid = area > 0.0f ? weighted / area : corners / static_cast<float>(cluster.end - cluster.begin);
+        float length = glm::length(normal);
+        cluster.normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Clusters facing away from the center first: they are on the outside and tend to hide the rest
+    for (Cluster &cluster : sorted)
+        cluster.key = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b)
+                     { return a.key > b.key; });
+
+    std::vector<uint32_t> result;
+    result.reserve(mesh.indices.size());
+    for (const Cluster &cluster : sorted)
+        result.insert(result.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+    mesh.indices.swap(result);
+}
+
+void optimizeVertexFetch(MeshData &mesh)
+{
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(mesh.vertices.size());
+    for (uint32_t &index : mesh.indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<uint32_t>(ordered.size());
+            ordered.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(ordered);
+}
@@ -0,0 +1,144 @@
+#include "obj_loader.h"
+
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include "../../io/mapped_file.h"
+
+// Position or texture coordinate reference of a face corner: 1-based, negative counts from the end
+static bool resolveIndex(long reference, size_t count, size_t &index)
+{
+    if (reference > 0 && static_cast<size_t>(reference) <= count)
+        index = static_cast<size_t>(reference - 1);
+    else if (reference < 0 && static_cast<size_t>(-reference) <= count)
+        index = count - static_cast<size_t>(-reference);
+    else
+        return false;
+    return true;
+}
+
+bool loadObj(const std::string &path, MeshData &mesh)
+{
+    MappedFile file;
+    if (!file.open(path))
+    {
+        spdlog::error("Failed to open mesh {}", path);
+        return false;
+    }
+
+    std::vector<glm::vec3> positions, colors;
+    std::vector<glm::vec2> texCoords;
+    std::vector<Vertex> face;
+    std::string line;
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    size_t lineNumber = 0;
+
+    const char *cursor = reinterpret_cast<const char *>(file.data());
+    const char *end = cursor + file.size();
+    while (cursor < end)
+    {
+        // strtof and friends need a terminated string, so each line is copied out first
+        const char *lineEnd = cursor;
+        while (lineEnd < end && *lineEnd != '\n')
+            lineEnd++;
+        line.assign(cursor, lineEnd);
+        cursor = lineEnd + 1;
+        lineNumber++;
+
+        const char *text = line.c_str();
+        char *next = nullptr;
+        if (line.compare(0, 2, "v ") == 0)
+        {
+            glm::vec3 position, color(1.0f);
+            text += 2;
+            for (int i = 0; i < 3; i++, text = next)
+                position[i] = std::strtof(text, &next);
+            for (int i = 0; i < 3; i++, text = next)
+            {
+                float value = std::strtof(text, &next);
+                if (next == text)
+                {
+                    color = glm::vec3(1.0f);
+                    break;
+                }
+                color[i] = value;
+            }
+            positions.push_back(position);
+            colors.push_back(color);
+        }
+        else if (line.compare(0, 3, "vt ") == 0)
+        {
+            glm::vec2 texCoord;
+            text += 3;
+            for (int i = 0; i < 2; i++, text = next)
+                texCoord[i] = std::strtof(text, &next);
+            texCoords.push_back(texCoord);
+        }
+        else if (line.compare(0, 2, "f ") == 0)
+        {
+            // Corners are "v", "v/vt", "v//vn" or "v/vt/vn"
+            face.clear();
+            text += 2;
+            while (true)
+            {
+                long positionReference = std::strtol(text, &next, 10);
+                if (next == text)
+                    break;
+                text = next;
+                long texCoordReference = 0;
+                if (*text == '/')
+                {
+                    text++;
+                    if (*text != '/')
+                    {
+                        texCoordReference = std::strtol(text, &next, 10);
+                        text = next;
+                    }
+                    if (*text == '/')
+                    {
+                        text++;
+                        std::strtol(text, &next, 10); // Normal, unused
+                        text = next;
+                    }
+                }
+
+                size_t position, texCoord = 0;
+                if (!resolveIndex(positionReference, positions.size(), position) ||
+                    (texCoordReference != 0 && !resolveIndex(texCoordReference, texCoords.size(), texCoord)))
+                {
+                    spdlog::error("Mesh {}: face corner out of range on line {}", path, lineNumber);
+                    return false;
+                }
+                Vertex vertex{};
+                for (int i = 0; i < 3; i++)
+                {
+                    vertex.pos[i] = positions[position][i];
+                    vertex.col[i] = colors[position][i];
+                }
+                if (texCoordReference != 0)
+                {
+                    vertex.texCoord[0] = texCoords[texCoord].x;
+                    vertex.texCoord[1] = texCoords[texCoord].y;
+                }
+                face.push_back(vertex);
+            }
+
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                for (const Vertex &corner : {face[0], face[i - 1], face[i]})
+                {
+                    mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
+                    mesh.vertices.push_back(corner);
+                }
+            }
+        }
+    }
+
+    if (mesh.indices.empty())
+    {
+        spdlog::error("Mesh {} has no faces", path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,12 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <string>
+#include "mesh_data.h"
+
+// Wavefront OBJ: positions ("v x y z", optionally followed by an r g b vertex color), texture
+// coordinates and faces of any size (fanned into triangles). Normals, groups and materials are
+// ignored. Every face corner becomes its own vertex; deduplicateVertices() merges them afterwards.
+bool loadObj(const std::string &path, MeshData &mesh);
+
+#endif /* OBJ_LOADER_H */
@@ -0,0 +1,144 @@
+#include "command_list.h"
+
+#include <algorithm>
+#include <chrono>
+
+void CommandList::clear()
+{
+    commands.clear();
+    packets.clear();
+    depths.clear();
+    data.clear();
+}
+
+void CommandList::submit(const DrawPacket &packet, float depth)
+{
+    commands.push_back({Submit, 0, packets.size(), 0});
+    packets.push_back(packet);
+    depths.push_back(depth);
+}
+
+void *CommandList::upload(uint32_t stream, size_t bytes)
+{
+    const size_t alignment = alignof(std::max_align_t);
+    const size_t offset = (data.size() + alignment - 1) / alignment * alignment;
+    data.resize(offset + bytes);
+    commands.push_back({Upload, stream, offset, bytes});
+    return data.data() + offset;
+}
+
+CommandRecorder::CommandRecorder(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; i++)
+        workers.emplace_back(&CommandRecorder::workerLoop, this);
+}
+
+CommandRecorder::~CommandRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void CommandRecorder::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        jobAvailable.wait(lock, [this]
+                          { return !running || nextJob < jobTotal; });
+        if (!running)
+            return;
+        const size_t job = nextJob++;
+        lock.unlock();
+        (*currentJob)(job, lists[job]);
+        lock.lock();
+        if (++finishedJobs == jobTotal)
+            jobsFinished.notify_one();
+    }
+}
+
+void CommandRecorder::record(size_t jobCount, const Job &job)
+{
+    auto start = std::chrono::steady_clock::now();
+    // The workers are idle between calls, so the lists can be resized freely
+    if (lists.size() < jobCount)
+        lists.resize(jobCount);
+    for (size_t i = 0; i < jobCount; i++)
+        lists[i].clear();
+    listCount = jobCount;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    currentJob = &job;
+    jobTotal = jobCount;
+    nextJob = 0;
+    finishedJobs = 0;
+    if (!workers.empty() && jobCount > 1)
+        jobAvailable.notify_all();
+
+    // The calling thread takes jobs too, then waits for the ones still running elsewhere
+    while (nextJob < jobTotal)
+    {
+        const size_t index = nextJob++;
+        lock.unlock();
+        job(index, lists[index]);
+        lock.lock();
+        finishedJobs++;
+    }
+    jobsFinished.wait(lock, [this]
+                      { return finishedJobs == jobTotal; });
+    currentJob = nullptr;
+    jobTotal = nextJob = finishedJobs = 0;
+
+    stats.jobs = jobCount;
+    stats.recordMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CommandRecorder::replay(RenderQueue &queue, const UploadStream *streams, size_t streamCount)
+{
+    auto start = std::chrono::steady_clock::now();
+    stats.commands = 0;
+    stats.uploadBytes = 0;
+
+    // Totals first, so each stream can size its destination before the first piece arrives
+    streamOffsets.assign(streamCount, 0);
+    for (size_t i = 0; i < listCount; i++)
+        for (const CommandList::Command &command : lists[i].commands)
+            if (command.type == CommandList::Upload && command.stream < streamCount)
+                streamOffsets[command.stream] += command.bytes;
+    for (size_t stream = 0; stream < streamCount; stream++)
+        if (streams[stream].begin)
+            streams[stream].begin(streamOffsets[stream]);
+
+    std::fill(streamOffsets.begin(), streamOffsets.end(), 0);
+    for (size_t i = 0; i < listCount; i++)
+    {
+        const CommandList &list = lists[i];
+        for (const CommandList::Command &command : list.commands)
+        {
+            if (command.type == CommandList::Submit)
+                queue.submit(list.packets[command.index], list.depths[command.index]);
+            else if (command.stream < streamCount)
+            {
+                if (streams[command.stream].write)
+                    streams[command.stream].write(streamOffsets[command.stream], list.data.data() + command.index,
+                                                  command.bytes);
+                streamOffsets[command.stream] += command.bytes;
+                stats.uploadBytes += command.bytes;
+            }
+        }
+        stats.commands += list.commands.size();
+    }
+
+    for (size_t stream = 0; stream < streamCount; stream++)
+        if (streams[stream].end)
+            streams[stream].end(streamOffsets[stream]);
+    stats.replayMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
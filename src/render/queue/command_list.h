@@ -0,0 +1,117 @@
+#ifndef COMMAND_LIST_H
+#define COMMAND_LIST_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "render_queue.h"
+
+// Draws and buffer uploads recorded without a GL context, to be replayed on the GL thread. Recording
+// only appends to the list's own storage, which is kept from frame to frame, so any thread can fill
+// a list as long as it is the only one filling it.
+class CommandList
+{
+public:
+    void clear();
+
+    // A packet for the render queue
+    void submit(const DrawPacket &packet, float depth);
+
+    // Room for `bytes` of data for upload stream `stream`, to be filled in place; valid until the next
+    // call on this list. On replay each stream's pieces are written back to back.
+    void *upload(uint32_t stream, size_t bytes);
+
+    size_t commandCount() const { return commands.size(); }
+    size_t uploadBytes() const { return data.size(); }
+
+private:
+    friend class CommandRecorder;
+
+    enum Type : uint32_t
+    {
+        Submit,
+        Upload
+    };
+
+    struct Command
+    {
+        Type type;
+        uint32_t stream; // Upload
+        size_t index;    // Submit: packet; Upload: offset in data
+        size_t bytes;    // Upload
+    };
+
+    std::vector<Command> commands;
+    std::vector<DrawPacket> packets;
+    std::vector<float> depths;
+    std::vector<unsigned char> data; // Upload pieces, each aligned for any type
+};
+
+// Destination of one upload stream on replay. begin and end get the stream's total for the frame,
+// write its pieces in order at consecutive offsets. Any of them may be left empty.
+struct UploadStream
+{
+    std::function<void(size_t totalBytes)> begin;
+    std::function<void(size_t offset, const void *data, size_t bytes)> write;
+    std::function<void(size_t totalBytes)> end;
+};
+
+// Records command lists on worker threads, one list per job, and replays them on the GL thread in
+// job order, so the frame does not depend on which thread ran which job. The workers live as long
+// as the recorder and sleep between frames.
+class CommandRecorder
+{
+public:
+    using Job = std::function<void(size_t job, CommandList &list)>;
+
+    // Of the last record() and replay()
+    struct Stats
+    {
+        size_t jobs = 0;
+        size_t commands = 0;
+        size_t uploadBytes = 0;
+        double recordMilliseconds = 0.0;
+        double replayMilliseconds = 0.0;
+    };
+
+    // threadCount includes the calling thread, which records too; 0 uses every hardware thread
+    explicit CommandRecorder(unsigned threadCount = 0);
+    ~CommandRecorder();
+    CommandRecorder(const CommandRecorder &) = delete;
+    CommandRecorder &operator=(const CommandRecorder &) = delete;
+
+    // Run job(0) ... job(jobCount - 1), each into its own cleared list, and return once all have
+    // finished. Jobs must not make GL calls.
+    void record(size_t jobCount, const Job &job);
+
+    // GL thread: the lists of the last record(), in job order. Packets go to the queue (which is not
+    // executed), uploads to streams[stream]; every stream gets begin and end, even without uploads.
+    void replay(RenderQueue &queue, const UploadStream *streams, size_t streamCount);
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+    const Stats &lastStats() const { return stats; }
+
+private:
+    void workerLoop();
+
+    std::vector<CommandList> lists;
+    size_t listCount = 0;
+    std::vector<size_t> streamOffsets;
+    Stats stats;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobsFinished;
+    const Job *currentJob = nullptr;
+    size_t jobTotal = 0;
+    size_t nextJob = 0;
+    size_t finishedJobs = 0;
+    bool running = true;
+};
+
+#endif /* COMMAND_LIST_H */
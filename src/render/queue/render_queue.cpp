@@ -0,0 +1,145 @@
+#include "render_queue.h"
+
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <glm/gtc/type_ptr.hpp>
+#include "../state/gl_state.h"
+#include "../vertex/mesh.h"
+
+RenderQueue::RenderQueue(size_t capacity) : packetCapacity(capacity)
+{
+    packets.reserve(capacity);
+    entries.reserve(capacity);
+    scratch.reserve(capacity);
+}
+
+uint64_t RenderQueue::makeKey(const DrawPacket &packet, float depth)
+{
+    const uint64_t layer = packet.layer & 0xFu;
+    const uint64_t program = packet.program & 0x7FFu;
+    const uint64_t material = static_cast<uint16_t>(packet.material + 0x8000); // Negative (special) materials first
+
+    // Non-negative floats order like their bit patterns
+    uint32_t bits = 0;
+    if (depth > 0.0f)
+        std::memcpy(&bits, &depth, sizeof(bits));
+
+    if (!packet.translucent)
+        return layer << 60 | program << 48 | material << 32 | bits;
+    return layer << 60 | uint64_t(1) << 59 | static_cast<uint64_t>(~bits) << 27 | program << 16 | material;
+}
+
+void RenderQueue::submit(const DrawPacket &packet, float depth)
+{
+    if (packets.size() == packetCapacity && !grew)
+    {
+        spdlog::warn("Render queue: more than {} packets this frame, growing", packetCapacity);
+        grew = true;
+    }
+    entries.push_back({makeKey(packet, depth), static_cast<uint32_t>(packets.size())});
+    packets.push_back(packet);
+    sorted = false;
+}
+
+void RenderQueue::sort()
+{
+    if (sorted)
+        return;
+    sorted = true;
+    stats.sortPasses = 0;
+    const size_t count = entries.size();
+    if (count < 2)
+        return;
+    scratch.resize(count);
+
+    // Histograms of all eight bytes in one read
+    size_t histogram[8][256] = {};
+    for (const SortEntry &entry : entries)
+        for (int byte = 0; byte < 8; byte++)
+            histogram[byte][(entry.key >> (byte * 8)) & 0xFF]++;
+
+    SortEntry *source = entries.data(), *destination = scratch.data();
+    for (int byte = 0; byte < 8; byte++)
+    {
+        const int shift = byte * 8;
+        size_t *buckets = histogram[byte];
+        if (buckets[(source[0].key >> shift) & 0xFF] == count) // Every key has this byte: nothing to reorder
+            continue;
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++)
+        {
+            size_t bucketCount = buckets[bucket];
+            buckets[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (size_t i = 0; i < count; i++)
+            destination[buckets[(source[i].key >> shift) & 0xFF]++] = source[i];
+        std::swap(source, destination);
+        stats.sortPasses++;
+    }
+    if (source != entries.data())
+        entries.swap(scratch);
+}
+
+void RenderQueue::execute()
+{
+    sort();
+    stats.packets = entries.size();
+    stats.programChanges = 0;
+    stats.materialChanges = 0;
+
+    GLuint program = 0;
+    bool materialSet = false;
+    int material = 0;
+    for (const SortEntry &entry : entries)
+    {
+        const DrawPacket &packet = packets[entry.packet];
+        if (packet.program != program || stats.programChanges == 0)
+        {
+            glState().useProgram(packet.program);
+            program = packet.program;
+            materialSet = false; // Uniforms are per program
+            stats.programChanges++;
+        }
+        if (packet.translucent)
+        {
+            glState().enable(GL_BLEND);
+            glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        else
+            glState().disable(GL_BLEND);
+        if (packet.depthTest)
+            glState().enable(GL_DEPTH_TEST);
+        else
+            glState().disable(GL_DEPTH_TEST);
+
+        if (packet.materialLocation >= 0 && (!materialSet || packet.material != material))
+        {
+            glUniform1i(packet.materialLocation, packet.material);
+            material = packet.material;
+            materialSet = true;
+            stats.materialChanges++;
+        }
+        if (packet.modelLocation >= 0)
+            glUniformMatrix4fv(packet.modelLocation, 1, GL_FALSE, glm::value_ptr(packet.model));
+
+        if (packet.execute)
+            packet.execute(packet, packet.context);
+        else if (packet.indexCount > 0)
+        {
+            glState().bindVertexArray(packet.vertexArray);
+            glDrawElements(GL_TRIANGLES, packet.indexCount, packet.indexType,
+                           reinterpret_cast<const void *>(static_cast<uintptr_t>(packet.firstIndex) *
+                                                          indexTypeSize(packet.indexType)));
+        }
+    }
+    clear();
+}
+
+void RenderQueue::clear()
+{
+    packets.clear();
+    entries.clear();
+    sorted = false;
+}
@@ -0,0 +1,92 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One draw submitted to the RenderQueue. Either an indexed draw of a VAO (indexCount > 0) or a custom
+// draw through `execute`, for batches such as instanced or indirect meshes. The queue binds the
+// program, blend and depth state and sets the model and material uniforms before either.
+struct DrawPacket
+{
+    uint8_t layer = 0;        // Drawn in ascending layer order, 0 - 15
+    bool translucent = false; // Blended and sorted back to front within its layer
+    bool depthTest = true;
+    GLuint program = 0;
+    int material = 0;             // Value of the material uniform; also the sort key's material
+    GLint materialLocation = -1;  // int uniform set to material, -1 = none
+    GLint modelLocation = -1;     // mat4 uniform set to model, -1 = none
+    glm::mat4 model = glm::mat4(1.0f);
+
+    GLuint vertexArray = 0;
+    GLsizei indexCount = 0;
+    GLuint firstIndex = 0; // In indices, not bytes
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    void (*execute)(const DrawPacket &packet, void *context) = nullptr;
+    void *context = nullptr;
+};
+
+// Draws of a frame, sorted by a 64-bit key and then executed. From the most significant bits:
+//
+//   opaque:      layer:4 | 0 | program:11 | material:16 | depth:32 (front to back)
+//   translucent: layer:4 | 1 | depth:32 (back to front) | program:11 | material:16
+//
+// so opaque geometry switches program and material as rarely as possible, while translucent
+// geometry keeps a correct back to front order and then the same grouping among equal depths. The
+// keys are sorted with an 8-bit LSD radix sort that skips the bytes every key shares. Packets,
+// keys and sort scratch are preallocated for `capacity` packets; past that the queue grows.
+class RenderQueue
+{
+public:
+    // Per execute()
+    struct Stats
+    {
+        size_t packets = 0;
+        size_t programChanges = 0;
+        size_t materialChanges = 0;
+        int sortPasses = 0; // Radix passes that were not skipped
+    };
+
+    explicit RenderQueue(size_t capacity = 100000);
+
+    // depth: distance from the camera along the view direction (negative counts as 0)
+    void submit(const DrawPacket &packet, float depth);
+
+    static uint64_t makeKey(const DrawPacket &packet, float depth);
+
+    // Order the submitted packets by key; stable, so equal keys keep their submission order
+    void sort();
+
+    // Sort, draw every packet in order and clear the queue. GL thread only.
+    void execute();
+
+    void clear();
+
+    size_t size() const { return packets.size(); }
+    size_t capacity() const { return packetCapacity; }
+    // Packet index of the i-th draw after sort()
+    uint32_t sortedPacket(size_t i) const { return entries[i].packet; }
+    uint64_t sortedKey(size_t i) const { return entries[i].key; }
+    const DrawPacket &packet(uint32_t index) const { return packets[index]; }
+    const Stats &lastStats() const { return stats; }
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    std::vector<DrawPacket> packets;
+    std::vector<SortEntry> entries, scratch;
+    size_t packetCapacity;
+    bool sorted = false;
+    bool grew = false;
+    Stats stats;
+};
+
+#endif /* RENDER_QUEUE_H */
@@ -0,0 +1,203 @@
+#include "screenshot.h"
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include "../state/gl_state.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+ScreenshotCapture::ScreenshotCapture(const std::string &directory)
+    : directory(directory), writer(&ScreenshotCapture::writerLoop, this)
+{
+    for (Slot &slot : slots)
+        glGenBuffers(1, &slot.buffer);
+}
+
+ScreenshotCapture::~ScreenshotCapture()
+{
+    // Don't lose captures still in flight: wait for their readbacks, let the writer drain, then unmap
+    for (int i = 0; i < slotCount; i++)
+    {
+        if (slots[i].state != SlotState::Reading)
+            continue;
+        glClientWaitSync(slots[i].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        mapForWriter(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+    writer.join();
+
+    for (Slot &slot : slots)
+    {
+        if (slot.mapped)
+        {
+            glState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glState().deleteBuffers(1, &slot.buffer);
+    }
+    glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ScreenshotCapture::request(const std::string &path)
+{
+    requests.push_back(path.empty() ? generatePath() : path);
+    inProgress++;
+}
+
+size_t ScreenshotCapture::pending() const
+{
+    return inProgress;
+}
+
+void ScreenshotCapture::update(int width, int height)
+{
+    for (int i = 0; i < slotCount; i++)
+    {
+        Slot &slot = slots[i];
+        SlotState state;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            state = slot.state;
+        }
+
+        // Never block: a readback that hasn't landed yet is checked again next frame
+        if (state == SlotState::Reading)
+        {
+            GLenum result = glClientWaitSync(slot.fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+                mapForWriter(i);
+        }
+        else if (state == SlotState::Done)
+        {
+            glState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            slot.mapped = nullptr;
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.state = SlotState::Free;
+        }
+        else if (state == SlotState::Free && !requests.empty() && width > 0 && height > 0)
+        {
+            startReadback(slot, requests.front(), width, height);
+            requests.pop_front();
+        }
+    }
+    glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void ScreenshotCapture::startReadback(Slot &slot, const std::string &path, int width, int height)
+{
+    const size_t bytes = static_cast<size_t>(width) * height * 4;
+    glState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+
+    // With a pack buffer bound the copy is queued on the GPU and glReadPixels returns immediately
+    glReadBuffer(GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.path = path;
+    std::lock_guard<std::mutex> lock(mutex);
+    slot.state = SlotState::Reading;
+}
+
+void ScreenshotCapture::mapForWriter(int index)
+{
+    Slot &slot = slots[index];
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    const size_t bytes = static_cast<size_t>(slot.width) * slot.height * 4;
+    glState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    slot.mapped = static_cast<const uint8_t *>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!slot.mapped)
+    {
+        spdlog::error("Failed to map screenshot buffer: {}", slot.path);
+        slot.state = SlotState::Free;
+        inProgress--;
+        return;
+    }
+    slot.state = SlotState::Encoding;
+    jobs.push_back(index);
+    jobAvailable.notify_one();
+}
+
+std::string ScreenshotCapture::generatePath() const
+{
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    int milliseconds = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+
+    char name[64];
+    std::strftime(name, sizeof(name), "screenshot_%Y%m%d_%H%M%S", std::localtime(&seconds));
+    return directory + "/" + name + "_" + std::to_string(milliseconds) + ".png";
+}
+
+void ScreenshotCapture::writerLoop()
+{
+    std::vector<uint8_t> rgb;
+    while (true)
+    {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]
+                              { return !running || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            index = jobs.front();
+            jobs.pop_front();
+        }
+
+        // Copy out of the mapping first (GL rows run bottom-up, alpha dropped) so the buffer goes
+        // back to the GL thread before the slow part, the PNG compression
+        Slot &slot = slots[index];
+        const int width = slot.width, height = slot.height;
+        const std::string path = slot.path;
+        rgb.resize(static_cast<size_t>(width) * height * 3);
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *src = slot.mapped + static_cast<size_t>(height - 1 - y) * width * 4;
+            uint8_t *dst = rgb.data() + static_cast<size_t>(y) * width * 3;
+            for (int x = 0; x < width; x++, src += 4, dst += 3)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.state = SlotState::Done;
+        }
+
+        std::error_code error;
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty())
+            std::filesystem::create_directories(parent, error);
+        auto start = std::chrono::steady_clock::now();
+        if (stbi_write_png(path.c_str(), width, height, 3, rgb.data(), width * 3))
+            spdlog::info("Screenshot saved: {} ({}x{}, {:.0f} ms)", path, width, height,
+                         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        else
+            spdlog::error("Failed to write screenshot: {}", path);
+        inProgress--;
+    }
+}
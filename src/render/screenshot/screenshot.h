@@ -0,0 +1,74 @@
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Screenshots without stalling the frame. capture() queues a glReadPixels of the back buffer into
+// a pixel pack buffer and fences it; a few frames later, once the fence has signalled, the buffer
+// is mapped and a worker thread flips the rows and writes the PNG (stb_image_write). The GL thread
+// never waits for the GPU, copies pixels or encodes.
+class ScreenshotCapture
+{
+public:
+    // Screenshots without an explicit path go to directory/screenshot_<date>_<time>.png
+    explicit ScreenshotCapture(const std::string &directory = "screenshots");
+    ~ScreenshotCapture(); // Finishes pending captures; needs the GL context
+    ScreenshotCapture(const ScreenshotCapture &) = delete;
+    ScreenshotCapture &operator=(const ScreenshotCapture &) = delete;
+
+    // Capture the next frame to `path` (empty = generated name)
+    void request(const std::string &path = "");
+
+    // After the frame is drawn and before the swap: start a requested readback of the back buffer,
+    // hand finished readbacks to the writer and recycle buffers it is done with. Once per frame
+    void update(int width, int height);
+
+    // Requested captures not yet written to disk
+    size_t pending() const;
+
+private:
+    enum class SlotState
+    {
+        Free,
+        Reading,  // glReadPixels queued, waiting for `fence`
+        Encoding, // Mapped, the writer is copying the pixels out
+        Done,     // Writer finished with the mapping, unmap on the GL thread
+    };
+
+    struct Slot
+    {
+        GLuint buffer = 0;
+        size_t capacity = 0;
+        int width = 0;
+        int height = 0;
+        std::string path;
+        GLsync fence = nullptr;
+        const uint8_t *mapped = nullptr;
+        SlotState state = SlotState::Free;
+    };
+
+    void startReadback(Slot &slot, const std::string &path, int width, int height);
+    void mapForWriter(int index);
+    std::string generatePath() const;
+    void writerLoop();
+
+    std::string directory;
+    std::deque<std::string> requests; // GL thread only
+
+    static const int slotCount = 3;
+    Slot slots[slotCount];
+    std::atomic<size_t> inProgress{0};
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<int> jobs; // Slot indices ready for the writer
+    bool running = true;
+    std::thread writer;
+};
+
+#endif /* SCREENSHOT_H */
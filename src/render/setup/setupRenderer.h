@@ -4,21 +4,75 @@
 #include <glad/glad.h>
 #include <GL/gl.h>
 #include <spdlog/spdlog.h>
+#include <cmath>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <base64/base64.h>
 #include "../vertex/vertex.h"
+#include "../vertex/mesh.h"
+#include "../vertex/instanced_mesh.h"
+#include "../vertex/indirect_batch.h"
+#include "../mesh/mesh_importer.h"
 #include "../texture/texture.h"
+#include "../texture/texture_array.h"
+#include "../texture/texture_streamer.h"
+#include "../texture/virtual_texture.h"
+#include "../texture/texture_reloader.h"
+#include "../texture/video_texture.h"
+#include "../screenshot/screenshot.h"
+#include "../camera/camera_uniforms.h"
+#include "../state/gl_state.h"
+#include "../queue/command_list.h"
+#include "../queue/render_queue.h"
+#include "../culling/frustum_culling.h"
+#include <memory>
 #include "../../config.h"
+#include "../../scene/scene.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <tracy/Tracy.hpp>
 #include <tracy/TracyOpenGL.hpp>
 
-static GLuint planeTexture; // Plane texture
-static GLuint cubeTexture;  // Cube texture
-static GLint textureLocation;
+// Scene materials share one BC7 texture array; draws only select a layer
+static std::unique_ptr<TextureArray> materialTextures;
+static int planeMaterial = 0; // Plane texture layer, -1 = streamed ground texture, -2 = virtual texture
+static int cubeMaterial = 0;  // Cube texture layer, -3 = video
+static GLint materialLayerLocation;
+
+// The ground texture is streamed in progressively (low mips first) instead of blocking startup
+static std::unique_ptr<TextureStreamer> textureStreamer;
+static std::shared_ptr<TextureStreamer::Texture> groundTexture;
+
+// Optional tiled virtual texture for very large grounds (--vt)
+static std::unique_ptr<VirtualTexture> groundVirtualTexture;
+
+// Optional video on the cube (--video)
+static std::unique_ptr<VideoTexture> cubeVideo;
+
+// Re-decodes edited textures off the render thread and swaps them in place
+static std::unique_ptr<TextureReloader> textureReloader;
+static std::vector<TextureReloader::Handle> reloadTargets;
+
+// Asynchronous back buffer capture (F12)
+static std::unique_ptr<ScreenshotCapture> screenshotCapture;
+
+// Extra cubes drawn in one instanced call (--cubes)
+static std::unique_ptr<InstancedMesh> cubeInstances;
+static GLint useInstancesLocation;
+
+// Or, with --mdi, one indirect draw command per cube (GL 4.3)
+static std::unique_ptr<IndirectBatch> indirectCubes;
+static std::vector<uint32_t> visibleInstanceSlots; // Rebuilt every frame unless the GPU culls
+
+// Frustum culling: world box of every entity (same index as the store), the visible entity list and
+// the instance transforms it is gathered from
+static BoxArrays entityBoxes;
+static std::vector<uint32_t> visibleEntities; // Each culling subtree fills the slots it owns
+static Bvh cullingBvh; // The render thread's copy of scene.bvh, which the simulation owns
+static std::vector<glm::mat4> instanceModels; // By instance slot
+static std::vector<RenderHandle> entityRenderHandles; // By entity index, copied before the simulation owns the store
 
 // Cube data with updated texture coordinates
 static const Vertex vertices[8] = {
@@ -48,33 +102,69 @@ static const Vertex planeVertices[6] = {
 
 static const GLuint planeIndices[6] = {0, 1, 2, 2, 3, 0};
 
-// Shaders (modified fragment shader to use a fallback color if texture fails)
+// GPU copies of the cube and plane above, in the packed vertex format with 16-bit indices
+static Mesh cubeMesh;
+static Mesh planeMesh;
+
+// Optional imported mesh drawn in place of the extra cubes (--mesh); it arrives a few frames in
+static std::unique_ptr<MeshImporter> meshImporter;
+static Mesh importedMesh;
+
+// View and projection for every program, updated once per frame
+static std::unique_ptr<CameraUniforms> cameraUniforms;
+
+// Scene draws of a frame, sorted by state before they are issued
+static std::unique_ptr<RenderQueue> renderQueue;
+
+// Culling and draw recording spread over threads, one BVH subtree per job; the GL thread replays
+static std::unique_ptr<CommandRecorder> commandRecorder;
+static std::vector<Bvh::Subtree> cullSubtrees;
+static std::vector<size_t> subtreeVisibleCounts;
+
+// Shaders (modified fragment shader to use a fallback color if texture fails). Both are compiled
+// after "#version 330", or "#version 430" plus INDIRECT_DRAW when the cubes use multi-draw indirect;
+// the vertex shader also after CameraUniforms::shaderSource().
 static const char *vertex_shader_text =
-    "#version 330\n"
-    "uniform mat4 MVP;\n"
+    "uniform mat4 model;\n"
+    "uniform int useInstances; // Model matrix from: 0 = the uniform, 1 = per instance, 2 = per indirect draw\n"
     "in vec3 vPos;\n"
     "in vec3 vCol;\n"
     "in vec2 vTexCoord;\n"
+    "in mat4 instanceModel;\n"
+    "#ifdef INDIRECT_DRAW\n"
+    "layout(std430, binding = 0) readonly buffer ObjectTransforms { mat4 objectModels[]; };\n"
+    "in uint objectIndex; // Per instance, starting at the draw command's baseInstance\n"
+    "#endif\n"
     "out vec3 color;\n"
     "out vec2 texCoord;\n"
     "void main()\n"
     "{\n"
-    "    gl_Position = MVP * vec4(vPos, 1.0);\n"
+    "    mat4 objectModel = useInstances == 1 ? instanceModel : model;\n"
+    "#ifdef INDIRECT_DRAW\n"
+    "    if (useInstances == 2)\n"
+    "        objectModel = objectModels[objectIndex];\n"
+    "#endif\n"
+    "    gl_Position = viewProjection * (objectModel * vec4(vPos, 1.0));\n"
     "    color = vCol;\n"
-    "    texCoord = vTexCoord;\n"
+    "    texCoord = vec2(vTexCoord.x, 1.0 - vTexCoord.y); // Images are stored top row first\n"
     "}\n";
 
+// Compiled after the version line, VirtualTexture::shaderSource() and VideoTexture::shaderSource()
 static const char *fragment_shader_text =
-    "#version 330\n"
     "in vec3 color;\n"
     "in vec2 texCoord;\n"
     "out vec4 fragment;\n"
-    "uniform sampler2D textureSampler;\n"
+    "uniform sampler2DArray materialTextures;\n"
+    "uniform sampler2D streamedTexture;\n"
+    "uniform int materialLayer;\n"
     "uniform int useTexture;\n"
     "void main()\n"
     "{\n"
     "    if (useTexture == 1) {\n"
-    "        vec4 texColor = texture(textureSampler, texCoord);\n"
+    "        vec4 texColor = materialLayer == -3 ? sampleVideo(texCoord)\n"
+    "                      : materialLayer == -2 ? sampleVirtual(texCoord)\n"
+    "                      : materialLayer == -1 ? texture(streamedTexture, texCoord)\n"
+    "                                            : texture(materialTextures, vec3(texCoord, float(materialLayer)));\n"
     "        if (texColor.a < 0.1) {\n"
     "            fragment = vec4(0.5, 0.5, 0.5, 1.0); // Fallback color (gray)\n"
     "        } else {\n"
@@ -85,33 +175,75 @@ static const char *fragment_shader_text =
     "    }\n"
     "}\n";
 
-// Setup OpenGL buffers and shaders
-static void setupRendering(GLuint &program, GLint &mvp_location, GLint &vpos_location, GLint &vcol_location,
-                    GLuint &vertex_array, GLuint &vertex_buffer, GLuint &element_buffer,
-                    GLuint &planeVertexArray, GLuint &planeVertexBuffer, GLuint &planeElementBuffer)
+// Cubes on a roughly cubic grid standing on the plane, each with its own random spin. Entity i of
+// the grid draws from instance slot i.
+static void spawnCubeGrid(EntityStore &entities, int count, int material)
 {
-    ZoneScoped; // Tracy: Profile this function
-    // Cube setup
-    glGenBuffers(1, &vertex_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &element_buffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    const int side = static_cast<int>(std::ceil(std::cbrt(static_cast<double>(count))));
+    const float spacing = 2.0f;
+    const float offset = (side - 1) * spacing * 0.5f;
+    uint32_t seed = 0x9E3779B9u;
+    auto random = [&seed]()
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return (seed & 0xFFFFFF) / static_cast<float>(0x1000000);
+    };
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 position((i % side) * spacing - offset, (i / (side * side)) * spacing - 0.5f,
+                           ((i / side) % side) * spacing - offset);
+        glm::vec3 axis = glm::normalize(glm::vec3(random() - 0.5f, random() - 0.5f, random() - 0.5f) + glm::vec3(0.0f, 1e-3f, 0.0f));
+        entities.create(position, glm::angleAxis(random() * 6.2831853f, axis), glm::vec3(1.0f), Collider(),
+                        RenderHandle{material, i});
+    }
+}
 
-    // Plane setup
-    glGenBuffers(1, &planeVertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, planeVertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
+// Model matrix of every instanced entity in its instance slot
+static void gatherInstanceModels(const EntityStore &entities, size_t slotCount)
+{
+    instanceModels.assign(slotCount, glm::mat4(1.0f));
+    const RenderHandle *render = entities.renderHandles();
+    for (size_t i = 0; i < entities.size(); i++)
+    {
+        int slot = render[i].instance;
+        if (slot >= 0 && static_cast<size_t>(slot) < slotCount)
+            entities.writeModelMatrices(&instanceModels[slot], i, 1);
+    }
+}
 
-    glGenBuffers(1, &planeElementBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeElementBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(planeIndices), planeIndices, GL_STATIC_DRAW);
+// Transform, world box and mesh of every instanced entity, by instance slot, into the indirect batch
+static void uploadIndirectObjects(const EntityStore &entities, const BoxArrays &boxes, size_t slotCount,
+                                  const IndirectMesh &mesh)
+{
+    std::vector<glm::vec3> centers(slotCount, glm::vec3(0.0f)), extents(slotCount, glm::vec3(0.0f));
+    const RenderHandle *render = entities.renderHandles();
+    for (size_t i = 0; i < entities.size(); i++)
+    {
+        int slot = render[i].instance;
+        if (slot < 0 || static_cast<size_t>(slot) >= slotCount)
+            continue;
+        centers[slot] = glm::vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        extents[slot] = glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+    }
+    std::vector<IndirectMesh> meshes(slotCount, mesh);
+    indirectCubes->setObjects(instanceModels.data(), centers.data(), extents.data(), meshes.data(), slotCount);
+}
 
-    // Shaders
+// Setup OpenGL buffers and shaders
+static void setupRendering(GLuint &program, GLint &model_location, GLint &vpos_location, GLint &vcol_location,
+                    GLuint &vertex_array, GLuint &planeVertexArray)
+{
+    ZoneScoped; // Tracy: Profile this function
+    // Shaders; multi-draw indirect reads the cube transforms from a storage buffer, which needs GLSL 4.30
+    const bool indirectDraw = useIndirectDraw && cubeCount > 0 && IndirectBatch::supported();
+    if (useIndirectDraw && !IndirectBatch::supported())
+        spdlog::warn("Multi-draw indirect needs OpenGL 4.3, drawing the cubes instanced instead");
+    const char *shaderHeader = indirectDraw ? "#version 430\n#define INDIRECT_DRAW\n" : "#version 330\n";
     GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &vertex_shader_text, NULL);
+    const char *vertex_sources[] = {shaderHeader, CameraUniforms::shaderSource(), vertex_shader_text};
+    glShaderSource(vertex_shader, 3, vertex_sources, NULL);
     glCompileShader(vertex_shader);
 
     GLint success;
@@ -124,7 +256,9 @@ static void setupRendering(GLuint &program, GLint &mvp_location, GLint &vpos_loc
     }
 
     GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 1, &fragment_shader_text, NULL);
+    const char *fragment_sources[] = {shaderHeader, VirtualTexture::shaderSource(), VideoTexture::shaderSource(),
+                                      fragment_shader_text};
+    glShaderSource(fragment_shader, 4, fragment_sources, NULL);
     glCompileShader(fragment_shader);
 
     glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
@@ -148,59 +282,156 @@ static void setupRendering(GLuint &program, GLint &mvp_location, GLint &vpos_loc
         spdlog::error("Shader program linking failed: {}", infoLog);
     }
 
-    mvp_location = glGetUniformLocation(program, "MVP");
+    cameraUniforms = std::make_unique<CameraUniforms>();
+    renderQueue = std::make_unique<RenderQueue>();
+    commandRecorder = std::make_unique<CommandRecorder>(static_cast<unsigned>(recordThreads));
+    spdlog::info("Recording draws on {} threads", commandRecorder->threadCount());
+    CameraUniforms::bindProgram(program);
+
+    model_location = glGetUniformLocation(program, "model");
     vpos_location = glGetAttribLocation(program, "vPos");
     vcol_location = glGetAttribLocation(program, "vCol");
     GLint vtex_location = glGetAttribLocation(program, "vTexCoord");
-    GLint textureLocation = glGetUniformLocation(program, "textureSampler");
+    GLint textureLocation = glGetUniformLocation(program, "materialTextures");
+    materialLayerLocation = glGetUniformLocation(program, "materialLayer");
+    GLint streamedTextureLocation = glGetUniformLocation(program, "streamedTexture");
     GLint useTextureLocation = glGetUniformLocation(program, "useTexture");
+    useInstancesLocation = glGetUniformLocation(program, "useInstances");
+
+    // Cube and plane: packed vertices, attributes bound by name from the vertex format. With a virtual
+    // ground the cube also gets a position stream, to occlude the ground in the feedback pass.
+    const bool cubeOccludesGround = !virtualTexturePath.empty();
+    cubeMesh = buildMesh<PackedVertex>(vertices, 8, indices, 36, program, cubeOccludesGround);
+    planeMesh = buildMesh<PackedVertex>(planeVertices, 6, planeIndices, 6, program);
+    vertex_array = cubeMesh.vertexArray;
+    planeVertexArray = planeMesh.vertexArray;
+
+    // Ground texture: mip tail now, larger levels over the next frames
+    textureStreamer = std::make_unique<TextureStreamer>();
+    textureStreamer->setMemoryBudget(textureMemoryBudget);
+    groundTexture = textureStreamer->request("resources/textures/wood");
+
+    // Material textures go into array layers sized for exactly the materials used
+    std::vector<std::string> materialPaths = {"resources/textures/concrete"};
+    if (!groundTexture)
+        materialPaths.push_back("resources/textures/wood");
+    materialTextures = std::make_unique<TextureArray>(materialPaths);
+    cubeMaterial = std::max(materialTextures->layer("resources/textures/concrete"), 0);
+    planeMaterial = groundTexture ? -1 : std::max(materialTextures->layer("resources/textures/wood"), 0);
+
+    // Hot reload: decode + mips on the reloader's worker, only the upload happens here
+    textureReloader = std::make_unique<TextureReloader>(resourceWatchDirectory);
+    TextureArray *materials = materialTextures.get();
+    auto trackLayer = [materials](const std::string &path, int layer)
+    {
+        reloadTargets.push_back(textureReloader->track(
+            path, [materials](const DecodedImage &image)
+            { return materials->prepareLayer(image.data(), image.width, image.height, 4); },
+            [materials, layer](const std::vector<MipLevel> &levels)
+            { materials->replaceLayer(layer, levels); }));
+    };
+    trackLayer("resources/textures/concrete.jpg", cubeMaterial);
+    if (groundTexture)
+    {
+        reloadTargets.push_back(textureReloader->track(
+            "resources/textures/wood.jpg", [](const DecodedImage &image)
+            { return buildMipChain(image.data(), image.width, image.height, 4); },
+            [](const std::vector<MipLevel> &levels)
+            { textureStreamer->replace(*groundTexture, levels); }));
+    }
+    else
+    {
+        trackLayer("resources/textures/wood.jpg", planeMaterial);
+    }
+
+    if (!virtualTexturePath.empty())
+    {
+        groundVirtualTexture = std::make_unique<VirtualTexture>(virtualTexturePath, vpos_location, vtex_location);
+        if (groundVirtualTexture->valid())
+            planeMaterial = -2;
+        else
+            groundVirtualTexture.reset();
+    }
+
+    if (!videoPath.empty())
+    {
+        cubeVideo = std::make_unique<VideoTexture>(videoPath, videoRawWidth, videoRawHeight);
+        if (cubeVideo->valid())
+            cubeMaterial = -3;
+        else
+            cubeVideo.reset();
+    }
 
-    // Cube VAO
-    glGenVertexArrays(1, &vertex_array);
-    glBindVertexArray(vertex_array);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, pos));
-    glEnableVertexAttribArray(vcol_location);
-    glVertexAttribPointer(vcol_location, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, col));
-    // Enable texture coordinates for the cube
-    glEnableVertexAttribArray(vtex_location);
-    glVertexAttribPointer(vtex_location, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, texCoord));
-
-    // Plane VAO
-    glGenVertexArrays(1, &planeVertexArray);
-    glBindVertexArray(planeVertexArray);
-    glBindBuffer(GL_ARRAY_BUFFER, planeVertexBuffer);
-    glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, pos));
-    glEnableVertexAttribArray(vcol_location);
-    glVertexAttribPointer(vcol_location, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, col));
-    glEnableVertexAttribArray(vtex_location);
-    glVertexAttribPointer(vtex_location, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, texCoord));
-
-    // Load texture
-    std::map<std::string, std::string> textureMap = {
-        {"plane", "resources\\textures\\wood.jpg"},
-        {"cube", "resources\\textures\\concrete.jpg"}};
-
-    for (const auto &[textureName, texturePath] : textureMap)
-    {
-        if (textureName == "plane")
+    if (cubeCount > 0)
+        spawnCubeGrid(scene.entities, cubeCount, cubeMaterial);
+    updateWorldBoxes(scene.entities, 0, scene.entities.size(), entityBoxes);
+    if (cubeCount > 0)
+    {
+        gatherInstanceModels(scene.entities, cubeCount);
+        if (indirectDraw)
         {
-            loadTexture(texturePath.c_str(), planeTexture);
+            indirectCubes = std::make_unique<IndirectBatch>(cubeMesh, program, glGetAttribLocation(program, "objectIndex"),
+                                                            cubeCount);
+            uploadIndirectObjects(scene.entities, entityBoxes, cubeCount,
+                                  IndirectMesh{static_cast<GLuint>(cubeMesh.indexCount), 0, 0});
+            visibleInstanceSlots.resize(cubeCount);
+            spdlog::info("Instanced cubes: {} (multi-draw indirect, culled on the {})", cubeCount,
+                         useGpuCulling ? "GPU" : "CPU");
         }
-        else if (textureName == "cube")
+        else
         {
-            loadTexture(texturePath.c_str(), cubeTexture);
+            cubeInstances = std::make_unique<InstancedMesh>(cubeMesh, program, glGetAttribLocation(program, "instanceModel"),
+                                                            cubeCount);
+            spdlog::info("Instanced cubes: {}", cubeCount);
         }
     }
 
+    // Parsed, optimized and cached on a worker; the batches switch to it when it has been uploaded.
+    // It is fit into the unit cube, so the cubes' boxes still bound it.
+    if (!meshPath.empty())
+    {
+        if (cubeCount == 0)
+            spdlog::warn("--mesh replaces the extra cubes, add some with --cubes");
+        auto useImportedMesh = [program](const ImportedMesh &imported)
+        {
+            if (!imported.mesh.vertexArray)
+                return;
+            destroyMesh(importedMesh);
+            importedMesh = imported.mesh;
+            if (cubeInstances)
+                cubeInstances->setMesh(importedMesh, program);
+            if (indirectCubes)
+            {
+                indirectCubes->setMesh(importedMesh, program);
+                std::vector<IndirectMesh> meshes(indirectCubes->count(),
+                                                 IndirectMesh{static_cast<GLuint>(importedMesh.indexCount), 0, 0});
+                indirectCubes->setObjectMeshes(meshes.data(), meshes.size());
+            }
+        };
+        meshImporter = std::make_unique<MeshImporter>(meshCacheDirectory);
+        meshImporter->request(meshPath, program, useImportedMesh);
+    }
+    visibleEntities.resize(scene.entities.size());
+    entityRenderHandles.assign(scene.entities.renderHandles(), scene.entities.renderHandles() + scene.entities.size());
+    scene.bvh.build(entityBoxes);
+    cullingBvh.build(entityBoxes);
+
+    screenshotCapture = std::make_unique<ScreenshotCapture>();
+
     // Cleanup
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
-    glUseProgram(program);
+    glState().useProgram(program);
     glUniform1i(useTextureLocation, 1);
     glUniform1i(textureLocation, 0);
+    glUniform1i(streamedTextureLocation, 1);
+    // Samplers of different types may not share a unit, even unused ones: park the virtual texture and
+    // video samplers on their own units up front instead of waiting for bind()
+    glUniform1i(glGetUniformLocation(program, "vtPageTable"), 2);
+    glUniform1i(glGetUniformLocation(program, "vtCache"), 3);
+    glUniform1i(glGetUniformLocation(program, "videoLuma"), 4);
+    glUniform1i(glGetUniformLocation(program, "videoChromaU"), 5);
+    glUniform1i(glGetUniformLocation(program, "videoChromaV"), 6);
 }
 
 // Initialize text renderer
@@ -209,7 +440,7 @@ static void initializeTextRenderer(TextRenderer *&textRenderer)
     ZoneScoped; // Tracy: Profile this function
     try
     {
-        std::string fontPath = "resources\\fonts\\arlrbd.ttf";
+        std::string fontPath = "resources/fonts/arlrbd.ttf";
         spdlog::info("Font path: {}", fontPath);
 
         textRenderer = new TextRenderer(fontPath.c_str(), 32);
@@ -0,0 +1,309 @@
+#include "gl_state.h"
+
+#include <algorithm>
+
+static const GLenum bufferTargets[] = {GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER,
+                                       GL_DRAW_INDIRECT_BUFFER, GL_PARAMETER_BUFFER, GL_PIXEL_PACK_BUFFER,
+                                       GL_PIXEL_UNPACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER};
+static const GLenum capabilityNames[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST};
+
+size_t GLStateCache::Counts::totalIssued() const
+{
+    size_t total = 0;
+    for (size_t count : issued)
+        total += count;
+    return total;
+}
+
+size_t GLStateCache::Counts::totalElided() const
+{
+    size_t total = 0;
+    for (size_t count : elided)
+        total += count;
+    return total;
+}
+
+GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+void GLStateCache::invalidate()
+{
+    program = unknown;
+    vertexArray = unknown;
+    elementBuffer = unknown;
+    elementBuffers.clear();
+    std::fill(std::begin(buffers), std::end(buffers), unknown);
+    std::fill(std::begin(uniformBuffers), std::end(uniformBuffers), unknown);
+    std::fill(std::begin(storageBuffers), std::end(storageBuffers), unknown);
+    activeUnit = unknown;
+    for (auto &unit : textures)
+        std::fill(std::begin(unit), std::end(unit), unknown);
+    std::fill(std::begin(capabilities), std::end(capabilities), -1);
+    blendSource = blendDestination = unknown;
+    drawFramebuffer = readFramebuffer = unknown;
+    viewportKnown = false;
+}
+
+int GLStateCache::bufferSlot(GLenum target)
+{
+    for (int i = 0; i < bufferTargetCount; i++)
+        if (bufferTargets[i] == target)
+            return i;
+    return -1;
+}
+
+int GLStateCache::textureSlot(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D:
+        return 0;
+    case GL_TEXTURE_2D_ARRAY:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+int GLStateCache::capabilitySlot(GLenum capability)
+{
+    for (int i = 0; i < capabilityCount; i++)
+        if (capabilityNames[i] == capability)
+            return i;
+    return -1;
+}
+
+// Count the call one way or the other; true when it can be skipped
+bool GLStateCache::skip(Kind kind, bool unchanged)
+{
+    if (unchanged)
+        current.elided[kind]++;
+    else
+        current.issued[kind]++;
+    return unchanged;
+}
+
+void GLStateCache::useProgram(GLuint newProgram)
+{
+    if (skip(Program, program == newProgram))
+        return;
+    glUseProgram(newProgram);
+    program = newProgram;
+}
+
+void GLStateCache::bindVertexArray(GLuint newVertexArray)
+{
+    if (skip(VertexArray, vertexArray == newVertexArray))
+        return;
+    glBindVertexArray(newVertexArray);
+    vertexArray = newVertexArray;
+    auto it = elementBuffers.find(newVertexArray);
+    elementBuffer = it != elementBuffers.end() ? it->second : unknown;
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (skip(Buffer, elementBuffer == buffer))
+            return;
+        glBindBuffer(target, buffer);
+        elementBuffer = buffer;
+        if (vertexArray != unknown)
+            elementBuffers[vertexArray] = buffer;
+        return;
+    }
+
+    int slot = bufferSlot(target);
+    if (skip(Buffer, slot >= 0 && buffers[slot] == buffer))
+        return;
+    glBindBuffer(target, buffer);
+    if (slot >= 0)
+        buffers[slot] = buffer;
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    GLuint *indexed = nullptr;
+    if (index < static_cast<GLuint>(indexedBindingCount))
+    {
+        if (target == GL_UNIFORM_BUFFER)
+            indexed = &uniformBuffers[index];
+        else if (target == GL_SHADER_STORAGE_BUFFER)
+            indexed = &storageBuffers[index];
+    }
+    // Skipping also leaves the generic binding alone, which the shadow still describes
+    if (skip(Buffer, indexed && *indexed == buffer))
+        return;
+    glBindBufferBase(target, index, buffer);
+    if (indexed)
+        *indexed = buffer;
+    int slot = bufferSlot(target);
+    if (slot >= 0)
+        buffers[slot] = buffer;
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+    if (activeUnit == unknown)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        current.issued[Texture]++;
+        activeUnit = 0;
+    }
+    bindTexture(activeUnit, target, texture);
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    int slot = textureSlot(target);
+    bool tracked = slot >= 0 && unit < static_cast<GLuint>(textureUnitCount);
+    if (skip(Texture, tracked && textures[unit][slot] == texture))
+        return;
+    if (activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        current.issued[Texture]++;
+        activeUnit = unit;
+    }
+    glBindTexture(target, texture);
+    if (tracked)
+        textures[unit][slot] = texture;
+}
+
+void GLStateCache::setCapability(GLenum capability, bool enabled)
+{
+    int slot = capabilitySlot(capability);
+    if (skip(Capability, slot >= 0 && capabilities[slot] == static_cast<int>(enabled)))
+        return;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+    if (slot >= 0)
+        capabilities[slot] = enabled;
+}
+
+void GLStateCache::enable(GLenum capability)
+{
+    setCapability(capability, true);
+}
+
+void GLStateCache::disable(GLenum capability)
+{
+    setCapability(capability, false);
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+    if (skip(Blend, blendSource == source && blendDestination == destination))
+        return;
+    glBlendFunc(source, destination);
+    blendSource = source;
+    blendDestination = destination;
+}
+
+void GLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+    if (skip(Framebuffer, (!draw || drawFramebuffer == framebuffer) && (!read || readFramebuffer == framebuffer)))
+        return;
+    glBindFramebuffer(target, framebuffer);
+    if (draw)
+        drawFramebuffer = framebuffer;
+    if (read)
+        readFramebuffer = framebuffer;
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (skip(Viewport, viewportKnown && viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width &&
+                           viewportRect[3] == height))
+        return;
+    glViewport(x, y, width, height);
+    viewportRect[0] = x;
+    viewportRect[1] = y;
+    viewportRect[2] = width;
+    viewportRect[3] = height;
+    viewportKnown = true;
+}
+
+// Deleted names are recycled by the next glGen*, so every shadow holding one goes back to unknown
+
+void GLStateCache::deleteProgram(GLuint deleted)
+{
+    if (program == deleted)
+        program = unknown;
+    glDeleteProgram(deleted);
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei count, const GLuint *vertexArrays)
+{
+    for (GLsizei i = 0; i < count; i++)
+    {
+        elementBuffers.erase(vertexArrays[i]);
+        if (vertexArray == vertexArrays[i])
+            vertexArray = elementBuffer = unknown;
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLStateCache::deleteBuffers(GLsizei count, const GLuint *deleted)
+{
+    auto forget = [&](GLuint &binding)
+    {
+        for (GLsizei i = 0; i < count; i++)
+            if (binding == deleted[i])
+                binding = unknown;
+    };
+    forget(elementBuffer);
+    for (GLuint &binding : buffers)
+        forget(binding);
+    for (GLuint &binding : uniformBuffers)
+        forget(binding);
+    for (GLuint &binding : storageBuffers)
+        forget(binding);
+    for (auto it = elementBuffers.begin(); it != elementBuffers.end();)
+    {
+        if (std::find(deleted, deleted + count, it->second) != deleted + count)
+            it = elementBuffers.erase(it);
+        else
+            ++it;
+    }
+    glDeleteBuffers(count, deleted);
+}
+
+void GLStateCache::deleteTextures(GLsizei count, const GLuint *deleted)
+{
+    for (auto &unit : textures)
+        for (GLuint &binding : unit)
+            if (std::find(deleted, deleted + count, binding) != deleted + count)
+                binding = unknown;
+    glDeleteTextures(count, deleted);
+}
+
+void GLStateCache::deleteFramebuffers(GLsizei count, const GLuint *deleted)
+{
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (drawFramebuffer == deleted[i])
+            drawFramebuffer = unknown;
+        if (readFramebuffer == deleted[i])
+            readFramebuffer = unknown;
+    }
+    glDeleteFramebuffers(count, deleted);
+}
+
+void GLStateCache::endFrame()
+{
+    finished = current;
+    current = Counts();
+}
+
+GLStateCache &glState()
+{
+    static GLStateCache cache;
+    return cache;
+}
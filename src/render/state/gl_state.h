@@ -0,0 +1,110 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <unordered_map>
+
+// Shadow of the GL bindings and fixed-function state the renderer changes: bound program, vertex
+// array, buffers (the element buffer per vertex array, since it is vertex array state), textures per
+// unit, enabled capabilities, blend function, framebuffer and viewport. A call that would not change
+// anything is skipped, so draw code can state what it needs instead of saving and restoring.
+//
+// Every change to tracked state has to go through the cache, or the shadow goes stale; deletes too,
+// because GL unbinds deleted objects and recycles their names. Code that touches state behind its
+// back calls invalidate(). GL thread only.
+class GLStateCache
+{
+public:
+    enum Kind
+    {
+        Program,
+        VertexArray,
+        Buffer,
+        Texture,
+        Capability,
+        Blend,
+        Framebuffer,
+        Viewport,
+        KindCount
+    };
+
+    // GL calls made and skipped, by kind
+    struct Counts
+    {
+        size_t issued[KindCount] = {};
+        size_t elided[KindCount] = {};
+
+        size_t totalIssued() const;
+        size_t totalElided() const;
+    };
+
+    GLStateCache();
+
+    // Forget everything: the next call of each kind reaches GL
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer); // Also the generic binding, as in GL
+
+    // On the active unit, for uploads: whichever unit that is, the shadow follows
+    void bindTexture(GLenum target, GLuint texture);
+    // On a given unit; the active unit only changes when the binding does
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void blendFunc(GLenum source, GLenum destination);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    void deleteProgram(GLuint program);
+    void deleteVertexArrays(GLsizei count, const GLuint *vertexArrays);
+    void deleteBuffers(GLsizei count, const GLuint *buffers);
+    void deleteTextures(GLsizei count, const GLuint *textures);
+    void deleteFramebuffers(GLsizei count, const GLuint *framebuffers);
+
+    // Close the frame's counts; lastFrame() reports them until the next endFrame()
+    void endFrame();
+    const Counts &lastFrame() const { return finished; }
+
+private:
+    static const GLuint unknown = ~0u;
+    static const int bufferTargetCount = 9;
+    static const int indexedBindingCount = 16;
+    static const int textureUnitCount = 16;
+    static const int textureTargetCount = 2; // 2D, 2D array
+    static const int capabilityCount = 5;
+
+    // Shadow slot of a target, or -1 when it is passed through untracked
+    static int bufferSlot(GLenum target);
+    static int textureSlot(GLenum target);
+    static int capabilitySlot(GLenum capability);
+    void setCapability(GLenum capability, bool enabled);
+    bool skip(Kind kind, bool unchanged);
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint elementBuffer; // Of the bound vertex array
+    std::unordered_map<GLuint, GLuint> elementBuffers; // Vertex array -> element buffer set through the cache
+    GLuint buffers[bufferTargetCount];
+    GLuint uniformBuffers[indexedBindingCount];
+    GLuint storageBuffers[indexedBindingCount];
+    GLuint activeUnit;
+    GLuint textures[textureUnitCount][textureTargetCount];
+    int capabilities[capabilityCount]; // 0 off, 1 on, -1 unknown
+    GLenum blendSource, blendDestination;
+    GLuint drawFramebuffer, readFramebuffer;
+    GLint viewportRect[4];
+    bool viewportKnown;
+
+    Counts current;
+    Counts finished;
+};
+
+// The cache of the one GL context this renderer uses
+GLStateCache &glState();
+
+#endif /* GL_STATE_H */
@@ -1,4 +1,7 @@
 #include "text_renderer.h"
+#include "../../io/resource_loader.h"
+#include "../texture/texture_memory.h"
+#include "../state/gl_state.h"
 
 
 static const char *vertexShaderSource = R"(
@@ -34,8 +37,11 @@ TextRenderer::TextRenderer(const char *fontPath, GLuint fontSize)
         throw std::runtime_error("Could not init FreeType Library");
     }
 
+    // Font bytes must stay alive until FT_Done_Face
+    ResourceData font;
     FT_Face face;
-    if (FT_New_Face(ft, fontPath, 0, &face))
+    if (!loadResource(fontPath, font) ||
+        FT_New_Memory_Face(ft, font.data, static_cast<FT_Long>(font.size), 0, &face))
     {
         FT_Done_FreeType(ft);
         throw std::runtime_error("Failed to load font: " + std::string(fontPath));
@@ -54,7 +60,7 @@ TextRenderer::TextRenderer(const char *fontPath, GLuint fontSize)
 
         GLuint texture;
         glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        glState().bindTexture(GL_TEXTURE_2D, texture);
         glTexImage2D(
             GL_TEXTURE_2D,
             0,
@@ -65,6 +71,7 @@ TextRenderer::TextRenderer(const char *fontPath, GLuint fontSize)
             GL_RED,
             GL_UNSIGNED_BYTE,
             face->glyph->bitmap.buffer);
+        trackTextureMemory(texture, textureLevelBytes(GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows));
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -84,13 +91,13 @@ TextRenderer::TextRenderer(const char *fontPath, GLuint fontSize)
 
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glState().bindVertexArray(VAO);
+    glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+    glState().bindVertexArray(0);
 
     initializeShader();
     spdlog::info("TextRenderer constructor completed");
@@ -98,12 +105,13 @@ TextRenderer::TextRenderer(const char *fontPath, GLuint fontSize)
 
 TextRenderer::~TextRenderer()
 {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    glState().deleteVertexArrays(1, &VAO);
+    glState().deleteBuffers(1, &VBO);
+    glState().deleteProgram(shaderProgram);
     for (auto &charPair : characters)
     {
-        glDeleteTextures(1, &charPair.second.textureID);
+        untrackTextureMemory(charPair.second.textureID);
+        glState().deleteTextures(1, &charPair.second.textureID);
     }
 }
 
@@ -126,13 +134,15 @@ void TextRenderer::initializeShader()
     glDeleteShader(fragmentShader);
 }
 
+// Only sets the state it needs and restores nothing: consecutive strings cost no state changes, and
+// whoever draws next states what it needs through the same cache
 void TextRenderer::renderText(std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
 {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_DEPTH_TEST);
+    glState().enable(GL_BLEND);
+    glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState().disable(GL_DEPTH_TEST);
 
-    glUseProgram(shaderProgram);
+    glState().useProgram(shaderProgram);
 
     GLint textColorLoc = glGetUniformLocation(shaderProgram, "textColor");
     glUniform3fv(textColorLoc, 1, glm::value_ptr(color));
@@ -144,8 +154,8 @@ void TextRenderer::renderText(std::string text, GLfloat x, GLfloat y, GLfloat sc
     glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(width), 0.0f, static_cast<GLfloat>(height));
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
+    glState().bindVertexArray(VAO);
+    glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     for (const char &c : text)
     {
@@ -165,17 +175,10 @@ void TextRenderer::renderText(std::string text, GLfloat x, GLfloat y, GLfloat sc
             {xpos + w, ypos, 1.0f, 1.0f},
             {xpos + w, ypos + h, 1.0f, 0.0f}};
 
-        glBindTexture(GL_TEXTURE_2D, ch.textureID);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glState().bindTexture(0, GL_TEXTURE_2D, ch.textureID);
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
         x += (ch.advance >> 6) * scale;
     }
-
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
 }
\ No newline at end of file
@@ -0,0 +1,307 @@
+#ifndef BC_ENCODER_H
+#define BC_ENCODER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Block compression (BC1 / BC7 mode 6) for RGBA8 images.
+// Every 4x4 texel block is fitted along its principal color axis; edge blocks replicate the last row/column.
+
+static const int bc1BlockBytes = 8;
+static const int bc7BlockBytes = 16;
+
+// Gather a 4x4 RGBA block, clamping reads at the image border
+inline void fetchBlockRGBA(const uint8_t *rgba, int width, int height, int blockX, int blockY, uint8_t block[16][4])
+{
+    for (int y = 0; y < 4; y++)
+    {
+        int sy = std::min(blockY * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++)
+        {
+            int sx = std::min(blockX * 4 + x, width - 1);
+            std::memcpy(block[y * 4 + x], rgba + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+        }
+    }
+}
+
+// Principal axis fit: returns the two extreme colors of the block along its dominant direction
+inline void fitPrincipalAxis(const uint8_t block[16][4], int channels, float minColor[4], float maxColor[4])
+{
+    float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < channels; c++)
+            mean[c] += block[i][c];
+    for (int c = 0; c < channels; c++)
+        mean[c] /= 16.0f;
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        float d[4];
+        for (int c = 0; c < channels; c++)
+            d[c] = block[i][c] - mean[c];
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                cov[a][b] += d[a] * d[b];
+    }
+
+    // Power iteration, seeded with the diagonal so flat blocks still converge
+    float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int c = 0; c < channels; c++)
+        axis[c] = cov[c][c] + 1.0f;
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                next[a] += cov[a][b] * axis[b];
+        float length = 0.0f;
+        for (int c = 0; c < channels; c++)
+            length = std::max(length, std::abs(next[c]));
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < channels; c++)
+            axis[c] = next[c] / length;
+    }
+
+    float minProj = 1e30f, maxProj = -1e30f;
+    for (int i = 0; i < 16; i++)
+    {
+        float proj = 0.0f;
+        for (int c = 0; c < channels; c++)
+            proj += (block[i][c] - mean[c]) * axis[c];
+        minProj = std::min(minProj, proj);
+        maxProj = std::max(maxProj, proj);
+    }
+
+    float axisLengthSq = 0.0f;
+    for (int c = 0; c < channels; c++)
+        axisLengthSq += axis[c] * axis[c];
+    if (axisLengthSq < 1e-12f)
+        axisLengthSq = 1.0f;
+
+    for (int c = 0; c < channels; c++)
+    {
+        minColor[c] = std::clamp(mean[c] + axis[c] * minProj / axisLengthSq, 0.0f, 255.0f);
+        maxColor[c] = std::clamp(mean[c] + axis[c] * maxProj / axisLengthSq, 0.0f, 255.0f);
+    }
+    for (int c = channels; c < 4; c++)
+    {
+        minColor[c] = 255.0f;
+        maxColor[c] = 255.0f;
+    }
+}
+
+inline uint16_t packRGB565(const float color[3])
+{
+    int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+inline int colorDistanceSq(const uint8_t *a, const int *b, int channels)
+{
+    int sum = 0;
+    for (int c = 0; c < channels; c++)
+    {
+        int d = a[c] - b[c];
+        sum += d * d;
+    }
+    return sum;
+}
+
+// BC1 (opaque, four color mode)
+inline void encodeBlockBC1(const uint8_t block[16][4], uint8_t out[8])
+{
+    float minColor[4], maxColor[4];
+    fitPrincipalAxis(block, 3, minColor, maxColor);
+
+    // Inset the endpoints slightly, the outer palette entries are rarely hit exactly
+    for (int c = 0; c < 3; c++)
+    {
+        float inset = (maxColor[c] - minColor[c]) / 16.0f;
+        minColor[c] = std::clamp(minColor[c] + inset, 0.0f, 255.0f);
+        maxColor[c] = std::clamp(maxColor[c] - inset, 0.0f, 255.0f);
+    }
+
+    uint16_t c0 = packRGB565(maxColor);
+    uint16_t c1 = packRGB565(minColor);
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        int palette[4][3];
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestError = colorDistanceSq(block[i], palette[0], 3);
+            for (int p = 1; p < 4; p++)
+            {
+                int error = colorDistanceSq(block[i], palette[p], 3);
+                if (error < bestError)
+                {
+                    best = p;
+                    bestError = error;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(c0 & 0xFF);
+    out[1] = static_cast<uint8_t>(c0 >> 8);
+    out[2] = static_cast<uint8_t>(c1 & 0xFF);
+    out[3] = static_cast<uint8_t>(c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+}
+
+// Little-endian bit writer for 128-bit BC7 blocks
+struct BC7BlockWriter
+{
+    uint8_t *bytes;
+    int bitPosition = 0;
+
+    void write(uint32_t value, int bitCount)
+    {
+        for (int i = 0; i < bitCount; i++, bitPosition++)
+        {
+            if ((value >> i) & 1u)
+                bytes[bitPosition >> 3] |= static_cast<uint8_t>(1u << (bitPosition & 7));
+        }
+    }
+};
+
+// Quantize an 8-bit RGBA endpoint to 7 bits per channel plus a shared p-bit
+inline void quantizeEndpointMode6(const float color[4], int quantized[4], int &pBit)
+{
+    int bestError = -1;
+    for (int p = 0; p < 2; p++)
+    {
+        int candidate[4], error = 0;
+        for (int c = 0; c < 4; c++)
+        {
+            candidate[c] = std::clamp(static_cast<int>((color[c] - p) / 2.0f + 0.5f), 0, 127);
+            int d = static_cast<int>(color[c] + 0.5f) - ((candidate[c] << 1) | p);
+            error += d * d;
+        }
+        if (bestError < 0 || error < bestError)
+        {
+            bestError = error;
+            pBit = p;
+            std::memcpy(quantized, candidate, sizeof(candidate));
+        }
+    }
+}
+
+// BC7 mode 6: single subset, RGBA 7.7.7.7 endpoints with p-bits, 4-bit indices
+inline void encodeBlockBC7(const uint8_t block[16][4], uint8_t out[16])
+{
+    static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    float minColor[4], maxColor[4];
+    fitPrincipalAxis(block, 4, minColor, maxColor);
+
+    int endpoints[2][4], pBits[2];
+    quantizeEndpointMode6(minColor, endpoints[0], pBits[0]);
+    quantizeEndpointMode6(maxColor, endpoints[1], pBits[1]);
+
+    int palette[16][4];
+    for (int c = 0; c < 4; c++)
+    {
+        int e0 = (endpoints[0][c] << 1) | pBits[0];
+        int e1 = (endpoints[1][c] << 1) | pBits[1];
+        for (int w = 0; w < 16; w++)
+            palette[w][c] = ((64 - weights[w]) * e0 + weights[w] * e1 + 32) >> 6;
+    }
+
+    int indices[16];
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0, bestError = colorDistanceSq(block[i], palette[0], 4);
+        for (int p = 1; p < 16; p++)
+        {
+            int error = colorDistanceSq(block[i], palette[p], 4);
+            if (error < bestError)
+            {
+                best = p;
+                bestError = error;
+            }
+        }
+        indices[i] = best;
+    }
+
+    // The anchor index is stored with an implicit zero MSB; swap endpoints if needed
+    if (indices[0] & 8)
+    {
+        std::swap(endpoints[0], endpoints[1]);
+        std::swap(pBits[0], pBits[1]);
+        for (int &index : indices)
+            index = 15 - index;
+    }
+
+    std::memset(out, 0, 16);
+    BC7BlockWriter writer{out};
+    writer.write(1u << 6, 7); // Mode 6
+    for (int c = 0; c < 4; c++)
+    {
+        writer.write(endpoints[0][c], 7);
+        writer.write(endpoints[1][c], 7);
+    }
+    writer.write(pBits[0], 1);
+    writer.write(pBits[1], 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        writer.write(indices[i], 4);
+}
+
+inline size_t compressedLevelSize(int width, int height, int blockBytes)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+// Compress a whole RGBA8 image into BC1 or BC7 blocks (row-major block order)
+inline std::vector<uint8_t> compressImageBC(const uint8_t *rgba, int width, int height, bool bc7)
+{
+    int blockBytes = bc7 ? bc7BlockBytes : bc1BlockBytes;
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<uint8_t> out(compressedLevelSize(width, height, blockBytes));
+
+    uint8_t block[16][4];
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            fetchBlockRGBA(rgba, width, height, bx, by, block);
+            uint8_t *dst = out.data() + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+            if (bc7)
+                encodeBlockBC7(block, dst);
+            else
+                encodeBlockBC1(block, dst);
+        }
+    }
+    return out;
+}
+
+#endif /* BC_ENCODER_H */
@@ -0,0 +1,357 @@
+#include "block_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include "bc_encoder.h"
+#include "parallel_rows.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BLOCK_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_SSE2 1
+#endif
+
+// Interior blocks are four 16-byte row copies; only edge blocks need the clamping fetch
+static void loadBlock(const uint8_t *rgba, int width, int height, int blockX, int blockY, uint8_t block[16][4])
+{
+    if (blockX * 4 + 4 > width || blockY * 4 + 4 > height)
+    {
+        fetchBlockRGBA(rgba, width, height, blockX, blockY, block);
+        return;
+    }
+    for (int y = 0; y < 4; y++)
+        std::memcpy(block[y * 4], rgba + ((static_cast<size_t>(blockY) * 4 + y) * width + blockX * 4) * 4, 16);
+}
+
+// indices[i] = round(bias + dot(texel i, weights)) clamped to [0, maxIndex]. Each texel is one 32-bit
+// lane, so channels are split with shifts and masks instead of a transpose.
+static void projectBlock(const uint8_t block[16][4], const float weights[4], float bias, int maxIndex, int indices[16])
+{
+#if defined(BLOCK_AVX2)
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256 w0 = _mm256_set1_ps(weights[0]), w1 = _mm256_set1_ps(weights[1]);
+    const __m256 w2 = _mm256_set1_ps(weights[2]), w3 = _mm256_set1_ps(weights[3]);
+    const __m256 lo = _mm256_setzero_ps(), hi = _mm256_set1_ps(static_cast<float>(maxIndex));
+    for (int i = 0; i < 16; i += 8)
+    {
+        __m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block[i]));
+        __m256 t = _mm256_set1_ps(bias);
+        t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(texels, mask)), w0));
+        t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, 8), mask)), w1));
+        t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, 16), mask)), w2));
+        t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(texels, 24)), w3));
+        t = _mm256_min_ps(_mm256_max_ps(t, lo), hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(indices + i), _mm256_cvtps_epi32(t));
+    }
+#elif defined(BLOCK_SSE2)
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128 w0 = _mm_set1_ps(weights[0]), w1 = _mm_set1_ps(weights[1]);
+    const __m128 w2 = _mm_set1_ps(weights[2]), w3 = _mm_set1_ps(weights[3]);
+    const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(static_cast<float>(maxIndex));
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block[i]));
+        __m128 t = _mm_set1_ps(bias);
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(texels, mask)), w0));
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8), mask)), w1));
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 16), mask)), w2));
+        t = _mm_add_ps(t, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(texels, 24)), w3));
+        t = _mm_min_ps(_mm_max_ps(t, lo), hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(indices + i), _mm_cvtps_epi32(t));
+    }
+#else
+    for (int i = 0; i < 16; i++)
+    {
+        float t = bias;
+        for (int c = 0; c < 4; c++)
+            t += block[i][c] * weights[c];
+        indices[i] = static_cast<int>(std::clamp(t, 0.0f, static_cast<float>(maxIndex)) + 0.5f);
+    }
+#endif
+}
+
+#if defined(BLOCK_SSE2)
+static float horizontalSum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static float horizontalMin(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static float horizontalMax(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+// fitPrincipalAxis() with the mean, covariance and projections computed four texels at a time.
+// Only the 4x4 power iteration stays scalar.
+static void fitBlockAxis(const uint8_t block[16][4], int channels, float minColor[4], float maxColor[4])
+{
+#if defined(BLOCK_SSE2)
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128 texels[4][4]; // [channel][group of four texels], centered on the mean below
+    float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int g = 0; g < 4; g++)
+    {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block[g * 4]));
+        for (int c = 0; c < channels; c++)
+            texels[c][g] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 8 * c), mask));
+    }
+    for (int c = 0; c < channels; c++)
+    {
+        mean[c] = horizontalSum(_mm_add_ps(_mm_add_ps(texels[c][0], texels[c][1]), _mm_add_ps(texels[c][2], texels[c][3]))) / 16.0f;
+        const __m128 m = _mm_set1_ps(mean[c]);
+        for (int g = 0; g < 4; g++)
+            texels[c][g] = _mm_sub_ps(texels[c][g], m);
+    }
+
+    float cov[4][4] = {};
+    for (int a = 0; a < channels; a++)
+    {
+        for (int b = a; b < channels; b++)
+        {
+            __m128 sum = _mm_mul_ps(texels[a][0], texels[b][0]);
+            for (int g = 1; g < 4; g++)
+                sum = _mm_add_ps(sum, _mm_mul_ps(texels[a][g], texels[b][g]));
+            cov[a][b] = cov[b][a] = horizontalSum(sum);
+        }
+    }
+
+    // Power iteration, seeded with the diagonal so flat blocks still converge
+    float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int c = 0; c < channels; c++)
+        axis[c] = cov[c][c] + 1.0f;
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                next[a] += cov[a][b] * axis[b];
+        float length = 0.0f;
+        for (int c = 0; c < channels; c++)
+            length = std::max(length, std::abs(next[c]));
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < channels; c++)
+            axis[c] = next[c] / length;
+    }
+
+    __m128 minProj = _mm_set1_ps(1e30f), maxProj = _mm_set1_ps(-1e30f);
+    for (int g = 0; g < 4; g++)
+    {
+        __m128 proj = _mm_mul_ps(texels[0][g], _mm_set1_ps(axis[0]));
+        for (int c = 1; c < channels; c++)
+            proj = _mm_add_ps(proj, _mm_mul_ps(texels[c][g], _mm_set1_ps(axis[c])));
+        minProj = _mm_min_ps(minProj, proj);
+        maxProj = _mm_max_ps(maxProj, proj);
+    }
+    const float lowest = horizontalMin(minProj), highest = horizontalMax(maxProj);
+
+    float axisLengthSq = 0.0f;
+    for (int c = 0; c < channels; c++)
+        axisLengthSq += axis[c] * axis[c];
+    if (axisLengthSq < 1e-12f)
+        axisLengthSq = 1.0f;
+
+    for (int c = 0; c < channels; c++)
+    {
+        minColor[c] = std::clamp(mean[c] + axis[c] * lowest / axisLengthSq, 0.0f, 255.0f);
+        maxColor[c] = std::clamp(mean[c] + axis[c] * highest / axisLengthSq, 0.0f, 255.0f);
+    }
+    for (int c = channels; c < 4; c++)
+    {
+        minColor[c] = 255.0f;
+        maxColor[c] = 255.0f;
+    }
+#else
+    fitPrincipalAxis(block, channels, minColor, maxColor);
+#endif
+}
+
+// Set up projectBlock() so that endpoint e0 maps to 0 and e1 to maxIndex
+static bool projectionWeights(const int e0[4], const int e1[4], int channels, int maxIndex, float weights[4], float &bias)
+{
+    int lengthSq = 0;
+    for (int c = 0; c < channels; c++)
+        lengthSq += (e1[c] - e0[c]) * (e1[c] - e0[c]);
+    if (lengthSq == 0)
+        return false;
+
+    const float scale = static_cast<float>(maxIndex) / static_cast<float>(lengthSq);
+    bias = 0.0f;
+    for (int c = 0; c < 4; c++)
+    {
+        weights[c] = c < channels ? (e1[c] - e0[c]) * scale : 0.0f;
+        bias -= e0[c] * weights[c];
+    }
+    return true;
+}
+
+static void compressBlockBC1(const uint8_t block[16][4], uint8_t out[8])
+{
+    float minColor[4], maxColor[4];
+    fitBlockAxis(block, 3, minColor, maxColor);
+    for (int c = 0; c < 3; c++)
+    {
+        float inset = (maxColor[c] - minColor[c]) / 16.0f;
+        minColor[c] = std::clamp(minColor[c] + inset, 0.0f, 255.0f);
+        maxColor[c] = std::clamp(maxColor[c] - inset, 0.0f, 255.0f);
+    }
+
+    uint16_t c0 = packRGB565(maxColor);
+    uint16_t c1 = packRGB565(minColor);
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    uint32_t packed = 0;
+    int e0[4] = {0, 0, 0, 0}, e1[4] = {0, 0, 0, 0};
+    unpackRGB565(c0, e0);
+    unpackRGB565(c1, e1);
+    float weights[4], bias;
+    if (c0 != c1 && projectionWeights(e0, e1, 3, 3, weights, bias))
+    {
+        // Positions along c0 -> c1 are palette entries 0, 2, 3, 1
+        static const uint32_t paletteIndex[4] = {0, 2, 3, 1};
+        int indices[16];
+        projectBlock(block, weights, bias, 3, indices);
+        for (int i = 0; i < 16; i++)
+            packed |= paletteIndex[indices[i]] << (i * 2);
+    }
+
+    out[0] = static_cast<uint8_t>(c0 & 0xFF);
+    out[1] = static_cast<uint8_t>(c0 >> 8);
+    out[2] = static_cast<uint8_t>(c1 & 0xFF);
+    out[3] = static_cast<uint8_t>(c1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = static_cast<uint8_t>(packed >> (i * 8));
+}
+
+// 128-bit little-endian block packed in two words instead of bit by bit (see BC7BlockWriter)
+struct BlockBits
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+    int position = 0;
+
+    void write(uint64_t value, int bitCount)
+    {
+        if (position < 64)
+        {
+            low |= value << position;
+            if (position + bitCount > 64)
+                high |= value >> (64 - position);
+        }
+        else
+        {
+            high |= value << (position - 64);
+        }
+        position += bitCount;
+    }
+
+    void store(uint8_t out[16]) const
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            out[i] = static_cast<uint8_t>(low >> (i * 8));
+            out[8 + i] = static_cast<uint8_t>(high >> (i * 8));
+        }
+    }
+};
+
+static void compressBlockBC7(const uint8_t block[16][4], uint8_t out[16])
+{
+    float minColor[4], maxColor[4];
+    fitBlockAxis(block, 4, minColor, maxColor);
+
+    int endpoints[2][4], pBits[2];
+    quantizeEndpointMode6(minColor, endpoints[0], pBits[0]);
+    quantizeEndpointMode6(maxColor, endpoints[1], pBits[1]);
+
+    // Mode 6 weights are i * 64 / 15 rounded, so the 16 palette entries are evenly spaced
+    int e0[4], e1[4];
+    for (int c = 0; c < 4; c++)
+    {
+        e0[c] = (endpoints[0][c] << 1) | pBits[0];
+        e1[c] = (endpoints[1][c] << 1) | pBits[1];
+    }
+    int indices[16] = {};
+    float weights[4], bias;
+    if (projectionWeights(e0, e1, 4, 15, weights, bias))
+        projectBlock(block, weights, bias, 15, indices);
+
+    // The anchor index is stored with an implicit zero MSB; swap endpoints if needed
+    if (indices[0] & 8)
+    {
+        std::swap(endpoints[0], endpoints[1]);
+        std::swap(pBits[0], pBits[1]);
+        for (int &index : indices)
+            index = 15 - index;
+    }
+
+    BlockBits bits;
+    bits.write(1u << 6, 7); // Mode 6
+    for (int c = 0; c < 4; c++)
+    {
+        bits.write(endpoints[0][c], 7);
+        bits.write(endpoints[1][c], 7);
+    }
+    bits.write(pBits[0], 1);
+    bits.write(pBits[1], 1);
+    bits.write(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        bits.write(indices[i], 4);
+    bits.store(out);
+}
+
+std::vector<uint8_t> compressBlocks(const uint8_t *rgba, int width, int height, BlockFormat format, unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    const int blockBytes = format == BlockFormat::BC7 ? bc7BlockBytes : bc1BlockBytes;
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<uint8_t> out(compressedLevelSize(width, height, blockBytes));
+
+    // A block row costs as much as many pixel rows, so small images are still worth splitting
+    parallelRows(blocksY, threadCount, [&](int begin, int end)
+                 {
+                     alignas(32) uint8_t block[16][4];
+                     for (int by = begin; by < end; by++)
+                     {
+                         uint8_t *dst = out.data() + static_cast<size_t>(by) * blocksX * blockBytes;
+                         for (int bx = 0; bx < blocksX; bx++, dst += blockBytes)
+                         {
+                             loadBlock(rgba, width, height, bx, by, block);
+                             if (format == BlockFormat::BC7)
+                                 compressBlockBC7(block, dst);
+                             else
+                                 compressBlockBC1(block, dst);
+                         }
+                     } }, 4);
+    return out;
+}
+
+std::vector<std::vector<uint8_t>> compressMipChain(const std::vector<MipLevel> &levels, BlockFormat format,
+                                                   unsigned threadCount)
+{
+    std::vector<std::vector<uint8_t>> compressed;
+    compressed.reserve(levels.size());
+    for (const MipLevel &level : levels)
+        compressed.push_back(compressBlocks(level.pixels.data(), level.width, level.height, format, threadCount));
+    return compressed;
+}
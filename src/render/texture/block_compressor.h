@@ -0,0 +1,27 @@
+#ifndef BLOCK_COMPRESSOR_H
+#define BLOCK_COMPRESSOR_H
+
+#include <cstdint>
+#include <vector>
+#include "mipmap.h"
+
+// Runtime BC1 / BC7 (mode 6) compression for textures built in the app (atlases, lightmaps, captures).
+// Same block fit as bc_encoder.h, but palette indices come from one projection onto the endpoint
+// axis computed with SSE2 / AVX2 kernels, and block rows are split across worker threads.
+// Output is row-major blocks, ready for glCompressedTexImage2D.
+
+enum class BlockFormat
+{
+    BC1, // RGB, 8 bytes per block (8:1 against RGBA8)
+    BC7  // RGBA, 16 bytes per block (4:1)
+};
+
+// Compress an RGBA8 image; threadCount 0 = hardware concurrency
+std::vector<uint8_t> compressBlocks(const uint8_t *rgba, int width, int height, BlockFormat format,
+                                    unsigned threadCount = 0);
+
+// Compress every level of an RGBA mip chain (see buildMipChain)
+std::vector<std::vector<uint8_t>> compressMipChain(const std::vector<MipLevel> &levels, BlockFormat format,
+                                                   unsigned threadCount = 0);
+
+#endif /* BLOCK_COMPRESSOR_H */
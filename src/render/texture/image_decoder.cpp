@@ -0,0 +1,226 @@
+#include "image_decoder.h"
+
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image/stb_image.h>
+
+#ifdef HAVE_LIBJPEG_TURBO
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+// SSSE3 is enabled per function and picked at runtime, so default x86-64 builds still get it
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <tmmintrin.h>
+#define DECODER_SSSE3 1
+#define DECODER_TARGET_SSSE3
+#elif defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define DECODER_SSSE3 1
+#define DECODER_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+#ifdef DECODER_SSSE3
+static bool cpuHasSSSE3()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+// 16 pixels per iteration: four 12-byte groups shuffled into four RGBA quads
+DECODER_TARGET_SSSE3 static size_t expandRGBToRGBASSSE3(const uint8_t *rgb, uint8_t *rgba, size_t pixelCount)
+{
+    const __m128i shuffleLow = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i shuffleHigh = _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    size_t i = 0;
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        const uint8_t *src = rgb + i * 3;
+        __m128i *dst = reinterpret_cast<__m128i *>(rgba + i * 4);
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 12));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 24));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 32)); // Last load stays inside the 48 bytes
+        _mm_storeu_si128(dst + 0, _mm_or_si128(_mm_shuffle_epi8(a, shuffleLow), alpha));
+        _mm_storeu_si128(dst + 1, _mm_or_si128(_mm_shuffle_epi8(b, shuffleLow), alpha));
+        _mm_storeu_si128(dst + 2, _mm_or_si128(_mm_shuffle_epi8(c, shuffleLow), alpha));
+        _mm_storeu_si128(dst + 3, _mm_or_si128(_mm_shuffle_epi8(d, shuffleHigh), alpha));
+    }
+    return i;
+}
+#endif
+
+void expandRGBToRGBA(const uint8_t *rgb, uint8_t *rgba, size_t pixelCount)
+{
+    size_t i = 0;
+#ifdef DECODER_SSSE3
+    static const bool ssse3 = cpuHasSSSE3();
+    if (ssse3)
+        i = expandRGBToRGBASSSE3(rgb, rgba, pixelCount);
+#endif
+    for (; i < pixelCount; i++)
+    {
+        rgba[i * 4 + 0] = rgb[i * 3 + 0];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+// Replace 3-channel pixels with an RGBA copy
+static bool expandImageToRGBA(DecodedImage &image)
+{
+    size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    uint8_t *rgba = static_cast<uint8_t *>(std::malloc(pixelCount * 4));
+    if (!rgba)
+        return false;
+    expandRGBToRGBA(image.data(), rgba, pixelCount);
+    image.pixels.reset(rgba);
+    image.channels = 4;
+    return true;
+}
+
+bool StbImageDecoder::canDecode(const uint8_t *data, size_t size) const
+{
+    int width, height, channels;
+    return stbi_info_from_memory(data, static_cast<int>(size), &width, &height, &channels) != 0;
+}
+
+bool StbImageDecoder::decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image) const
+{
+    int width, height, channelsInFile;
+    if (!stbi_info_from_memory(data, static_cast<int>(size), &width, &height, &channelsInFile))
+        return false;
+
+    int channels = desiredChannels;
+    if (channels == 0)
+        channels = channelsInFile == 1 ? 3 : channelsInFile == 2 ? 4 : channelsInFile;
+
+    // stb's own RGB -> RGBA conversion is scalar; decode RGB and expand with SIMD instead
+    const bool expand = channelsInFile == 3 && channels == 4;
+    unsigned char *pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channelsInFile,
+                                                  expand ? 3 : channels);
+    if (!pixels)
+        return false;
+
+    image.width = width;
+    image.height = height;
+    image.channels = expand ? 3 : channels;
+    image.pixels.reset(pixels);
+    return !expand || expandImageToRGBA(image);
+}
+
+#ifdef HAVE_LIBJPEG_TURBO
+namespace
+{
+    // libjpeg's default error handler calls exit(); jump back out instead
+    struct JpegErrorManager
+    {
+        jpeg_error_mgr base;
+        std::jmp_buf jump;
+    };
+
+    void jpegErrorExit(j_common_ptr info)
+    {
+        char message[JMSG_LENGTH_MAX];
+        info->err->format_message(info, message);
+        spdlog::error("libjpeg: {}", message);
+        std::longjmp(reinterpret_cast<JpegErrorManager *>(info->err)->jump, 1);
+    }
+}
+
+bool JpegTurboDecoder::canDecode(const uint8_t *data, size_t size) const
+{
+    return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+bool JpegTurboDecoder::decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image) const
+{
+    jpeg_decompress_struct info;
+    JpegErrorManager error;
+    info.err = jpeg_std_error(&error.base);
+    error.base.error_exit = jpegErrorExit;
+    uint8_t *volatile pixels = nullptr; // Read after longjmp
+
+    if (setjmp(error.jump))
+    {
+        jpeg_destroy_decompress(&info);
+        std::free(pixels);
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, const_cast<unsigned char *>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&info, TRUE);
+
+    // JPEG has no alpha, so "as stored" means RGB
+    int channels = desiredChannels == 4 ? 4 : 3;
+#ifdef JCS_EXTENSIONS
+    info.out_color_space = channels == 4 ? JCS_EXT_RGBA : JCS_RGB;
+    const int decodedChannels = channels;
+#else
+    info.out_color_space = JCS_RGB;
+    const int decodedChannels = 3;
+#endif
+    jpeg_start_decompress(&info);
+
+    const size_t stride = static_cast<size_t>(info.output_width) * decodedChannels;
+    pixels = static_cast<uint8_t *>(std::malloc(stride * info.output_height));
+    if (!pixels)
+    {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    while (info.output_scanline < info.output_height)
+    {
+        JSAMPROW rows[16];
+        JDIMENSION count = 0;
+        for (; count < 16 && info.output_scanline + count < info.output_height; count++)
+            rows[count] = pixels + (info.output_scanline + count) * stride;
+        jpeg_read_scanlines(&info, rows, count);
+    }
+    jpeg_finish_decompress(&info);
+
+    image.width = static_cast<int>(info.output_width);
+    image.height = static_cast<int>(info.output_height);
+    image.channels = decodedChannels;
+    image.pixels.reset(pixels);
+    jpeg_destroy_decompress(&info);
+    return decodedChannels == channels || expandImageToRGBA(image);
+}
+#endif
+
+const std::vector<std::unique_ptr<ImageDecoder>> &imageDecoders()
+{
+    static const std::vector<std::unique_ptr<ImageDecoder>> decoders = []
+    {
+        std::vector<std::unique_ptr<ImageDecoder>> list;
+#ifdef HAVE_LIBJPEG_TURBO
+        list.push_back(std::make_unique<JpegTurboDecoder>());
+#endif
+        list.push_back(std::make_unique<StbImageDecoder>());
+        return list;
+    }();
+    return decoders;
+}
+
+bool decodeImage(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image)
+{
+    for (const auto &decoder : imageDecoders())
+    {
+        if (decoder->canDecode(data, size))
+            return decoder->decode(data, size, desiredChannels, image);
+    }
+    return false;
+}
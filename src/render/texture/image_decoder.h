@@ -0,0 +1,69 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Decoded 8-bit image. Rows are stored top row first, as in the file: nothing flips pixels,
+// the scene shader flips the V coordinate instead.
+struct DecodedImage
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::unique_ptr<uint8_t, void (*)(void *)> pixels{nullptr, std::free};
+
+    const uint8_t *data() const { return pixels.get(); }
+    size_t size() const { return static_cast<size_t>(width) * height * channels; }
+    explicit operator bool() const { return pixels != nullptr; }
+};
+
+// Image decoding backend
+class ImageDecoder
+{
+public:
+    virtual ~ImageDecoder() = default;
+
+    virtual const char *name() const = 0;
+
+    // Cheap signature check
+    virtual bool canDecode(const uint8_t *data, size_t size) const = 0;
+
+    // desiredChannels is 3 (RGB) or 4 (RGBA), or 0 to keep RGB/RGBA as stored.
+    // Grey images are always expanded to RGB (RGBA with alpha).
+    virtual bool decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image) const = 0;
+};
+
+// stb_image: every format stb supports
+class StbImageDecoder : public ImageDecoder
+{
+public:
+    const char *name() const override { return "stb_image"; }
+    bool canDecode(const uint8_t *data, size_t size) const override;
+    bool decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image) const override;
+};
+
+#ifdef HAVE_LIBJPEG_TURBO
+// libjpeg-turbo: SIMD IDCT / colour conversion, writes RGBA directly
+class JpegTurboDecoder : public ImageDecoder
+{
+public:
+    const char *name() const override { return "libjpeg-turbo"; }
+    bool canDecode(const uint8_t *data, size_t size) const override;
+    bool decode(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image) const override;
+};
+#endif
+
+// Registered backends, fastest first
+const std::vector<std::unique_ptr<ImageDecoder>> &imageDecoders();
+
+// Decode with the first backend that accepts the data
+bool decodeImage(const uint8_t *data, size_t size, int desiredChannels, DecodedImage &image);
+
+// RGB -> RGBA with opaque alpha (SSSE3 when the CPU has it)
+void expandRGBToRGBA(const uint8_t *rgb, uint8_t *rgba, size_t pixelCount);
+
+#endif /* IMAGE_DECODER_H */
@@ -0,0 +1,173 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Minimal KTX2 container support: single 2D image, no supercompression, block-compressed formats only.
+// Level data is referenced in place so callers can upload straight from a file buffer.
+
+static const uint8_t ktx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// Vulkan format enums used by KTX2
+static const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+
+struct Ktx2Level
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+};
+
+static const size_t ktx2HeaderSize = 80;
+static const size_t ktx2LevelIndexEntrySize = 24;
+
+struct Ktx2Info
+{
+    uint32_t vkFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<Ktx2Level> levels; // Level 0 is the full resolution image
+};
+
+inline uint32_t ktx2BlockBytes(uint32_t vkFormat)
+{
+    switch (vkFormat)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        return 8;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+template <typename T>
+inline T ktx2Read(const uint8_t *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+// Parse the header and level index; fails on anything this loader cannot upload directly.
+// `size` must cover at least the header and level index; level ranges are checked against fileSize
+// (defaults to size), which lets streaming readers parse just the front of a file.
+inline bool parseKtx2(const uint8_t *data, size_t size, Ktx2Info &info, size_t fileSize = 0)
+{
+    if (fileSize == 0)
+        fileSize = size;
+
+    if (size < ktx2HeaderSize || std::memcmp(data, ktx2Identifier, sizeof(ktx2Identifier)) != 0)
+        return false;
+
+    info.vkFormat = ktx2Read<uint32_t>(data + 12);
+    info.width = ktx2Read<uint32_t>(data + 20);
+    info.height = ktx2Read<uint32_t>(data + 24);
+    uint32_t depth = ktx2Read<uint32_t>(data + 28);
+    uint32_t layerCount = ktx2Read<uint32_t>(data + 32);
+    uint32_t faceCount = ktx2Read<uint32_t>(data + 36);
+    uint32_t levelCount = std::max<uint32_t>(ktx2Read<uint32_t>(data + 40), 1);
+    uint32_t supercompression = ktx2Read<uint32_t>(data + 44);
+
+    if (ktx2BlockBytes(info.vkFormat) == 0 || depth != 0 || layerCount != 0 || faceCount != 1 || supercompression != 0)
+        return false;
+    if (size < ktx2HeaderSize + static_cast<size_t>(levelCount) * ktx2LevelIndexEntrySize)
+        return false;
+
+    info.levels.resize(levelCount);
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        const uint8_t *entry = data + ktx2HeaderSize + i * ktx2LevelIndexEntrySize;
+        info.levels[i].byteOffset = ktx2Read<uint64_t>(entry);
+        info.levels[i].byteLength = ktx2Read<uint64_t>(entry + 8);
+        if (info.levels[i].byteOffset + info.levels[i].byteLength > fileSize)
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+inline void ktx2Append(std::vector<uint8_t> &out, T value)
+{
+    size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+// Write a block-compressed mip chain; levels[0] is the full resolution image
+inline bool writeKtx2(const std::string &path, uint32_t vkFormat, uint32_t width, uint32_t height,
+                      const std::vector<std::vector<uint8_t>> &levels)
+{
+    const uint32_t blockBytes = ktx2BlockBytes(vkFormat);
+    if (blockBytes == 0 || levels.empty())
+        return false;
+
+    const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+    const uint32_t dfdOffset = static_cast<uint32_t>(ktx2HeaderSize + levelCount * ktx2LevelIndexEntrySize);
+    const uint32_t dfdLength = 44; // Total size + basic descriptor block with one sample
+
+    std::vector<uint8_t> file(std::begin(ktx2Identifier), std::end(ktx2Identifier));
+    ktx2Append<uint32_t>(file, vkFormat);
+    ktx2Append<uint32_t>(file, 1); // typeSize
+    ktx2Append<uint32_t>(file, width);
+    ktx2Append<uint32_t>(file, height);
+    ktx2Append<uint32_t>(file, 0); // pixelDepth
+    ktx2Append<uint32_t>(file, 0); // layerCount
+    ktx2Append<uint32_t>(file, 1); // faceCount
+    ktx2Append<uint32_t>(file, levelCount);
+    ktx2Append<uint32_t>(file, 0); // supercompressionScheme
+
+    ktx2Append<uint32_t>(file, dfdOffset);
+    ktx2Append<uint32_t>(file, dfdLength);
+    ktx2Append<uint32_t>(file, 0); // kvdByteOffset
+    ktx2Append<uint32_t>(file, 0); // kvdByteLength
+    ktx2Append<uint64_t>(file, 0); // sgdByteOffset
+    ktx2Append<uint64_t>(file, 0); // sgdByteLength
+
+    // Mip data is stored smallest level first, each level aligned to the block size
+    std::vector<Ktx2Level> placement(levelCount);
+    uint64_t offset = dfdOffset + dfdLength;
+    for (int i = static_cast<int>(levelCount) - 1; i >= 0; i--)
+    {
+        offset = (offset + blockBytes - 1) / blockBytes * blockBytes;
+        placement[i] = {offset, levels[i].size()};
+        offset += levels[i].size();
+    }
+
+    for (uint32_t i = 0; i < levelCount; i++)
+    {
+        ktx2Append<uint64_t>(file, placement[i].byteOffset);
+        ktx2Append<uint64_t>(file, placement[i].byteLength);
+        ktx2Append<uint64_t>(file, placement[i].byteLength); // uncompressedByteLength
+    }
+
+    // Data format descriptor (Khronos basic block, one sample)
+    const bool bc7 = vkFormat == VK_FORMAT_BC7_UNORM_BLOCK;
+    ktx2Append<uint32_t>(file, dfdLength);
+    ktx2Append<uint32_t>(file, 0);                                            // vendorId / descriptorType
+    ktx2Append<uint32_t>(file, 2u | (40u << 16));                             // versionNumber / descriptorBlockSize
+    ktx2Append<uint32_t>(file, (bc7 ? 135u : 128u) | (1u << 8) | (1u << 16)); // BC7 or BC1A, BT709, linear
+    ktx2Append<uint32_t>(file, 3u | (3u << 8));                               // texelBlockDimension 4x4
+    ktx2Append<uint32_t>(file, blockBytes);                                   // bytesPlane0..3
+    ktx2Append<uint32_t>(file, 0);                                            // bytesPlane4..7
+    ktx2Append<uint32_t>(file, (blockBytes * 8 - 1) << 16);                   // bitOffset, bitLength, color channel
+    ktx2Append<uint32_t>(file, 0);                                            // samplePosition
+    ktx2Append<uint32_t>(file, 0);                                            // sampleLower
+    ktx2Append<uint32_t>(file, 0xFFFFFFFFu);                                  // sampleUpper
+
+    file.resize(offset, 0);
+    for (uint32_t i = 0; i < levelCount; i++)
+        std::memcpy(file.data() + placement[i].byteOffset, levels[i].data(), levels[i].size());
+
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+    return stream.good();
+}
+
+#endif /* KTX2_H */
@@ -0,0 +1,407 @@
+#include "mipmap.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include "parallel_rows.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIPMAP_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#endif
+
+// Working image: 4 linear floats per pixel
+struct LinearImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<float> rgba;
+
+    LinearImage(int width, int height) : width(width), height(height), rgba(static_cast<size_t>(width) * height * 4) {}
+    float *row(int y) { return rgba.data() + static_cast<size_t>(y) * width * 4; }
+    const float *row(int y) const { return rgba.data() + static_cast<size_t>(y) * width * 4; }
+};
+
+static const std::array<float, 256> &srgbToLinearTable()
+{
+    static const std::array<float, 256> table = []
+    {
+        std::array<float, 256> values{};
+        for (int i = 0; i < 256; i++)
+        {
+            float c = i / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+// 12-bit linear -> 8-bit sRGB
+static const std::array<uint8_t, 4096> &linearToSrgbTable()
+{
+    static const std::array<uint8_t, 4096> table = []
+    {
+        std::array<uint8_t, 4096> values{};
+        for (int i = 0; i < 4096; i++)
+        {
+            float l = i / 4095.0f;
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            values[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+        return values;
+    }();
+    return table;
+}
+
+static void decodeRows(const uint8_t *pixels, int channels, bool srgb, LinearImage &image, int begin, int end)
+{
+    const std::array<float, 256> &toLinear = srgbToLinearTable();
+    for (int y = begin; y < end; y++)
+    {
+        const uint8_t *src = pixels + static_cast<size_t>(y) * image.width * channels;
+        float *dst = image.row(y);
+        for (int x = 0; x < image.width; x++, src += channels, dst += 4)
+        {
+            for (int c = 0; c < 3; c++)
+                dst[c] = srgb ? toLinear[src[c]] : src[c] / 255.0f;
+            dst[3] = channels == 4 ? src[3] / 255.0f : 1.0f;
+        }
+    }
+}
+
+static void encodeRows(const LinearImage &image, int channels, bool srgb, uint8_t *pixels, int begin, int end)
+{
+    const std::array<uint8_t, 4096> &toSrgb = linearToSrgbTable();
+    for (int y = begin; y < end; y++)
+    {
+        const float *src = image.row(y);
+        uint8_t *dst = pixels + static_cast<size_t>(y) * image.width * channels;
+        for (int x = 0; x < image.width; x++, src += 4, dst += channels)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                float v = std::clamp(src[c], 0.0f, 1.0f);
+                dst[c] = (srgb && c < 3) ? toSrgb[static_cast<int>(v * 4095.0f + 0.5f)]
+                                         : static_cast<uint8_t>(v * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+// 2x2 box filter; odd source sizes clamp to the last row/column
+static void boxRows(const LinearImage &src, LinearImage &dst, int begin, int end)
+{
+    for (int y = begin; y < end; y++)
+    {
+        const float *r0 = src.row(std::min(y * 2, src.height - 1));
+        const float *r1 = src.row(std::min(y * 2 + 1, src.height - 1));
+        float *out = dst.row(y);
+        int x = 0;
+
+#ifdef MIPMAP_AVX2
+        // Two output pixels per iteration: four source pixels from each row
+        const __m256 quarter = _mm256_set1_ps(0.25f);
+        for (; x + 2 <= dst.width && x * 2 + 4 <= src.width; x += 2)
+        {
+            __m256 a = _mm256_add_ps(_mm256_loadu_ps(r0 + x * 8), _mm256_loadu_ps(r1 + x * 8));
+            __m256 b = _mm256_add_ps(_mm256_loadu_ps(r0 + x * 8 + 8), _mm256_loadu_ps(r1 + x * 8 + 8));
+            __m256 left = _mm256_permute2f128_ps(a, b, 0x20);
+            __m256 right = _mm256_permute2f128_ps(a, b, 0x31);
+            _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(left, right), quarter));
+        }
+#endif
+
+        for (; x < dst.width; x++)
+        {
+            int x0 = std::min(x * 2, src.width - 1) * 4;
+            int x1 = std::min(x * 2 + 1, src.width - 1) * 4;
+#ifdef MIPMAP_SSE2
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(r0 + x0), _mm_loadu_ps(r0 + x1)),
+                                    _mm_add_ps(_mm_loadu_ps(r1 + x0), _mm_loadu_ps(r1 + x1)));
+            _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+            for (int c = 0; c < 4; c++)
+                out[x * 4 + c] = (r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c]) * 0.25f;
+#endif
+        }
+    }
+}
+
+static const int kaiserTaps = 6;
+
+// Kaiser-windowed sinc for a 2:1 reduction, sampled at source texel centers around the output center
+static const std::array<float, kaiserTaps> &kaiserWeights()
+{
+    static const std::array<float, kaiserTaps> weights = []
+    {
+        auto besselI0 = [](double x)
+        {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; k++)
+            {
+                double t = x / (2.0 * k);
+                term *= t * t;
+                sum += term;
+            }
+            return sum;
+        };
+
+        const double pi = 3.14159265358979323846;
+        const double beta = 4.0, radius = 3.0;
+        std::array<float, kaiserTaps> values{};
+        double total = 0.0;
+        for (int k = 0; k < kaiserTaps; k++)
+        {
+            double d = k - 2.5;
+            double t = d * 0.5;
+            double sinc = std::sin(pi * t) / (pi * t);
+            double r = d / radius;
+            double window = besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+            values[k] = static_cast<float>(sinc * window);
+            total += values[k];
+        }
+        for (float &value : values)
+            value = static_cast<float>(value / total);
+        return values;
+    }();
+    return weights;
+}
+
+// Horizontal Kaiser pass: src (w x h) -> tmp (w/2 x h)
+static void kaiserHorizontalRows(const LinearImage &src, LinearImage &tmp, int begin, int end)
+{
+    const std::array<float, kaiserTaps> &w = kaiserWeights();
+    const bool reduce = src.width > 1;
+    for (int y = begin; y < end; y++)
+    {
+        const float *in = src.row(y);
+        float *out = tmp.row(y);
+        for (int x = 0; x < tmp.width; x++)
+        {
+            if (!reduce)
+            {
+                std::copy(in, in + 4, out);
+                continue;
+            }
+#ifdef MIPMAP_SSE2
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < kaiserTaps; k++)
+            {
+                int sx = std::clamp(x * 2 - 2 + k, 0, src.width - 1);
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(in + sx * 4)));
+            }
+            _mm_storeu_ps(out + x * 4, acc);
+#else
+            float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int k = 0; k < kaiserTaps; k++)
+            {
+                int sx = std::clamp(x * 2 - 2 + k, 0, src.width - 1);
+                for (int c = 0; c < 4; c++)
+                    acc[c] += w[k] * in[sx * 4 + c];
+            }
+            std::copy(acc, acc + 4, out + x * 4);
+#endif
+        }
+    }
+}
+
+// Vertical Kaiser pass: tmp (w/2 x h) -> dst (w/2 x h/2)
+static void kaiserVerticalRows(const LinearImage &tmp, LinearImage &dst, int begin, int end)
+{
+    const std::array<float, kaiserTaps> &w = kaiserWeights();
+    const bool reduce = tmp.height > 1;
+    const int floats = dst.width * 4;
+    for (int y = begin; y < end; y++)
+    {
+        float *out = dst.row(y);
+        if (!reduce)
+        {
+            std::copy(tmp.row(0), tmp.row(0) + floats, out);
+            continue;
+        }
+
+        const float *rows[kaiserTaps];
+        for (int k = 0; k < kaiserTaps; k++)
+            rows[k] = tmp.row(std::clamp(y * 2 - 2 + k, 0, tmp.height - 1));
+
+        int i = 0;
+#ifdef MIPMAP_AVX2
+        for (; i + 8 <= floats; i += 8)
+        {
+            __m256 acc = _mm256_setzero_ps();
+            for (int k = 0; k < kaiserTaps; k++)
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), _mm256_loadu_ps(rows[k] + i)));
+            _mm256_storeu_ps(out + i, acc);
+        }
+#endif
+#ifdef MIPMAP_SSE2
+        for (; i + 4 <= floats; i += 4)
+        {
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < kaiserTaps; k++)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(rows[k] + i)));
+            _mm_storeu_ps(out + i, acc);
+        }
+#endif
+        for (; i < floats; i++)
+        {
+            float acc = 0.0f;
+            for (int k = 0; k < kaiserTaps; k++)
+                acc += w[k] * rows[k][i];
+            out[i] = acc;
+        }
+    }
+}
+
+int mipLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        levels++;
+    }
+    return levels;
+}
+
+std::vector<MipLevel> buildMipChain(const uint8_t *pixels, int width, int height, int channels,
+                                    MipFilter filter, bool srgb, unsigned threadCount)
+{
+    std::vector<MipLevel> levels;
+    if (!pixels || width <= 0 || height <= 0 || (channels != 3 && channels != 4))
+        return levels;
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    levels.reserve(mipLevelCount(width, height));
+    levels.push_back({width, height, std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * channels)});
+
+    LinearImage current(width, height);
+    parallelRows(height, threadCount, [&](int begin, int end)
+                 { decodeRows(pixels, channels, srgb, current, begin, end); });
+
+    while (current.width > 1 || current.height > 1)
+    {
+        LinearImage next(std::max(current.width / 2, 1), std::max(current.height / 2, 1));
+        if (filter == MipFilter::Kaiser)
+        {
+            LinearImage tmp(next.width, current.height);
+            parallelRows(tmp.height, threadCount, [&](int begin, int end)
+                         { kaiserHorizontalRows(current, tmp, begin, end); });
+            parallelRows(next.height, threadCount, [&](int begin, int end)
+                         { kaiserVerticalRows(tmp, next, begin, end); });
+        }
+        else
+        {
+            parallelRows(next.height, threadCount, [&](int begin, int end)
+                         { boxRows(current, next, begin, end); });
+        }
+
+        MipLevel level{next.width, next.height, std::vector<uint8_t>(static_cast<size_t>(next.width) * next.height * channels)};
+        parallelRows(next.height, threadCount, [&](int begin, int end)
+                     { encodeRows(next, channels, srgb, level.pixels.data(), begin, end); });
+        levels.push_back(std::move(level));
+        current = std::move(next);
+    }
+    return levels;
+}
+
+struct ResampleTap
+{
+    int first = 0;
+    std::vector<float> weights;
+};
+
+// Per output coordinate: the contributing source range and normalized tent weights
+static std::vector<ResampleTap> resampleTaps(int srcSize, int dstSize)
+{
+    const float scale = static_cast<float>(srcSize) / dstSize;
+    const float support = std::max(scale, 1.0f);
+    std::vector<ResampleTap> taps(dstSize);
+    for (int i = 0; i < dstSize; i++)
+    {
+        float center = (i + 0.5f) * scale - 0.5f;
+        int first = static_cast<int>(std::floor(center - support)) + 1;
+        int last = static_cast<int>(std::ceil(center + support)) - 1;
+        float total = 0.0f;
+        taps[i].first = first;
+        for (int s = first; s <= last; s++)
+        {
+            float weight = std::max(0.0f, 1.0f - std::abs(s - center) / support);
+            taps[i].weights.push_back(weight);
+            total += weight;
+        }
+        for (float &weight : taps[i].weights)
+            weight /= total > 0.0f ? total : 1.0f;
+    }
+    return taps;
+}
+
+std::vector<uint8_t> resampleImage(const uint8_t *pixels, int width, int height, int channels,
+                                   int newWidth, int newHeight, bool srgb, unsigned threadCount)
+{
+    if (!pixels || width <= 0 || height <= 0 || newWidth <= 0 || newHeight <= 0 || (channels != 3 && channels != 4))
+        return {};
+    if (width == newWidth && height == newHeight)
+        return std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * channels);
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    LinearImage source(width, height);
+    parallelRows(height, threadCount, [&](int begin, int end)
+                 { decodeRows(pixels, channels, srgb, source, begin, end); });
+
+    const std::vector<ResampleTap> horizontal = resampleTaps(width, newWidth);
+    const std::vector<ResampleTap> vertical = resampleTaps(height, newHeight);
+
+    LinearImage tmp(newWidth, height);
+    parallelRows(height, threadCount, [&](int begin, int end)
+                 {
+                     for (int y = begin; y < end; y++)
+                     {
+                         const float *in = source.row(y);
+                         float *out = tmp.row(y);
+                         for (int x = 0; x < newWidth; x++)
+                         {
+                             float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                             const ResampleTap &tap = horizontal[x];
+                             for (size_t k = 0; k < tap.weights.size(); k++)
+                             {
+                                 const float *texel = in + std::clamp(tap.first + static_cast<int>(k), 0, width - 1) * 4;
+                                 for (int c = 0; c < 4; c++)
+                                     acc[c] += tap.weights[k] * texel[c];
+                             }
+                             std::copy(acc, acc + 4, out + x * 4);
+                         }
+                     } });
+
+    LinearImage result(newWidth, newHeight);
+    parallelRows(newHeight, threadCount, [&](int begin, int end)
+                 {
+                     for (int y = begin; y < end; y++)
+                     {
+                         float *out = result.row(y);
+                         std::fill(out, out + newWidth * 4, 0.0f);
+                         const ResampleTap &tap = vertical[y];
+                         for (size_t k = 0; k < tap.weights.size(); k++)
+                         {
+                             const float *in = tmp.row(std::clamp(tap.first + static_cast<int>(k), 0, height - 1));
+                             for (int i = 0; i < newWidth * 4; i++)
+                                 out[i] += tap.weights[k] * in[i];
+                         }
+                     } });
+
+    std::vector<uint8_t> resized(static_cast<size_t>(newWidth) * newHeight * channels);
+    parallelRows(newHeight, threadCount, [&](int begin, int end)
+                 { encodeRows(result, channels, srgb, resized.data(), begin, end); });
+    return resized;
+}
@@ -0,0 +1,35 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <cstdint>
+#include <vector>
+
+// CPU mip chain builder. Filtering happens in linear light (sRGB decoded) with SSE/AVX2 kernels,
+// rows are split across worker threads. Works for decoded files and runtime-generated pixels alike.
+
+enum class MipFilter
+{
+    Box,   // 2x2 average
+    Kaiser // 6-tap Kaiser-windowed sinc, sharper minification
+};
+
+struct MipLevel
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels; // Same channel count as the source image
+};
+
+// Build the full chain down to 1x1; levels[0] is a copy of the source.
+// channels must be 3 (RGB) or 4 (RGBA, alpha filtered linearly). threadCount 0 = hardware concurrency.
+std::vector<MipLevel> buildMipChain(const uint8_t *pixels, int width, int height, int channels,
+                                    MipFilter filter = MipFilter::Box, bool srgb = true, unsigned threadCount = 0);
+
+// Number of levels in a full chain for the given size
+int mipLevelCount(int width, int height);
+
+// Resize an image to an arbitrary size with a tent filter in linear light (widened when minifying)
+std::vector<uint8_t> resampleImage(const uint8_t *pixels, int width, int height, int channels,
+                                   int newWidth, int newHeight, bool srgb = true, unsigned threadCount = 0);
+
+#endif /* MIPMAP_H */
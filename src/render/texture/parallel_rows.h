@@ -0,0 +1,35 @@
+#ifndef PARALLEL_ROWS_H
+#define PARALLEL_ROWS_H
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Run fn(beginRow, endRow) over [0, rows) split across threads; small images stay on the caller
+inline void parallelRows(int rows, unsigned threadCount, const std::function<void(int, int)> &fn,
+                         int minRowsPerThread = 16)
+{
+    unsigned threads = std::min<unsigned>(threadCount, static_cast<unsigned>(std::max(rows / minRowsPerThread, 1)));
+    if (threads <= 1)
+    {
+        fn(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    int chunk = (rows + static_cast<int>(threads) - 1) / static_cast<int>(threads);
+    for (unsigned t = 1; t < threads; t++)
+    {
+        int begin = static_cast<int>(t) * chunk;
+        int end = std::min(rows, begin + chunk);
+        if (begin < end)
+            workers.emplace_back(fn, begin, end);
+    }
+    fn(0, std::min(rows, chunk));
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+#endif /* PARALLEL_ROWS_H */
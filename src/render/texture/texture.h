@@ -2,46 +2,52 @@
 #define TEXTURE_H
 
 #include <glad/glad.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image/stb_image.h>
-#include <spdlog/spdlog.h>
+#include <cstdint>
+#include <cstring>
+#include "ktx2.h"
 
-// Load texture
-static bool loadTexture(const char *filepath, GLuint &planeTexture)
-{
-    glGenTextures(1, &planeTexture);
-    glBindTexture(GL_TEXTURE_2D, planeTexture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
 
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load(filepath, &width, &height, &nrChannels, 0);
-    try
+// Check whether the current context exposes an extension
+inline bool hasGLExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
     {
-        if (data)
-        {
-            GLenum format = nrChannels == 3 ? GL_RGB : GL_RGBA;
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            spdlog::info("Texture: {} loaded successfully: {}x{}", filepath, width, height);
-        }
-        else
-        {
-            spdlog::error("Failed to load texture: {}", filepath);
-            return false;
-        }
+        const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
     }
-    catch (const std::exception &e)
+    return false;
+}
+
+inline GLenum glFormatForVkFormat(uint32_t vkFormat)
+{
+    switch (vkFormat)
     {
-        spdlog::error("Failed to load texture: {}", e.what());
-        return false;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:
+        return 0;
     }
-    stbi_image_free(data);
-    return true;
+}
+
+// BC7 (core in 4.2) and BC1 support of the current context
+inline bool isBptcSupported()
+{
+    static const bool supported = GLAD_GL_VERSION_4_2 || hasGLExtension("GL_ARB_texture_compression_bptc");
+    return supported;
+}
+
+inline bool isS3tcSupported()
+{
+    static const bool supported = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    return supported;
 }
 
 #endif /* TEXTURE_H */
@@ -0,0 +1,204 @@
+#include "texture_array.h"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include "block_compressor.h"
+#include "image_decoder.h"
+#include "texture.h"
+#include "texture_memory.h"
+#include "../state/gl_state.h"
+#include "../../io/resource_loader.h"
+
+// A material as found on disk: a KTX2 image that can go up as it is, or decoded pixels
+struct MaterialSource
+{
+    std::string path;
+    ResourceData ktx2;
+    Ktx2Info info;
+    DecodedImage image;
+    bool compressed = false;
+};
+
+static bool loadMaterialSource(const std::string &path, bool bptc, MaterialSource &source)
+{
+    source.path = path;
+    if (bptc && loadResource(path + ".bc7.ktx2", source.ktx2) &&
+        parseKtx2(source.ktx2.data, source.ktx2.size, source.info) && source.info.vkFormat == VK_FORMAT_BC7_UNORM_BLOCK)
+    {
+        source.compressed = true;
+        return true;
+    }
+
+    ResourceData resource;
+    if (!loadResource(path + ".jpg", resource) || !decodeImage(resource.data, resource.size, 4, source.image))
+    {
+        spdlog::error("Failed to load texture: {}", path);
+        return false;
+    }
+    return true;
+}
+
+TextureArray::TextureArray(const std::vector<std::string> &basePaths)
+{
+    const bool bptc = isBptcSupported();
+    internalFormat = bptc ? GL_COMPRESSED_RGBA_BPTC_UNORM : GL_RGBA8;
+
+    // A material listed twice loads once and shares its layer
+    std::vector<MaterialSource> sources;
+    auto load = [bptc, &sources](const std::string &path) -> std::unique_ptr<Layer>
+    {
+        MaterialSource source;
+        if (!loadMaterialSource(path, bptc, source))
+            return nullptr;
+        sources.push_back(std::move(source));
+        return std::make_unique<Layer>(Layer{static_cast<int>(sources.size()) - 1});
+    };
+    for (const std::string &basePath : basePaths)
+    {
+        std::shared_ptr<Layer> layer = layers.acquire(basePath, load);
+        if (layer && std::find(heldLayers.begin(), heldLayers.end(), layer) == heldLayers.end())
+            heldLayers.push_back(layer);
+    }
+
+    if (!sources.empty())
+    {
+        const MaterialSource &first = sources.front();
+        layerWidth = first.compressed ? static_cast<int>(first.info.width) : first.image.width;
+        layerHeight = first.compressed ? static_cast<int>(first.info.height) : first.image.height;
+    }
+    levelCount = mipLevelCount(layerWidth, layerHeight);
+    capacity = std::max(static_cast<int>(sources.size()), 1); // An empty array still binds as white
+
+    glGenTextures(1, &textureID);
+    glState().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+    if (GLAD_GL_VERSION_4_2)
+    {
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levelCount, internalFormat, layerWidth, layerHeight, capacity);
+    }
+    else
+    {
+        // Pre-4.2 contexts: allocate every level up front, which gives the same layout
+        for (int level = 0; level < levelCount; level++)
+        {
+            GLsizei width = std::max(layerWidth >> level, 1), height = std::max(layerHeight >> level, 1);
+            if (bptc)
+                glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, capacity, 0,
+                                       static_cast<GLsizei>(textureLevelBytes(internalFormat, width, height) * capacity),
+                                       nullptr);
+            else
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, capacity, 0, GL_RGBA,
+                             GL_UNSIGNED_BYTE, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    trackTextureMemory(textureID, textureChainBytes(internalFormat, layerWidth, layerHeight, 0, levelCount) * capacity);
+
+    if (sources.empty())
+    {
+        std::vector<uint8_t> white(static_cast<size_t>(layerWidth) * layerHeight * 4, 255);
+        replaceLayer(0, prepareLayer(white.data(), layerWidth, layerHeight, 4));
+    }
+
+    for (size_t layer = 0; layer < sources.size(); layer++)
+    {
+        const MaterialSource &source = sources[layer];
+        const bool direct = source.compressed && static_cast<int>(source.info.width) == layerWidth &&
+                            static_cast<int>(source.info.height) == layerHeight &&
+                            static_cast<int>(source.info.levels.size()) == levelCount;
+        if (direct)
+        {
+            // Straight from the asset bytes; nothing is decoded or recompressed
+            glState().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+            for (int level = 0; level < levelCount; level++)
+            {
+                const Ktx2Level &data = source.info.levels[level];
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>(layer),
+                                          std::max(layerWidth >> level, 1), std::max(layerHeight >> level, 1), 1,
+                                          internalFormat, static_cast<GLsizei>(data.byteLength),
+                                          source.ktx2.data + data.byteOffset);
+            }
+        }
+        else
+        {
+            // A different size (or no BC7 asset): decode the source image and fit it to the layer
+            DecodedImage decoded;
+            const DecodedImage *image = &source.image;
+            ResourceData resource;
+            if (source.compressed)
+            {
+                if (!loadResource(source.path + ".jpg", resource) || !decodeImage(resource.data, resource.size, 4, decoded))
+                {
+                    spdlog::error("Failed to load texture: {}.jpg", source.path);
+                    continue;
+                }
+                image = &decoded;
+            }
+            replaceLayer(static_cast<int>(layer), prepareLayer(image->data(), image->width, image->height, 4));
+        }
+        spdlog::info("Texture: {} loaded into array layer {}{}", source.path, layer,
+                     direct ? " (BC7 asset)" : "");
+    }
+
+    spdlog::info("Texture array: {}x{}, {} layers, {} levels, {}", layerWidth, layerHeight, capacity, levelCount,
+                 bptc ? "BC7" : "RGBA8");
+}
+
+TextureArray::~TextureArray()
+{
+    untrackTextureMemory(textureID);
+    glState().deleteTextures(1, &textureID);
+}
+
+int TextureArray::layer(const std::string &basePath) const
+{
+    std::shared_ptr<Layer> found = layers.find(basePath);
+    return found ? found->index : -1;
+}
+
+std::vector<MipLevel> TextureArray::prepareLayer(const uint8_t *pixels, int width, int height, int channels) const
+{
+    std::vector<uint8_t> rgba;
+    if (channels == 3)
+    {
+        rgba.resize(static_cast<size_t>(width) * height * 4);
+        expandRGBToRGBA(pixels, rgba.data(), static_cast<size_t>(width) * height);
+        pixels = rgba.data();
+    }
+    std::vector<uint8_t> resized = resampleImage(pixels, width, height, 4, layerWidth, layerHeight);
+    std::vector<MipLevel> levels = buildMipChain(resized.data(), layerWidth, layerHeight, 4);
+    if (internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM)
+    {
+        std::vector<std::vector<uint8_t>> blocks = compressMipChain(levels, BlockFormat::BC7);
+        for (size_t level = 0; level < levels.size(); level++)
+            levels[level].pixels = std::move(blocks[level]);
+    }
+    return levels;
+}
+
+void TextureArray::replaceLayer(int layer, const std::vector<MipLevel> &levels)
+{
+    glState().bindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < levels.size(); level++)
+    {
+        const MipLevel &mip = levels[level];
+        if (internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, layer, mip.width,
+                                      mip.height, 1, internalFormat, static_cast<GLsizei>(mip.pixels.size()),
+                                      mip.pixels.data());
+        else
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, layer, mip.width, mip.height, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, mip.pixels.data());
+    }
+}
+
+void TextureArray::bind(GLuint unit) const
+{
+    glState().bindTexture(unit, GL_TEXTURE_2D_ARRAY, textureID);
+}
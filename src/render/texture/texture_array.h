@@ -0,0 +1,62 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <vector>
+#include "mipmap.h"
+#include "texture_cache.h"
+
+// GL_TEXTURE_2D_ARRAY with immutable storage holding same-sized material textures.
+// Bind it once and select materials per draw (or per instance) with a layer index.
+//
+// Layers are BC7 when the driver supports it, filled straight from the "<basePath>.bc7.ktx2" assets
+// built at compile time; otherwise (or for an asset of another size) "<basePath>.jpg" is decoded,
+// resampled to the layer size and compressed here. Without BC7 the array is RGBA8.
+class TextureArray
+{
+public:
+    // One layer per material, in order; the layer size is that of the first material that loads and
+    // the storage holds exactly the materials that loaded
+    explicit TextureArray(const std::vector<std::string> &basePaths);
+    ~TextureArray();
+    TextureArray(const TextureArray &) = delete;
+    TextureArray &operator=(const TextureArray &) = delete;
+
+    // Layer of a material passed to the constructor, or -1 if it failed to load
+    int layer(const std::string &basePath) const;
+
+    // Resample to the layer size, build its mip chain and compress it to the array's format.
+    // No GL calls, safe on worker threads.
+    std::vector<MipLevel> prepareLayer(const uint8_t *pixels, int width, int height, int channels) const;
+
+    // Overwrite an existing layer in place with levels from prepareLayer()
+    void replaceLayer(int layer, const std::vector<MipLevel> &levels);
+
+    void bind(GLuint unit) const;
+
+    GLuint id() const { return textureID; }
+    GLenum format() const { return internalFormat; }
+    int width() const { return layerWidth; }
+    int height() const { return layerHeight; }
+    int layerCount() const { return capacity; }
+
+private:
+    GLuint textureID = 0;
+    GLenum internalFormat = GL_RGBA8;
+    int layerWidth = 4;
+    int layerHeight = 4;
+    int levelCount = 1;
+    int capacity = 0;
+
+    struct Layer
+    {
+        int index;
+    };
+    TextureCache<Layer> layers;                     // By base path
+    std::vector<std::shared_ptr<Layer>> heldLayers; // Immutable storage: every layer lives as long as the array
+};
+
+#endif /* TEXTURE_ARRAY_H */
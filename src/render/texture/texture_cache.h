@@ -0,0 +1,119 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../io/path.h"
+
+// Deduplicating registry of whatever is loaded from a texture path: streamed textures, array
+// layers, hot reload targets. Entries are keyed by the hash of the normalized path and compared by
+// that path, so a hash collision never hands out another file. Requesting a path again returns the
+// same object; it is destroyed (its GL storage with it) when the last handle drops, and handles may
+// outlive the cache. Not thread-safe: keep acquiring and dropping handles on the GL thread.
+template <typename T>
+class TextureCache
+{
+public:
+    using Handle = std::shared_ptr<T>;
+    // Called with the normalized path on a miss; nullptr when loading failed (nothing is cached)
+    using Load = std::function<std::unique_ptr<T>(const std::string &path)>;
+
+    TextureCache() : state(std::make_shared<State>()) {}
+    TextureCache(const TextureCache &) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    // The live entry for this path, loading it on first request
+    Handle acquire(const std::string &path, const Load &load)
+    {
+        std::string normalized = normalizePath(path);
+        uint64_t key = hashPath(normalized);
+        if (Handle existing = state->find(key, normalized))
+            return existing;
+
+        std::unique_ptr<T> loaded = load(normalized);
+        if (!loaded)
+            return nullptr;
+
+        std::shared_ptr<Owner> owner(new Owner{state, key, std::move(loaded)});
+        Handle handle(owner, owner->object.get());
+        state->buckets[key].push_back({normalized, handle.get(), handle});
+        return handle;
+    }
+
+    // The live entry for this path, or nullptr
+    Handle find(const std::string &path) const
+    {
+        std::string normalized = normalizePath(path);
+        return state->find(hashPath(normalized), normalized);
+    }
+
+    size_t size() const
+    {
+        size_t count = 0;
+        for (const auto &bucket : state->buckets)
+            count += bucket.second.size();
+        return count;
+    }
+
+private:
+    struct Entry
+    {
+        std::string path; // Normalized
+        const T *object;  // Identifies the entry while its deleter runs, when the weak_ptr has already expired
+        std::weak_ptr<T> handle;
+    };
+
+    struct State
+    {
+        // Paths whose hashes collide share a bucket
+        std::unordered_map<uint64_t, std::vector<Entry>> buckets;
+
+        Handle find(uint64_t key, const std::string &path) const
+        {
+            auto it = buckets.find(key);
+            if (it == buckets.end())
+                return nullptr;
+            for (const Entry &entry : it->second)
+                if (entry.path == path)
+                    return entry.handle.lock();
+            return nullptr;
+        }
+
+        void erase(uint64_t key, const T *object)
+        {
+            auto it = buckets.find(key);
+            if (it == buckets.end())
+                return;
+            std::vector<Entry> &bucket = it->second;
+            bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [object](const Entry &entry)
+                                        { return entry.object == object; }),
+                         bucket.end());
+            if (bucket.empty())
+                buckets.erase(it);
+        }
+    };
+
+    // Shared by all handles to one entry; destroying it plays the deleter. It sees the state only
+    // weakly, so dropping a handle after the cache is gone just frees the object.
+    struct Owner
+    {
+        std::weak_ptr<State> state;
+        uint64_t key;
+        std::unique_ptr<T> object;
+
+        ~Owner()
+        {
+            if (std::shared_ptr<State> cache = state.lock())
+                cache->erase(key, object.get());
+        }
+    };
+
+    std::shared_ptr<State> state;
+};
+
+#endif /* TEXTURE_CACHE_H */
@@ -0,0 +1,68 @@
+#include "texture_memory.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+static std::unordered_map<GLuint, size_t> trackedTextures;
+static size_t trackedBytes = 0;
+
+size_t textureLevelBytes(GLenum internalFormat, int width, int height)
+{
+    const size_t blocks = static_cast<size_t>((std::max(width, 1) + 3) / 4) * ((std::max(height, 1) + 3) / 4);
+    const size_t texels = static_cast<size_t>(std::max(width, 1)) * std::max(height, 1);
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return blocks * 8;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return blocks * 16;
+    case GL_RED:
+    case GL_R8:
+        return texels;
+    default:
+        // RGB8 is padded to four bytes per texel by every driver we ship on
+        return texels * 4;
+    }
+}
+
+size_t textureChainBytes(GLenum internalFormat, int width, int height, int firstLevel, int levelCount)
+{
+    size_t bytes = 0;
+    for (int level = firstLevel; level < levelCount; level++)
+        bytes += textureLevelBytes(internalFormat, std::max(width >> level, 1), std::max(height >> level, 1));
+    return bytes;
+}
+
+void trackTextureMemory(GLuint textureID, size_t bytes)
+{
+    if (textureID == 0)
+        return;
+    untrackTextureMemory(textureID);
+    if (bytes == 0)
+        return;
+    trackedTextures[textureID] = bytes;
+    trackedBytes += bytes;
+}
+
+void untrackTextureMemory(GLuint textureID)
+{
+    auto it = trackedTextures.find(textureID);
+    if (it == trackedTextures.end())
+        return;
+    trackedBytes -= it->second;
+    trackedTextures.erase(it);
+}
+
+size_t textureMemoryUsed()
+{
+    return trackedBytes;
+}
+
+size_t textureMemoryCount()
+{
+    return trackedTextures.size();
+}
@@ -0,0 +1,24 @@
+#ifndef TEXTURE_MEMORY_H
+#define TEXTURE_MEMORY_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// Estimated GPU memory of every live texture, keyed by GL name. Owners report what they allocate
+// and free; TextureStreamer reads the total to hold the process under its memory budget.
+// Estimates ignore driver padding and alignment. GL thread only.
+
+// Bytes of one width x height level (per layer) in the given internal format
+size_t textureLevelBytes(GLenum internalFormat, int width, int height);
+
+// Bytes of levels [firstLevel, levelCount) of a 2D texture whose level 0 is width x height
+size_t textureChainBytes(GLenum internalFormat, int width, int height, int firstLevel, int levelCount);
+
+// Record (or overwrite) the size of a texture; 0 bytes forgets it
+void trackTextureMemory(GLuint textureID, size_t bytes);
+void untrackTextureMemory(GLuint textureID);
+
+size_t textureMemoryUsed();
+size_t textureMemoryCount();
+
+#endif /* TEXTURE_MEMORY_H */
@@ -0,0 +1,92 @@
+#include "texture_reloader.h"
+
+#include <fstream>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include "../../io/path.h"
+
+TextureReloader::TextureReloader(const std::string &resourceDirectory)
+    : watcher(resourceDirectory), worker(&TextureReloader::workerLoop, this)
+{
+}
+
+TextureReloader::~TextureReloader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+    worker.join();
+}
+
+TextureReloader::Handle TextureReloader::track(const std::string &path, Prepare prepare, Apply apply)
+{
+    Handle target = targets.acquire(path, [](const std::string &)
+                                    { return std::make_unique<Target>(); });
+    target->prepare = std::move(prepare);
+    target->apply = std::move(apply);
+    return target;
+}
+
+void TextureReloader::update()
+{
+    // Watcher paths are relative to the resource directory, which stands for "resources/"
+    for (const std::string &changed : watcher.takeChanges())
+    {
+        std::string path = normalizePath("resources/" + changed);
+        Handle target = targets.find(path);
+        if (!target)
+            continue;
+
+        spdlog::info("Texture changed on disk, reloading: {}", path);
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({path, watcher.directory() + "/" + changed, target->prepare});
+        jobAvailable.notify_one();
+    }
+
+    Result result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (results.empty())
+            return;
+        result = std::move(results.front());
+        results.pop_front();
+    }
+    Handle target = targets.find(result.path);
+    if (target && !result.levels.empty())
+    {
+        target->apply(result.levels);
+        spdlog::info("Texture reloaded: {} ({}x{})", result.path, result.levels[0].width, result.levels[0].height);
+    }
+}
+
+void TextureReloader::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]
+                              { return !running || !jobs.empty(); });
+            if (!running)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        std::ifstream file(job.filePath, std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        DecodedImage image;
+        if (bytes.empty() || !decodeImage(bytes.data(), bytes.size(), 4, image))
+        {
+            spdlog::warn("Failed to decode reloaded texture: {}", job.filePath);
+            continue;
+        }
+
+        Result result{job.path, job.prepare(image)};
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    }
+}
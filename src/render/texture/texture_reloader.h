@@ -0,0 +1,76 @@
+#ifndef TEXTURE_RELOADER_H
+#define TEXTURE_RELOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image_decoder.h"
+#include "mipmap.h"
+#include "texture_cache.h"
+#include "../../io/file_watcher.h"
+
+// Hot reload for textures. A FileWatcher reports edited files under the resource directory; the
+// worker thread decodes them and runs the owner's prepare step (resampling, mips). Only the final
+// upload runs on the GL thread, one texture per frame, so an edit never causes a hitch.
+class TextureReloader
+{
+public:
+    // Worker thread: turn the decoded RGBA image into the levels to upload
+    using Prepare = std::function<std::vector<MipLevel>(const DecodedImage &image)>;
+    // GL thread: upload the levels behind the existing texture / handle
+    using Apply = std::function<void(const std::vector<MipLevel> &levels)>;
+
+    struct Target
+    {
+        Prepare prepare;
+        Apply apply;
+    };
+    // Keeps a path tracked; it stops reloading once every handle to it is dropped
+    using Handle = TextureCache<Target>::Handle;
+
+    // resourceDirectory is watched on disk; tracked paths are "resources/..." like everywhere else
+    explicit TextureReloader(const std::string &resourceDirectory);
+    ~TextureReloader();
+    TextureReloader(const TextureReloader &) = delete;
+    TextureReloader &operator=(const TextureReloader &) = delete;
+
+    // Reload `path` whenever its file changes; a later call for the same path replaces the callbacks
+    Handle track(const std::string &path, Prepare prepare, Apply apply);
+
+    // Queue reloads for changed files and apply at most one finished reload; once per frame
+    void update();
+
+private:
+
+    struct Job
+    {
+        std::string path; // Normalized resource path
+        std::string filePath;
+        Prepare prepare;
+    };
+
+    struct Result
+    {
+        std::string path;
+        std::vector<MipLevel> levels;
+    };
+
+    void workerLoop();
+
+    FileWatcher watcher;
+    TextureCache<Target> targets; // GL thread only
+
+    std::thread worker;
+    std::atomic<bool> running{true};
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<Job> jobs;
+    std::deque<Result> results;
+};
+
+#endif /* TEXTURE_RELOADER_H */
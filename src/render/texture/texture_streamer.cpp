@@ -0,0 +1,575 @@
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include "image_decoder.h"
+#include "texture.h"
+#include "texture_memory.h"
+#include "../state/gl_state.h"
+#include "../../io/resource_loader.h"
+
+// Levels at or below this size are uploaded synchronously by request() and never dropped
+static const int mipTailSize = 64;
+
+// Textures not drawn for this many frames are evicted before anything in view loses detail
+static const uint64_t evictAfterFrames = 120;
+
+// Dropped levels only come back while usage stays under this share of the budget (hysteresis)
+static const double restoreThreshold = 0.9;
+
+// Read [offset, offset + length) of an embedded resource or file; length is clamped to what exists
+static bool readResourceRange(const std::string &path, uint64_t offset, uint64_t length,
+                              std::vector<uint8_t> &out, uint64_t *totalSize = nullptr)
+{
+    if (const EmbeddedResource *embedded = findEmbeddedResource(path))
+    {
+        if (offset > embedded->size)
+            return false;
+        length = std::min<uint64_t>(length, embedded->size - offset);
+        out.assign(embedded->data + offset, embedded->data + offset + length);
+        if (totalSize)
+            *totalSize = embedded->size;
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+    if (offset > size)
+        return false;
+    length = std::min<uint64_t>(length, size - offset);
+    out.resize(length);
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(reinterpret_cast<char *>(out.data()), static_cast<std::streamsize>(length));
+    if (totalSize)
+        *totalSize = size;
+    return file.good();
+}
+
+TextureStreamer::Texture::~Texture()
+{
+    untrackTextureMemory(textureID);
+    glState().deleteTextures(1, &textureID);
+}
+
+// Allocate levels [topLevel, levelCount) of a width x height texture; source level l is GL level l - topLevel
+static GLuint createStorage(GLenum glFormat, int width, int height, int topLevel, int levelCount)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glState().bindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - topLevel - 1);
+
+    if (GLAD_GL_VERSION_4_2)
+    {
+        glTexStorage2D(GL_TEXTURE_2D, levelCount - topLevel, glFormat, std::max(width >> topLevel, 1),
+                       std::max(height >> topLevel, 1));
+    }
+    else
+    {
+        for (int level = topLevel; level < levelCount; level++)
+        {
+            GLsizei levelWidth = std::max(width >> level, 1);
+            GLsizei levelHeight = std::max(height >> level, 1);
+            if (glFormat == GL_RGBA8)
+                glTexImage2D(GL_TEXTURE_2D, level - topLevel, GL_RGBA8, levelWidth, levelHeight, 0, GL_RGBA,
+                             GL_UNSIGNED_BYTE, nullptr);
+            else
+                glCompressedTexImage2D(GL_TEXTURE_2D, level - topLevel, glFormat, levelWidth, levelHeight, 0,
+                                       static_cast<GLsizei>(textureLevelBytes(glFormat, levelWidth, levelHeight)), nullptr);
+        }
+    }
+    trackTextureMemory(texture, textureChainBytes(glFormat, width, height, topLevel, levelCount));
+    return texture;
+}
+
+// Upload one source level into the bound texture created by createStorage() with the same topLevel
+static void uploadLevel(int width, int height, int topLevel, int level, GLenum glFormat, const std::vector<uint8_t> &data)
+{
+    GLsizei levelWidth = std::max(width >> level, 1);
+    GLsizei levelHeight = std::max(height >> level, 1);
+    if (glFormat == GL_RGBA8)
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, level - topLevel, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                        data.data());
+    }
+    else
+    {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level - topLevel, 0, 0, levelWidth, levelHeight, glFormat,
+                                  static_cast<GLsizei>(data.size()), data.data());
+    }
+}
+
+TextureStreamer::TextureStreamer(size_t uploadBudgetBytes)
+    : uploadBudget(uploadBudgetBytes), worker(&TextureStreamer::workerLoop, this)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+    worker.join();
+}
+
+std::shared_ptr<TextureStreamer::Texture> TextureStreamer::request(const std::string &basePath)
+{
+    // A path already requested shares the texture; it is freed once nobody holds it any more
+    bool created = false;
+    auto create = [this, &created](const std::string &path)
+    {
+        auto texture = std::make_unique<Texture>();
+        texture->path = path;
+        texture->lastUsedFrame = frame;
+        created = true;
+        return texture;
+    };
+    std::shared_ptr<Texture> texture = cache.acquire(basePath, create);
+    if (!created)
+        return texture;
+
+    const std::string &path = texture->path;
+    if ((isBptcSupported() && startKtx2(texture, path + ".bc7.ktx2", GL_COMPRESSED_RGBA_BPTC_UNORM)) ||
+        (isS3tcSupported() && startKtx2(texture, path + ".bc1.ktx2", GL_COMPRESSED_RGB_S3TC_DXT1_EXT)) ||
+        startImage(texture, path + ".jpg"))
+    {
+        textures.push_back(texture);
+        return texture;
+    }
+
+    spdlog::error("Failed to stream texture: {}", basePath);
+    return nullptr; // Dropping the handle takes it out of the cache again
+}
+
+bool TextureStreamer::startKtx2(const std::shared_ptr<Texture> &texture, const std::string &path, GLenum glFormat)
+{
+    // Only the header and level index are read here; load() adds the mip tail, the worker the rest
+    std::vector<uint8_t> head;
+    uint64_t fileSize = 0;
+    Ktx2Info info;
+    if (!readResourceRange(path, 0, ktx2HeaderSize + 32 * ktx2LevelIndexEntrySize, head, &fileSize) ||
+        !parseKtx2(head.data(), head.size(), info, fileSize) || glFormatForVkFormat(info.vkFormat) != glFormat)
+        return false;
+
+    texture->width = static_cast<int>(info.width);
+    texture->height = static_cast<int>(info.height);
+    texture->levelCount = static_cast<int>(info.levels.size());
+    texture->compressed = true;
+    texture->sourcePath = path;
+    texture->ktx2 = true;
+    texture->glFormat = glFormat;
+    texture->levelRanges.clear();
+    for (const Ktx2Level &level : info.levels)
+        texture->levelRanges.emplace_back(level.byteOffset, level.byteLength);
+    return load(texture);
+}
+
+bool TextureStreamer::startImage(const std::shared_ptr<Texture> &texture, const std::string &path)
+{
+    if (!findEmbeddedResource(path) && !std::ifstream(path))
+        return false;
+
+    texture->sourcePath = path;
+    texture->glFormat = GL_RGBA8;
+    return load(texture);
+}
+
+bool TextureStreamer::load(const std::shared_ptr<Texture> &texture)
+{
+    if (!texture->ktx2)
+    {
+        // Nothing is known until the worker decodes the image: show a neutral 1x1 placeholder
+        const uint8_t gray[4] = {128, 128, 128, 255};
+        glGenTextures(1, &texture->textureID);
+        glState().bindTexture(GL_TEXTURE_2D, texture->textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, gray);
+        trackTextureMemory(texture->textureID, textureLevelBytes(GL_RGBA8, 1, 1));
+        texture->residentLevel = INT_MAX; // Placeholder, replaced by the first decoded level
+        queueLevels(texture, INT_MAX, texture->topLevel);
+        return true;
+    }
+
+    const int levelCount = texture->levelCount;
+    texture->textureID = createStorage(texture->glFormat, texture->width, texture->height, texture->topLevel, levelCount);
+
+    // Upload the mip tail now so the texture is usable this frame
+    int tailStart = levelCount - 1;
+    while (tailStart > texture->topLevel &&
+           std::max(texture->width >> (tailStart - 1), texture->height >> (tailStart - 1)) <= mipTailSize)
+        tailStart--;
+
+    std::vector<uint8_t> levelData;
+    for (int level = levelCount - 1; level >= tailStart; level--)
+    {
+        if (!readResourceRange(texture->sourcePath, texture->levelRanges[level].first, texture->levelRanges[level].second,
+                               levelData))
+        {
+            untrackTextureMemory(texture->textureID);
+            glState().deleteTextures(1, &texture->textureID);
+            texture->textureID = 0;
+            return false;
+        }
+        uploadLevel(texture->width, texture->height, texture->topLevel, level, texture->glFormat, levelData);
+    }
+    setResidentLevel(*texture, tailStart);
+
+    spdlog::info("Texture: {} streaming: {}x{} ({} levels, tail from level {})", texture->sourcePath, texture->width,
+                 texture->height, levelCount, tailStart);
+
+    if (tailStart > texture->topLevel)
+        queueLevels(texture, tailStart - 1, texture->topLevel);
+    return true;
+}
+
+void TextureStreamer::queueLevels(const std::shared_ptr<Texture> &texture, int firstLevel, int lastLevel)
+{
+    Job job;
+    job.texture = texture;
+    job.path = texture->sourcePath;
+    job.ktx2 = texture->ktx2;
+    job.glFormat = texture->glFormat;
+    job.levelRanges = texture->levelRanges;
+    job.decodedLevels = texture->decodedLevels;
+    job.firstLevel = firstLevel;
+    job.lastLevel = lastLevel;
+    job.generation = texture->generation;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+    jobAvailable.notify_one();
+}
+
+void TextureStreamer::setResidentLevel(Texture &texture, int level)
+{
+    texture.residentLevel = level;
+    glState().bindTexture(GL_TEXTURE_2D, texture.textureID);
+    // The base level alone hides the missing ones: sampling LODs are relative to it, so also raising
+    // MIN_LOD would skip as many resident levels again
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - texture.topLevel);
+}
+
+void TextureStreamer::reallocate(Texture &texture, int topLevel)
+{
+    // New storage for [topLevel, levelCount); resident levels both textures share move over on the GPU
+    GLuint replacement = createStorage(texture.glFormat, texture.width, texture.height, topLevel, texture.levelCount);
+    const int firstCopied = std::max(texture.residentLevel, topLevel);
+    std::vector<uint8_t> pixels;
+    for (int level = firstCopied; level < texture.levelCount; level++)
+    {
+        GLsizei width = std::max(texture.width >> level, 1);
+        GLsizei height = std::max(texture.height >> level, 1);
+        if (GLAD_GL_VERSION_4_3)
+        {
+            glCopyImageSubData(texture.textureID, GL_TEXTURE_2D, level - texture.topLevel, 0, 0, 0, replacement,
+                               GL_TEXTURE_2D, level - topLevel, 0, 0, 0, width, height, 1);
+            continue;
+        }
+
+        // Older contexts round-trip through client memory
+        glState().bindTexture(GL_TEXTURE_2D, texture.textureID);
+        pixels.resize(textureLevelBytes(texture.glFormat, width, height));
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        if (texture.compressed)
+            glGetCompressedTexImage(GL_TEXTURE_2D, level - texture.topLevel, pixels.data());
+        else
+            glGetTexImage(GL_TEXTURE_2D, level - texture.topLevel, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glState().bindTexture(GL_TEXTURE_2D, replacement);
+        uploadLevel(texture.width, texture.height, topLevel, level, texture.glFormat, pixels);
+    }
+
+    untrackTextureMemory(texture.textureID);
+    glState().deleteTextures(1, &texture.textureID);
+    texture.textureID = replacement;
+    texture.topLevel = topLevel;
+    setResidentLevel(texture, firstCopied);
+}
+
+void TextureStreamer::evict(Texture &texture)
+{
+    untrackTextureMemory(texture.textureID);
+    glState().deleteTextures(1, &texture.textureID);
+    texture.textureID = 0;
+    texture.evicted = true;
+    texture.generation++; // Whatever is still streaming for it is stale now
+    spdlog::info("Texture: {} evicted (unused for {} frames)", texture.path, frame - texture.lastUsedFrame);
+}
+
+void TextureStreamer::touch(const std::shared_ptr<Texture> &texture)
+{
+    texture->lastUsedFrame = frame;
+    if (!texture->evicted)
+        return;
+
+    texture->evicted = false;
+    if (!load(texture))
+        spdlog::error("Failed to reload evicted texture: {}", texture->path);
+}
+
+void TextureStreamer::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]
+                              { return !running || !jobs.empty(); });
+            if (!running)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        processJob(job);
+    }
+}
+
+void TextureStreamer::processJob(Job &job)
+{
+    // Never lock the texture here: the last reference must be dropped on the GL thread
+    if (job.ktx2)
+    {
+        for (int level = job.firstLevel; level >= job.lastLevel && running && !job.texture.expired(); level--)
+        {
+            ReadyLevel ready;
+            ready.texture = job.texture;
+            ready.level = level;
+            ready.generation = job.generation;
+            ready.glFormat = job.glFormat;
+            ready.compressed = true;
+            if (!readResourceRange(job.path, job.levelRanges[level].first, job.levelRanges[level].second, ready.data))
+            {
+                spdlog::error("Failed to read level {} of {}", level, job.path);
+                return;
+            }
+            publish(std::move(ready));
+        }
+        return;
+    }
+
+    // The image is decoded once per texture; later jobs (dropped or evicted levels) copy from the chain
+    std::shared_ptr<const std::vector<MipLevel>> levels = job.decodedLevels;
+    std::shared_ptr<const std::vector<MipLevel>> decoded;
+    if (!levels)
+    {
+        ResourceData resource;
+        if (!loadResource(job.path, resource))
+        {
+            spdlog::error("Failed to load texture: {}", job.path);
+            return;
+        }
+
+        DecodedImage image;
+        if (!decodeImage(resource.data, resource.size, 4, image))
+        {
+            spdlog::error("Failed to decode texture: {}", job.path);
+            return;
+        }
+        decoded = std::make_shared<const std::vector<MipLevel>>(
+            buildMipChain(image.data(), image.width, image.height, 4));
+        levels = decoded;
+        spdlog::info("Texture: {} decoded for streaming: {}x{} ({} levels)", job.path, image.width, image.height,
+                     levels->size());
+    }
+
+    // Coarse to fine so every upload extends the resident range by one level
+    const int firstLevel = std::min(job.firstLevel, static_cast<int>(levels->size()) - 1);
+    for (int level = firstLevel; level >= job.lastLevel && running && !job.texture.expired(); level--)
+    {
+        ReadyLevel ready;
+        ready.texture = job.texture;
+        ready.level = level;
+        ready.generation = job.generation;
+        ready.width = (*levels)[0].width;
+        ready.height = (*levels)[0].height;
+        ready.glFormat = GL_RGBA8;
+        ready.data = (*levels)[level].pixels;
+        ready.decodedLevels = decoded;
+        publish(std::move(ready));
+    }
+}
+
+void TextureStreamer::publish(ReadyLevel &&level)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ready.push_back(std::move(level));
+}
+
+size_t TextureStreamer::pendingLevels() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return ready.size();
+}
+
+void TextureStreamer::update()
+{
+    frame++;
+
+    size_t uploaded = 0;
+    while (true)
+    {
+        ReadyLevel level;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ready.empty())
+                break;
+            // Always make progress, even when a single level exceeds the budget
+            if (uploaded > 0 && uploaded + ready.front().data.size() > uploadBudget)
+                break;
+            level = std::move(ready.front());
+            ready.pop_front();
+        }
+
+        std::shared_ptr<Texture> texture = level.texture.lock();
+        if (!texture || texture->generation != level.generation || texture->evicted)
+            continue;
+        if (level.decodedLevels && !texture->decodedLevels)
+            texture->decodedLevels = std::move(level.decodedLevels);
+
+        if (texture->residentLevel == INT_MAX)
+        {
+            // First decoded level of an image: the real size and level count are known now
+            texture->levelCount = level.level + 1;
+            texture->width = level.width;
+            texture->height = level.height;
+            texture->topLevel = std::min(texture->topLevel, level.level);
+            untrackTextureMemory(texture->textureID);
+            glState().deleteTextures(1, &texture->textureID);
+            texture->textureID = createStorage(GL_RGBA8, texture->width, texture->height, texture->topLevel,
+                                               texture->levelCount);
+            texture->residentLevel = texture->levelCount;
+        }
+
+        // Levels extend the resident range one at a time and never above the budget's top level
+        if (level.level != texture->residentLevel - 1 || level.level < texture->topLevel)
+            continue;
+
+        glState().bindTexture(GL_TEXTURE_2D, texture->textureID);
+        uploadLevel(texture->width, texture->height, texture->topLevel, level.level, level.glFormat, level.data);
+        uploaded += level.data.size();
+        setResidentLevel(*texture, level.level);
+        if (texture->complete())
+            spdlog::info("Texture: {} fully streamed", texture->path);
+    }
+
+    enforceBudget();
+}
+
+void TextureStreamer::enforceBudget()
+{
+    if (memoryBudget == 0)
+        return;
+
+    // Live textures, least recently used first
+    std::vector<std::shared_ptr<Texture>> live;
+    for (auto it = textures.begin(); it != textures.end();)
+    {
+        if (std::shared_ptr<Texture> texture = it->lock())
+        {
+            live.push_back(std::move(texture));
+            ++it;
+        }
+        else
+        {
+            it = textures.erase(it);
+        }
+    }
+    std::stable_sort(live.begin(), live.end(), [](const std::shared_ptr<Texture> &a, const std::shared_ptr<Texture> &b)
+                     { return a->lastUsedFrame < b->lastUsedFrame; });
+
+    if (textureMemoryUsed() > memoryBudget)
+    {
+        // Textures nobody draws go first; they come back on their next touch()
+        for (const std::shared_ptr<Texture> &texture : live)
+        {
+            if (textureMemoryUsed() <= memoryBudget)
+                break;
+            if (!texture->evicted && frame - texture->lastUsedFrame > evictAfterFrames)
+                evict(*texture);
+        }
+
+        // Then visible textures lose their finest level, least recently used first, down to the mip tail
+        while (textureMemoryUsed() > memoryBudget)
+        {
+            auto droppable = std::find_if(live.begin(), live.end(), [](const std::shared_ptr<Texture> &texture)
+                                          { return !texture->evicted && texture->residentLevel != INT_MAX &&
+                                                   std::max(texture->width >> (texture->topLevel + 1),
+                                                            texture->height >> (texture->topLevel + 1)) >= mipTailSize; });
+            if (droppable == live.end())
+            {
+                if (!overBudgetReported)
+                    spdlog::warn("Texture memory {} KB exceeds the {} KB budget; nothing left to evict",
+                                 textureMemoryUsed() / 1024, memoryBudget / 1024);
+                overBudgetReported = true;
+                return;
+            }
+            Texture &texture = **droppable;
+            reallocate(texture, texture.topLevel + 1);
+            spdlog::info("Texture: {} reduced to {}x{} for the memory budget", texture.path,
+                         std::max(texture.width >> texture.topLevel, 1), std::max(texture.height >> texture.topLevel, 1));
+        }
+        return;
+    }
+    overBudgetReported = false;
+
+    // Headroom: give the most recently used reduced texture one level back, once it has finished streaming
+    for (auto it = live.rbegin(); it != live.rend(); ++it)
+    {
+        Texture &texture = **it;
+        if (texture.evicted || texture.topLevel == 0 || texture.residentLevel != texture.topLevel)
+            continue;
+
+        const int level = texture.topLevel - 1;
+        size_t cost = textureLevelBytes(texture.glFormat, std::max(texture.width >> level, 1),
+                                        std::max(texture.height >> level, 1));
+        if (textureMemoryUsed() + cost <= static_cast<size_t>(memoryBudget * restoreThreshold))
+        {
+            reallocate(texture, level);
+            queueLevels(*it, level, level);
+        }
+        break;
+    }
+}
+
+void TextureStreamer::replace(Texture &texture, const std::vector<MipLevel> &levels)
+{
+    if (levels.empty())
+        return;
+
+    // Kept so the reloaded image, not the original source, comes back after an eviction
+    texture.decodedLevels = std::make_shared<const std::vector<MipLevel>>(levels);
+    texture.ktx2 = false;
+    texture.glFormat = GL_RGBA8;
+    texture.compressed = false;
+    texture.generation++;
+    if (texture.evicted)
+        return;
+
+    // Build the replacement completely before the swap, so no frame ever sees a partial texture
+    texture.width = levels[0].width;
+    texture.height = levels[0].height;
+    texture.levelCount = static_cast<int>(levels.size());
+    texture.topLevel = std::min(texture.topLevel, texture.levelCount - 1);
+    GLuint replacement = createStorage(GL_RGBA8, texture.width, texture.height, texture.topLevel, texture.levelCount);
+    untrackTextureMemory(texture.textureID);
+    glState().deleteTextures(1, &texture.textureID);
+    texture.textureID = replacement;
+    for (int level = texture.topLevel; level < texture.levelCount; level++)
+        uploadLevel(texture.width, texture.height, texture.topLevel, level, GL_RGBA8, levels[level].pixels);
+    setResidentLevel(texture, texture.topLevel);
+}
@@ -0,0 +1,137 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mipmap.h"
+#include "texture_cache.h"
+
+// Progressive texture loader. request() uploads the pre-baked mip tail (or a 1x1 placeholder)
+// immediately; a worker thread reads/decodes the larger levels, and update() uploads them on the
+// GL thread within a per-frame byte budget. GL_TEXTURE_BASE_LEVEL hides the levels not loaded yet.
+//
+// With a memory budget set, update() also holds all tracked texture memory (texture_memory.h)
+// under it: textures not drawn for a while are evicted first, least recently used first, then
+// the top mips of the least recently used ones are dropped. touch() reloads evicted textures and
+// dropped levels come back, most recently used first, once there is headroom again.
+class TextureStreamer
+{
+public:
+    struct Texture
+    {
+        GLuint textureID = 0;
+        std::string path;
+        int width = 0;
+        int height = 0;
+        int levelCount = 0;
+        int residentLevel = 0; // Finest level uploaded so far
+        int topLevel = 0;      // Finest level with GL storage; levels above it were dropped for the budget
+        bool compressed = false;
+        bool evicted = false; // GL storage released for the budget; touch() reloads it
+        int generation = 0;   // Bumped by replace() and evictions; levels streamed for older generations are dropped
+        uint64_t lastUsedFrame = 0;
+
+        bool complete() const { return residentLevel == 0; }
+        ~Texture();
+
+    private:
+        friend class TextureStreamer;
+
+        // Where the levels come from, kept so evicted or dropped levels can be streamed again
+        std::string sourcePath;
+        bool ktx2 = false;
+        GLenum glFormat = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> levelRanges; // KTX2 byte ranges, finest first
+        // Full RGBA8 chain of a decoded image, or the one replace() swapped in: dropped or evicted
+        // levels come back from it without decoding again
+        std::shared_ptr<const std::vector<MipLevel>> decodedLevels;
+    };
+
+    explicit TextureStreamer(size_t uploadBudgetBytes = 4 * 1024 * 1024);
+    ~TextureStreamer();
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+    // Start streaming "<basePath>.bc7.ktx2" / ".bc1.ktx2" (when supported) or "<basePath>.jpg";
+    // requesting the same path again returns the same texture while it is still held
+    std::shared_ptr<Texture> request(const std::string &basePath);
+
+    // Upload finished levels and enforce the memory budget; call once per frame on the GL thread
+    void update();
+
+    // Mark a texture as drawn this frame, reloading it if it was evicted; call before binding it
+    void touch(const std::shared_ptr<Texture> &texture);
+
+    // Swap in a new RGBA8 GL texture built from a full mip chain (hot reload); GL thread only
+    void replace(Texture &texture, const std::vector<MipLevel> &levels);
+
+    size_t pendingLevels() const;
+    void setUploadBudget(size_t bytes) { uploadBudget = bytes; }
+
+    // Ceiling for all tracked texture memory in bytes; 0 disables eviction
+    void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+    size_t getMemoryBudget() const { return memoryBudget; }
+
+private:
+    struct Job
+    {
+        std::weak_ptr<Texture> texture;
+        std::string path;
+        bool ktx2 = false;
+        uint32_t glFormat = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> levelRanges;
+        std::shared_ptr<const std::vector<MipLevel>> decodedLevels;
+        int firstLevel = 0; // Coarsest level still missing
+        int lastLevel = 0;  // Finest level wanted
+        int generation = 0;
+    };
+
+    struct ReadyLevel
+    {
+        std::weak_ptr<Texture> texture;
+        int level = 0;
+        int generation = 0;
+        int width = 0; // Level 0 size of decoded images, which is unknown until the worker decodes them
+        int height = 0;
+        uint32_t glFormat = 0;
+        bool compressed = false;
+        std::vector<uint8_t> data;
+        std::shared_ptr<const std::vector<MipLevel>> decodedLevels; // The chain the worker just decoded, to keep
+    };
+
+    bool startKtx2(const std::shared_ptr<Texture> &texture, const std::string &path, GLenum glFormat);
+    bool startImage(const std::shared_ptr<Texture> &texture, const std::string &path);
+    bool load(const std::shared_ptr<Texture> &texture);
+    void queueLevels(const std::shared_ptr<Texture> &texture, int firstLevel, int lastLevel);
+    void reallocate(Texture &texture, int topLevel);
+    void setResidentLevel(Texture &texture, int level);
+    void evict(Texture &texture);
+    void enforceBudget();
+    void workerLoop();
+    void processJob(Job &job);
+    void publish(ReadyLevel &&level);
+
+    size_t uploadBudget;
+    size_t memoryBudget = 0;
+    uint64_t frame = 0;
+    bool overBudgetReported = false;
+    TextureCache<Texture> cache; // Live textures by path; GL thread only
+    std::vector<std::weak_ptr<Texture>> textures; // Every requested texture, for the budget; GL thread only
+
+    std::atomic<bool> running{true};
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<Job> jobs;
+    std::deque<ReadyLevel> ready;
+    std::thread worker; // Last, so it starts after everything it uses
+};
+
+#endif /* TEXTURE_STREAMER_H */
@@ -0,0 +1,335 @@
+#include "video_texture.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <spdlog/spdlog.h>
+#include "texture_memory.h"
+#include "../state/gl_state.h"
+
+// Limited or full range YUV to RGB; the matrix (BT.601 / BT.709) comes in through videoMatrix
+static const char *videoShaderText =
+    "uniform sampler2D videoLuma;\n"
+    "uniform sampler2D videoChromaU;\n"
+    "uniform sampler2D videoChromaV;\n"
+    "uniform vec4 videoRange;  // Luma offset, luma scale, chroma offset, chroma scale\n"
+    "uniform vec4 videoMatrix; // V->R, U->G, V->G, U->B\n"
+    "vec4 sampleVideo(vec2 uv)\n"
+    "{\n"
+    "    float y = (texture(videoLuma, uv).r - videoRange.x) * videoRange.y;\n"
+    "    float u = (texture(videoChromaU, uv).r - videoRange.z) * videoRange.w;\n"
+    "    float v = (texture(videoChromaV, uv).r - videoRange.z) * videoRange.w;\n"
+    "    vec3 rgb = vec3(y + videoMatrix.x * v, y - videoMatrix.y * u - videoMatrix.z * v, y + videoMatrix.w * u);\n"
+    "    return vec4(clamp(rgb, 0.0, 1.0), 1.0);\n"
+    "}\n";
+
+static GLuint createPlaneTexture(int width, int height)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glState().bindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    trackTextureMemory(texture, textureLevelBytes(GL_R8, width, height));
+    return texture;
+}
+
+VideoTexture::VideoTexture(const std::string &path, int rawWidth, int rawHeight, double rawFps)
+    : path(path), frameWidth(rawWidth), frameHeight(rawHeight), fps(rawFps)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file || !readHeader(file))
+    {
+        spdlog::error("Failed to open video: {}", path);
+        return;
+    }
+    frameBytes = static_cast<size_t>(frameWidth) * frameHeight + 2 * static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    // Persistent mappings let the reader write frames straight into GL memory (GL 4.4);
+    // otherwise it fills client staging memory that update() copies into the buffer
+    const bool persistent = GLAD_GL_VERSION_4_4 != 0;
+    const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (Slot &slot : slots)
+    {
+        glGenBuffers(1, &slot.buffer);
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        if (persistent)
+        {
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(frameBytes), nullptr, mapFlags);
+            slot.mapped = static_cast<uint8_t *>(
+                glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(frameBytes), mapFlags));
+        }
+        else
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(frameBytes), nullptr, GL_STREAM_DRAW);
+        }
+        if (!slot.mapped)
+            slot.staging.resize(frameBytes);
+    }
+    glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    lumaTexture = createPlaneTexture(frameWidth, frameHeight);
+    chromaTextures[0] = createPlaneTexture(chromaWidth, chromaHeight);
+    chromaTextures[1] = createPlaneTexture(chromaWidth, chromaHeight);
+
+    reader = std::thread(&VideoTexture::readerLoop, this);
+    spdlog::info("Video: {} {}x{} @ {:.2f} fps ({} KB per frame, {} upload buffers)", path, frameWidth, frameHeight,
+                 fps, frameBytes / 1024, persistent ? "persistent" : "staged");
+}
+
+VideoTexture::~VideoTexture()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    slotFreed.notify_all();
+    if (reader.joinable())
+        reader.join();
+
+    for (Slot &slot : slots)
+    {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        if (slot.mapped)
+        {
+            glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        glState().deleteBuffers(1, &slot.buffer);
+    }
+    glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    untrackTextureMemory(lumaTexture);
+    untrackTextureMemory(chromaTextures[0]);
+    untrackTextureMemory(chromaTextures[1]);
+    glState().deleteTextures(1, &lumaTexture);
+    glState().deleteTextures(2, chromaTextures);
+    if (presented > 0)
+        spdlog::info("Video: {} presented {} frames, dropped {}", path, presented, dropped);
+}
+
+const char *VideoTexture::shaderSource()
+{
+    return videoShaderText;
+}
+
+bool VideoTexture::readHeader(std::ifstream &file)
+{
+    char magic[10] = {};
+    file.read(magic, sizeof(magic));
+    y4m = file.gcount() == sizeof(magic) && std::memcmp(magic, "YUV4MPEG2 ", sizeof(magic)) == 0;
+    if (!y4m)
+    {
+        // Headerless: 4:2:0 planar frames of the size given by the caller
+        file.clear();
+        file.seekg(0);
+        chromaWidth = (frameWidth + 1) / 2;
+        chromaHeight = (frameHeight + 1) / 2;
+        dataStart = 0;
+        return frameWidth > 0 && frameHeight > 0 && fps > 0.0;
+    }
+
+    std::string line;
+    std::getline(file, line);
+    std::istringstream tokens(line);
+    std::string chroma = "420";
+    std::string token;
+    frameWidth = frameHeight = 0;
+    while (tokens >> token)
+    {
+        switch (token[0])
+        {
+        case 'W':
+            frameWidth = std::atoi(token.c_str() + 1);
+            break;
+        case 'H':
+            frameHeight = std::atoi(token.c_str() + 1);
+            break;
+        case 'F':
+        {
+            int numerator = 0, denominator = 0;
+            if (std::sscanf(token.c_str() + 1, "%d:%d", &numerator, &denominator) == 2 && numerator > 0 && denominator > 0)
+                fps = static_cast<double>(numerator) / denominator;
+            break;
+        }
+        case 'C':
+            chroma = token.substr(1);
+            break;
+        case 'X':
+            fullRange = token == "XCOLORRANGE=FULL";
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (chroma.compare(0, 3, "420") == 0)
+    {
+        chromaWidth = (frameWidth + 1) / 2;
+        chromaHeight = (frameHeight + 1) / 2;
+    }
+    else if (chroma == "422")
+    {
+        chromaWidth = (frameWidth + 1) / 2;
+        chromaHeight = frameHeight;
+    }
+    else if (chroma == "444")
+    {
+        chromaWidth = frameWidth;
+        chromaHeight = frameHeight;
+    }
+    else
+    {
+        spdlog::error("Unsupported Y4M chroma format C{}: {}", chroma, path);
+        return false;
+    }
+    dataStart = file.tellg();
+    return frameWidth > 0 && frameHeight > 0;
+}
+
+bool VideoTexture::readFrame(std::ifstream &file, uint8_t *destination)
+{
+    if (y4m)
+    {
+        // "FRAME" plus optional parameters, then the planes
+        std::string frameHeader;
+        if (!std::getline(file, frameHeader) || frameHeader.compare(0, 5, "FRAME") != 0)
+            return false;
+    }
+    file.read(reinterpret_cast<char *>(destination), static_cast<std::streamsize>(frameBytes));
+    return static_cast<size_t>(file.gcount()) == frameBytes;
+}
+
+void VideoTexture::readerLoop()
+{
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(dataStart);
+    uint64_t frame = 0;
+    for (int index = 0;; index = (index + 1) % slotCount)
+    {
+        Slot &slot = slots[index];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slotFreed.wait(lock, [this, &slot]
+                           { return !running || slot.state == SlotState::Free; });
+            if (!running)
+                return;
+        }
+
+        // The GL thread leaves free slots alone, so the frame is read without holding the lock
+        if (!readFrame(file, slot.memory()))
+        {
+            // End of file: loop back to the first frame
+            file.clear();
+            file.seekg(dataStart);
+            if (!readFrame(file, slot.memory()))
+            {
+                spdlog::error("Failed to read video frame: {}", path);
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        slot.frame = frame++;
+        slot.state = SlotState::Filled;
+    }
+}
+
+void VideoTexture::update(double seconds)
+{
+    if (!valid())
+        return;
+    if (startTime < 0.0)
+        startTime = seconds;
+    const uint64_t due = static_cast<uint64_t>((seconds - startTime) * fps);
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Hand buffers the GPU has finished reading back to the reader
+    for (Slot &slot : slots)
+    {
+        if (slot.state == SlotState::InFlight && glClientWaitSync(slot.fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+        {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            slot.state = SlotState::Free;
+            slotFreed.notify_one();
+        }
+    }
+
+    // Present the newest frame that is due; older due frames are skipped
+    Slot *latest = nullptr;
+    while (slots[uploadIndex].state == SlotState::Filled && slots[uploadIndex].frame <= due)
+    {
+        if (latest)
+        {
+            latest->state = SlotState::Free;
+            dropped++;
+            slotFreed.notify_one();
+        }
+        latest = &slots[uploadIndex];
+        uploadIndex = (uploadIndex + 1) % slotCount;
+    }
+    lock.unlock();
+
+    if (latest)
+        upload(*latest);
+}
+
+void VideoTexture::upload(Slot &slot)
+{
+    glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    if (!slot.mapped)
+    {
+        // Orphan the old storage so the copy never waits for the previous upload
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(frameBytes), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(frameBytes), slot.staging.data());
+    }
+
+    // Planes are tightly packed one after another: Y, then U, then V
+    const size_t lumaBytes = static_cast<size_t>(frameWidth) * frameHeight;
+    const size_t chromaBytes = static_cast<size_t>(chromaWidth) * chromaHeight;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glState().bindTexture(GL_TEXTURE_2D, lumaTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frameWidth, frameHeight, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glState().bindTexture(GL_TEXTURE_2D, chromaTextures[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chromaWidth, chromaHeight, GL_RED, GL_UNSIGNED_BYTE,
+                    reinterpret_cast<const void *>(lumaBytes));
+    glState().bindTexture(GL_TEXTURE_2D, chromaTextures[1]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chromaWidth, chromaHeight, GL_RED, GL_UNSIGNED_BYTE,
+                    reinterpret_cast<const void *>(lumaBytes + chromaBytes));
+    glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    std::lock_guard<std::mutex> lock(mutex);
+    slot.state = SlotState::InFlight;
+    presented++;
+}
+
+void VideoTexture::bind(GLuint program, GLuint firstUnit) const
+{
+    const GLuint planes[3] = {lumaTexture, chromaTextures[0], chromaTextures[1]};
+    for (GLuint i = 0; i < 3; i++)
+        glState().bindTexture(firstUnit + i, GL_TEXTURE_2D, planes[i]);
+
+    glUniform1i(glGetUniformLocation(program, "videoLuma"), firstUnit);
+    glUniform1i(glGetUniformLocation(program, "videoChromaU"), firstUnit + 1);
+    glUniform1i(glGetUniformLocation(program, "videoChromaV"), firstUnit + 2);
+    if (fullRange)
+        glUniform4f(glGetUniformLocation(program, "videoRange"), 0.0f, 1.0f, 128.0f / 255.0f, 1.0f);
+    else
+        glUniform4f(glGetUniformLocation(program, "videoRange"), 16.0f / 255.0f, 255.0f / 219.0f, 128.0f / 255.0f,
+                    255.0f / 224.0f);
+
+    // Y4M carries no matrix: HD sources are BT.709, SD ones BT.601
+    if (frameHeight >= 720)
+        glUniform4f(glGetUniformLocation(program, "videoMatrix"), 1.5748f, 0.1873f, 0.4681f, 1.8556f);
+    else
+        glUniform4f(glGetUniformLocation(program, "videoMatrix"), 1.402f, 0.344136f, 0.714136f, 1.772f);
+}
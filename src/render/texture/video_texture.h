@@ -0,0 +1,99 @@
+#ifndef VIDEO_TEXTURE_H
+#define VIDEO_TEXTURE_H
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Looping video texture from uncompressed YUV frames (.y4m, or headerless .yuv with a given size).
+// A reader thread copies each frame straight into one of three pixel unpack buffers, persistently
+// mapped when the context allows it; update() uploads the due frame from its buffer into Y/U/V
+// textures and fences it, so neither the disk read nor the upload ever waits on the GPU. YUV is
+// converted to RGB while sampling (see shaderSource).
+class VideoTexture
+{
+public:
+    // rawWidth / rawHeight / rawFps describe headerless 4:2:0 .yuv files and are ignored for .y4m
+    explicit VideoTexture(const std::string &path, int rawWidth = 0, int rawHeight = 0, double rawFps = 30.0);
+    ~VideoTexture();
+    VideoTexture(const VideoTexture &) = delete;
+    VideoTexture &operator=(const VideoTexture &) = delete;
+
+    bool valid() const { return lumaTexture != 0; }
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+    double framesPerSecond() const { return fps; }
+
+    // Upload the frame due at `seconds` (any monotonic clock) if it is ready; once per frame on the GL thread
+    void update(double seconds);
+
+    // Bind the Y, U and V planes to units firstUnit .. firstUnit + 2 and set the sampling uniforms of
+    // a program using sampleVideo() (see shaderSource)
+    void bind(GLuint program, GLuint firstUnit) const;
+
+    // GLSL snippet defining "vec4 sampleVideo(vec2 uv)"; paste it into a fragment shader
+    static const char *shaderSource();
+
+    uint64_t presentedFrames() const { return presented; }
+    uint64_t droppedFrames() const { return dropped; }
+
+private:
+    enum class SlotState
+    {
+        Free,     // Reader may fill it
+        Filled,   // Holds frame `frame`, waiting for its presentation time
+        InFlight, // Uploaded, the GPU may still read it until `fence` signals
+    };
+
+    struct Slot
+    {
+        GLuint buffer = 0;
+        uint8_t *mapped = nullptr;     // Persistent mapping, or null
+        std::vector<uint8_t> staging;  // Used instead when buffers cannot stay mapped
+        SlotState state = SlotState::Free;
+        uint64_t frame = 0;
+        GLsync fence = nullptr;
+
+        uint8_t *memory() { return mapped ? mapped : staging.data(); }
+    };
+
+    bool readHeader(std::ifstream &file);
+    bool readFrame(std::ifstream &file, uint8_t *destination);
+    void upload(Slot &slot);
+    void readerLoop();
+
+    std::string path;
+    bool y4m = false;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    int chromaWidth = 0;
+    int chromaHeight = 0;
+    double fps = 30.0;
+    bool fullRange = false;
+    std::streamoff dataStart = 0;
+    size_t frameBytes = 0;
+
+    // GPU side
+    GLuint lumaTexture = 0;
+    GLuint chromaTextures[2] = {}; // U, V
+    double startTime = -1.0;
+    uint64_t presented = 0;
+    uint64_t dropped = 0;
+
+    // Ring shared with the reader thread
+    static const int slotCount = 3;
+    Slot slots[slotCount];
+    int uploadIndex = 0; // Next slot to present, in ring order
+    std::atomic<bool> running{true};
+    std::mutex mutex;
+    std::condition_variable slotFreed;
+    std::thread reader;
+};
+
+#endif /* VIDEO_TEXTURE_H */
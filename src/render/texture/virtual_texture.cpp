@@ -0,0 +1,550 @@
+#include "virtual_texture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+#include <glm/gtc/type_ptr.hpp>
+#include "texture_memory.h"
+#include "../camera/camera_uniforms.h"
+#include "../state/gl_state.h"
+
+// Feedback target is 1/feedbackScale of the viewport; the LOD bias compensates for the coarser derivatives
+static const int feedbackScale = 8;
+static const int maxUploadsPerFrame = 8;
+static const size_t maxPendingTiles = 64;
+
+static const char *vtShaderText =
+    "uniform usampler2D vtPageTable;\n"
+    "uniform sampler2D vtCache;\n"
+    "uniform vec2 vtVirtualSize;\n"
+    "uniform float vtMaxLevel;\n"
+    "uniform vec3 vtTile; // Tile size, border, physical cache size (texels)\n"
+    "vec4 sampleVirtual(vec2 uv)\n"
+    "{\n"
+    "    vec2 texel = uv * vtVirtualSize;\n"
+    "    vec2 dx = dFdx(texel);\n"
+    "    vec2 dy = dFdy(texel);\n"
+    "    float lod = clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy)))), 0.0, vtMaxLevel);\n"
+    "    vec2 wrapped = fract(uv) * vtVirtualSize;\n"
+    "    uvec4 entry = texelFetch(vtPageTable, ivec2(wrapped / (vtTile.x * exp2(lod))), int(lod));\n"
+    "    // The entry is the finest resident tile covering this page, possibly a coarser level\n"
+    "    vec2 inTile = fract(wrapped / (vtTile.x * exp2(float(entry.b))));\n"
+    "    vec2 physical = vec2(entry.rg) * (vtTile.x + 2.0 * vtTile.y) + vtTile.y + inTile * vtTile.x;\n"
+    "    return textureLod(vtCache, physical / vtTile.z, 0.0);\n"
+    "}\n";
+
+// Compiled after "#version 330" and CameraUniforms::shaderSource()
+static const char *feedbackVertexShaderText =
+    "uniform mat4 model;\n"
+    "in vec3 vPos;\n"
+    "in vec2 vTexCoord;\n"
+    "out vec2 texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = viewProjection * (model * vec4(vPos, 1.0));\n"
+    "    texCoord = vec2(vTexCoord.x, 1.0 - vTexCoord.y);\n"
+    "}\n";
+
+// Page coordinates are packed as 12 bits each (r/g low bytes, b high nibbles); a = level + 1, 0 = no request
+static const char *feedbackFragmentShaderText =
+    "#version 330\n"
+    "uniform vec2 vtVirtualSize;\n"
+    "uniform float vtMaxLevel;\n"
+    "uniform float vtTileSize;\n"
+    "uniform float lodBias;\n"
+    "in vec2 texCoord;\n"
+    "out vec4 fragment;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 texel = texCoord * vtVirtualSize;\n"
+    "    vec2 dx = dFdx(texel);\n"
+    "    vec2 dy = dFdy(texel);\n"
+    "    float lod = clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + lodBias), 0.0, vtMaxLevel);\n"
+    "    uvec2 page = uvec2(fract(texCoord) * vtVirtualSize / (vtTileSize * exp2(lod)));\n"
+    "    uint high = ((page.x >> 8u) & 15u) | (((page.y >> 8u) & 15u) << 4u);\n"
+    "    fragment = vec4(float(page.x & 255u), float(page.y & 255u), float(high), lod + 1.0) / 255.0;\n"
+    "}\n";
+
+static uint32_t nextPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+static GLuint compileShader(GLenum type, const char *const *sources, GLsizei count)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, count, sources, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        spdlog::error("Virtual texture feedback shader compilation failed: {}", infoLog);
+    }
+    return shader;
+}
+
+VirtualTexture::VirtualTexture(const std::string &path, GLint positionLocation, GLint texCoordLocation, int cacheTiles,
+                               int workerCount)
+    : path(path), cacheTiles(cacheTiles)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file || !readVirtualTextureHeader(file, header))
+    {
+        spdlog::error("Failed to open virtual texture: {}", path);
+        return;
+    }
+
+    // Page table: power-of-two so GL's halving mip sizes cover every level's page grid
+    pageTableWidth = nextPowerOfTwo(header.tilesX(0));
+    pageTableHeight = nextPowerOfTwo(header.tilesY(0));
+    while (std::max(pageTableWidth, pageTableHeight) < (1u << (header.levelCount - 1)))
+        pageTableWidth <<= 1;
+    pageEntries.resize(header.levelCount);
+
+    glGenTextures(1, &pageTable);
+    glState().bindTexture(GL_TEXTURE_2D, pageTable);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.levelCount - 1);
+    for (uint32_t level = 0; level < header.levelCount; level++)
+    {
+        GLsizei width = std::max(pageTableWidth >> level, 1u);
+        GLsizei height = std::max(pageTableHeight >> level, 1u);
+        pageEntries[level].assign(static_cast<size_t>(width) * height * 4, 0);
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8UI, width, height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, NULL);
+    }
+    trackTextureMemory(pageTable, textureChainBytes(GL_RGBA8UI, static_cast<int>(pageTableWidth),
+                                                    static_cast<int>(pageTableHeight), 0,
+                                                    static_cast<int>(header.levelCount)));
+
+    // Physical cache: the only storage that grows with detail, and it has a fixed size
+    const GLsizei cacheSize = cacheTiles * static_cast<GLsizei>(header.paddedTileSize());
+    glGenTextures(1, &cacheTexture);
+    glState().bindTexture(GL_TEXTURE_2D, cacheTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    trackTextureMemory(cacheTexture, textureLevelBytes(GL_RGBA8, cacheSize, cacheSize));
+    slots.resize(static_cast<size_t>(cacheTiles) * cacheTiles);
+
+    // The single tile of the coarsest level is loaded now and never evicted: every page falls back to it
+    LoadedTile root{tileKey(header.levelCount - 1, 0, 0), {}};
+    if (!readTile(file, root.key, root.pixels))
+    {
+        spdlog::error("Failed to read virtual texture root tile: {}", path);
+        untrackTextureMemory(pageTable);
+        glState().deleteTextures(1, &pageTable);
+        pageTable = 0;
+        return;
+    }
+    uploadTile(root);
+    slots[tileToSlot[root.key]].lastUsed = UINT64_MAX;
+    rebuildPageTable();
+
+    createFeedbackProgram(positionLocation, texCoordLocation);
+    glGenBuffers(readbackCount, readbackBuffers);
+
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&VirtualTexture::workerLoop, this);
+
+    spdlog::info("Virtual texture: {} {}x{} ({} levels, {}px tiles), cache {}x{} tiles ({:.1f} MB)", path,
+                 header.width, header.height, header.levelCount, header.tileSize, cacheTiles, cacheTiles,
+                 static_cast<double>(cacheSize) * cacheSize * 4 / (1024.0 * 1024.0));
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    loadAvailable.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+
+    for (GLsync fence : readbackFences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    glState().deleteBuffers(readbackCount, readbackBuffers);
+    glState().deleteFramebuffers(1, &feedbackFramebuffer);
+    untrackTextureMemory(feedbackColor);
+    untrackTextureMemory(cacheTexture);
+    untrackTextureMemory(pageTable);
+    glState().deleteTextures(1, &feedbackColor);
+    glDeleteRenderbuffers(1, &feedbackDepth);
+    glState().deleteProgram(feedbackProgram);
+    glState().deleteTextures(1, &cacheTexture);
+    glState().deleteTextures(1, &pageTable);
+}
+
+const char *VirtualTexture::shaderSource()
+{
+    return vtShaderText;
+}
+
+bool VirtualTexture::readTile(std::ifstream &file, uint64_t key, std::vector<uint8_t> &pixels) const
+{
+    const uint32_t level = static_cast<uint32_t>(key >> 48);
+    const uint32_t y = static_cast<uint32_t>((key >> 24) & 0xFFFFFF);
+    const uint32_t x = static_cast<uint32_t>(key & 0xFFFFFF);
+    pixels.resize(header.tileBytes());
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(header.tileOffset(level, x, y)));
+    file.read(reinterpret_cast<char *>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    return file.good();
+}
+
+void VirtualTexture::createFeedbackProgram(GLint positionLocation, GLint texCoordLocation)
+{
+    const char *vertexSources[] = {"#version 330\n", CameraUniforms::shaderSource(), feedbackVertexShaderText};
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSources, 3);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, &feedbackFragmentShaderText, 1);
+
+    // Share the scene's vertex arrays: same attribute locations as the caller's program
+    feedbackProgram = glCreateProgram();
+    glAttachShader(feedbackProgram, vertexShader);
+    glAttachShader(feedbackProgram, fragmentShader);
+    glBindAttribLocation(feedbackProgram, positionLocation, "vPos");
+    glBindAttribLocation(feedbackProgram, texCoordLocation, "vTexCoord");
+    glLinkProgram(feedbackProgram);
+
+    GLint success;
+    glGetProgramiv(feedbackProgram, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(feedbackProgram, 512, NULL, infoLog);
+        spdlog::error("Virtual texture feedback program linking failed: {}", infoLog);
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    feedbackModelLocation = glGetUniformLocation(feedbackProgram, "model");
+    CameraUniforms::bindProgram(feedbackProgram);
+}
+
+void VirtualTexture::createFeedbackTarget(int width, int height)
+{
+    if (!feedbackFramebuffer)
+    {
+        glGenFramebuffers(1, &feedbackFramebuffer);
+        glGenTextures(1, &feedbackColor);
+        glGenRenderbuffers(1, &feedbackDepth);
+    }
+    feedbackWidth = width;
+    feedbackHeight = height;
+
+    glState().bindTexture(GL_TEXTURE_2D, feedbackColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    trackTextureMemory(feedbackColor, textureLevelBytes(GL_RGBA8, width, height));
+    glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glState().bindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        spdlog::error("Virtual texture feedback framebuffer is incomplete");
+}
+
+void VirtualTexture::renderFeedback(const glm::mat4 &model, GLuint vertexArray, GLsizei indexCount, GLenum indexType,
+                                    int viewportWidth, int viewportHeight, const std::vector<Occluder> &occluders)
+{
+    if (!valid())
+        return;
+
+    int width = std::max(viewportWidth / feedbackScale, 1);
+    int height = std::max(viewportHeight / feedbackScale, 1);
+    if (width != feedbackWidth || height != feedbackHeight)
+        createFeedbackTarget(width, height);
+
+    glState().bindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+    glState().viewport(0, 0, width, height);
+    const GLfloat noRequest[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const GLfloat farDepth = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, noRequest); // Leaves the scene's clear color alone
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+
+    glState().useProgram(feedbackProgram);
+
+    // Depth-only prepass: the mesh's fragments behind an occluder fail the depth test below
+    if (!occluders.empty())
+    {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        for (const Occluder &occluder : occluders)
+        {
+            glUniformMatrix4fv(feedbackModelLocation, 1, GL_FALSE, glm::value_ptr(occluder.model));
+            glState().bindVertexArray(occluder.vertexArray);
+            glDrawElements(GL_TRIANGLES, occluder.indexCount, occluder.indexType, 0);
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    glUniformMatrix4fv(feedbackModelLocation, 1, GL_FALSE, glm::value_ptr(model));
+    glUniform2f(glGetUniformLocation(feedbackProgram, "vtVirtualSize"), static_cast<float>(header.width),
+                static_cast<float>(header.height));
+    glUniform1f(glGetUniformLocation(feedbackProgram, "vtMaxLevel"), static_cast<float>(header.levelCount - 1));
+    glUniform1f(glGetUniformLocation(feedbackProgram, "vtTileSize"), static_cast<float>(header.tileSize));
+    glUniform1f(glGetUniformLocation(feedbackProgram, "lodBias"), -std::log2(static_cast<float>(feedbackScale)));
+    glState().bindVertexArray(vertexArray);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+
+    // Queue the readback; if the oldest one has not been consumed yet, skip this frame's
+    int index = readbackIndex;
+    if (!readbackFences[index])
+    {
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[index]);
+        if (readbackWidth[index] != width || readbackHeight[index] != height)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, NULL, GL_STREAM_READ);
+            readbackWidth[index] = width;
+            readbackHeight[index] = height;
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readbackFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readbackIndex = (index + 1) % readbackCount;
+    }
+
+    glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState().viewport(0, 0, viewportWidth, viewportHeight);
+}
+
+void VirtualTexture::processFeedback(const uint8_t *pixels, int width, int height)
+{
+    std::unordered_set<uint64_t> seen;
+    std::vector<uint64_t> requests;
+    for (int i = 0; i < width * height; i++)
+    {
+        const uint8_t *texel = pixels + i * 4;
+        if (texel[3] == 0)
+            continue;
+        uint32_t level = std::min<uint32_t>(texel[3] - 1u, header.levelCount - 1);
+        uint32_t x = texel[0] | ((texel[2] & 15u) << 8);
+        uint32_t y = texel[1] | ((texel[2] >> 4) << 8);
+        if (!seen.insert(tileKey(level, x, y)).second)
+            continue;
+
+        // Walk up to the first resident ancestor; everything missing on the way is requested
+        for (; level < header.levelCount; level++, x >>= 1, y >>= 1)
+        {
+            if (x >= header.tilesX(level) || y >= header.tilesY(level))
+                break;
+            uint64_t key = tileKey(level, x, y);
+            auto it = tileToSlot.find(key);
+            if (it != tileToSlot.end())
+            {
+                slots[it->second].lastUsed = std::max(slots[it->second].lastUsed, frame);
+                break;
+            }
+            requests.push_back(key);
+        }
+    }
+
+    // Coarse tiles first: they improve the most pixels per upload
+    std::sort(requests.begin(), requests.end(), [](uint64_t a, uint64_t b)
+              { return (a >> 48) > (b >> 48); });
+    requests.erase(std::unique(requests.begin(), requests.end()), requests.end());
+    for (uint64_t key : requests)
+        requestTile(static_cast<uint32_t>(key >> 48), static_cast<uint32_t>(key & 0xFFFFFF),
+                    static_cast<uint32_t>((key >> 24) & 0xFFFFFF));
+}
+
+void VirtualTexture::requestTile(uint32_t level, uint32_t x, uint32_t y)
+{
+    uint64_t key = tileKey(level, x, y);
+    if (pending.size() >= maxPendingTiles || pending.count(key) || tileToSlot.count(key) || failed.count(key))
+        return;
+    pending.insert(key);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    loads.push_back(key);
+    loadAvailable.notify_one();
+}
+
+int VirtualTexture::allocateSlot()
+{
+    // Free slot, else the least recently used one that was not seen in the latest feedback
+    int victim = -1;
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        if (slots[i].key == ~0ull)
+            return static_cast<int>(i);
+        if (slots[i].lastUsed == UINT64_MAX)
+            continue; // Root tile
+        if (victim < 0 || slots[i].lastUsed < slots[victim].lastUsed)
+            victim = static_cast<int>(i);
+    }
+    if (victim < 0 || slots[victim].lastUsed + readbackCount >= frame)
+        return -1; // Everything resident is in view: the cache is too small for this frame
+    tileToSlot.erase(slots[victim].key);
+    return victim;
+}
+
+void VirtualTexture::uploadTile(LoadedTile &tile)
+{
+    pending.erase(tile.key);
+    if (tile.failed)
+    {
+        failed.insert(tile.key); // Sampling falls back to the coarser level already resident
+        return;
+    }
+    int slot = allocateSlot();
+    if (slot < 0)
+        return;
+    slots[slot] = {tile.key, frame};
+    tileToSlot[tile.key] = slot;
+
+    const GLsizei padded = static_cast<GLsizei>(header.paddedTileSize());
+    glState().bindTexture(GL_TEXTURE_2D, cacheTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % cacheTiles) * padded, (slot / cacheTiles) * padded, padded, padded,
+                    GL_RGBA, GL_UNSIGNED_BYTE, tile.pixels.data());
+    pageTableDirty = true;
+}
+
+void VirtualTexture::rebuildPageTable()
+{
+    // Coarse to fine: a page without its own tile inherits its parent's entry
+    glState().bindTexture(GL_TEXTURE_2D, pageTable);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = static_cast<int>(header.levelCount) - 1; level >= 0; level--)
+    {
+        const uint32_t width = std::max(pageTableWidth >> level, 1u);
+        const uint32_t height = std::max(pageTableHeight >> level, 1u);
+        const uint32_t parentWidth = std::max(pageTableWidth >> (level + 1), 1u);
+        const uint32_t parentHeight = std::max(pageTableHeight >> (level + 1), 1u);
+        const bool top = level == static_cast<int>(header.levelCount) - 1;
+        std::vector<uint8_t> &entries = pageEntries[level];
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t *entry = &entries[(static_cast<size_t>(y) * width + x) * 4];
+                auto it = tileToSlot.find(tileKey(level, x, y));
+                if (it != tileToSlot.end())
+                {
+                    entry[0] = static_cast<uint8_t>(it->second % cacheTiles);
+                    entry[1] = static_cast<uint8_t>(it->second / cacheTiles);
+                    entry[2] = static_cast<uint8_t>(level);
+                    entry[3] = 1;
+                }
+                else if (top)
+                {
+                    std::memcpy(entry, &entries[0], 4); // Root tile
+                }
+                else
+                {
+                    const std::vector<uint8_t> &parent = pageEntries[level + 1];
+                    size_t parentIndex = static_cast<size_t>(std::min(y >> 1, parentHeight - 1)) * parentWidth +
+                                         std::min(x >> 1, parentWidth - 1);
+                    std::memcpy(entry, &parent[parentIndex * 4], 4);
+                }
+            }
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entries.data());
+    }
+    pageTableDirty = false;
+}
+
+void VirtualTexture::update()
+{
+    if (!valid())
+        return;
+    frame++;
+
+    // Oldest readback first; only ones whose fence already signaled, never wait
+    for (int i = 0; i < readbackCount; i++)
+    {
+        int index = (readbackIndex + i) % readbackCount;
+        GLsync fence = readbackFences[index];
+        if (!fence)
+            continue;
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(fence);
+        readbackFences[index] = 0;
+
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[index]);
+        const GLsizeiptr size = static_cast<GLsizeiptr>(readbackWidth[index]) * readbackHeight[index] * 4;
+        if (const void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT))
+        {
+            processFeedback(static_cast<const uint8_t *>(pixels), readbackWidth[index], readbackHeight[index]);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    for (int i = 0; i < maxUploadsPerFrame; i++)
+    {
+        LoadedTile tile;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (loaded.empty())
+                break;
+            tile = std::move(loaded.front());
+            loaded.pop_front();
+        }
+        uploadTile(tile);
+    }
+
+    if (pageTableDirty)
+        rebuildPageTable();
+}
+
+void VirtualTexture::bind(GLuint program, GLuint pageTableUnit, GLuint cacheUnit) const
+{
+    glState().bindTexture(pageTableUnit, GL_TEXTURE_2D, pageTable);
+    glState().bindTexture(cacheUnit, GL_TEXTURE_2D, cacheTexture);
+
+    glUniform1i(glGetUniformLocation(program, "vtPageTable"), pageTableUnit);
+    glUniform1i(glGetUniformLocation(program, "vtCache"), cacheUnit);
+    glUniform2f(glGetUniformLocation(program, "vtVirtualSize"), static_cast<float>(header.width),
+                static_cast<float>(header.height));
+    glUniform1f(glGetUniformLocation(program, "vtMaxLevel"), static_cast<float>(header.levelCount - 1));
+    glUniform3f(glGetUniformLocation(program, "vtTile"), static_cast<float>(header.tileSize),
+                static_cast<float>(header.border), static_cast<float>(cacheTiles * header.paddedTileSize()));
+}
+
+void VirtualTexture::workerLoop()
+{
+    std::ifstream file(path, std::ios::binary);
+    while (true)
+    {
+        uint64_t key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            loadAvailable.wait(lock, [this]
+                               { return !running || !loads.empty(); });
+            if (!running)
+                return;
+            key = loads.front();
+            loads.pop_front();
+        }
+
+        LoadedTile tile{key, {}};
+        if (!readTile(file, key, tile.pixels))
+        {
+            spdlog::error("Failed to read virtual texture tile {:x} from {}", key, path);
+            tile.pixels.clear();
+            tile.failed = true; // Frees its pending entry on the GL thread
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded.push_back(std::move(tile));
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "vt_format.h"
+
+// Tiled virtual texture for surfaces far larger than VRAM. GPU memory is fixed: a physical cache
+// texture holds cacheTiles x cacheTiles resident tiles, and a mipmapped page table (one texel per
+// virtual page) points every page at the finest resident tile covering it. A low-resolution
+// feedback pass writes the pages the camera needs; it is read back through PBOs a few frames later,
+// missing tiles are read from disk on worker threads and uploaded within a per-frame budget.
+class VirtualTexture
+{
+public:
+    // Geometry in front of the textured mesh, drawn into the feedback depth only so the tiles it
+    // hides are not requested: a position-only VAO (Mesh::positionArray) and its transform
+    struct Occluder
+    {
+        glm::mat4 model;
+        GLuint vertexArray;
+        GLsizei indexCount;
+        GLenum indexType;
+    };
+
+    // positionLocation / texCoordLocation: attribute locations of the VAOs passed to renderFeedback()
+    VirtualTexture(const std::string &path, GLint positionLocation, GLint texCoordLocation, int cacheTiles = 16,
+                   int workerCount = 2);
+    ~VirtualTexture();
+    VirtualTexture(const VirtualTexture &) = delete;
+    VirtualTexture &operator=(const VirtualTexture &) = delete;
+
+    bool valid() const { return pageTable != 0; }
+    const VirtualTextureInfo &info() const { return header; }
+
+    // Render the feedback pass for one mesh (a VAO with its element buffer) into the small feedback
+    // target and queue its asynchronous readback; the camera comes from CameraUniforms. Leaves
+    // framebuffer 0 bound with the given viewport.
+    void renderFeedback(const glm::mat4 &model, GLuint vertexArray, GLsizei indexCount, GLenum indexType,
+                        int viewportWidth, int viewportHeight, const std::vector<Occluder> &occluders = {});
+
+    // Consume finished readbacks, queue tile loads and upload loaded tiles; once per frame on the GL thread
+    void update();
+
+    // Bind page table / cache and set the sampling uniforms of a program using sampleVirtual() (see shaderSource)
+    void bind(GLuint program, GLuint pageTableUnit, GLuint cacheUnit) const;
+
+    // GLSL snippet defining "vec4 sampleVirtual(vec2 uv)"; paste it into a fragment shader
+    static const char *shaderSource();
+
+    size_t residentTiles() const { return tileToSlot.size(); }
+    size_t pendingTiles() const { return pending.size(); }
+
+private:
+    struct Slot
+    {
+        uint64_t key = ~0ull; // Tile key, ~0 = free
+        uint64_t lastUsed = 0;
+    };
+
+    struct LoadedTile
+    {
+        uint64_t key;
+        std::vector<uint8_t> pixels;
+        bool failed = false; // The read failed; pixels is empty
+    };
+
+    static uint64_t tileKey(uint32_t level, uint32_t x, uint32_t y)
+    {
+        return (static_cast<uint64_t>(level) << 48) | (static_cast<uint64_t>(y) << 24) | x;
+    }
+
+    bool readTile(std::ifstream &file, uint64_t key, std::vector<uint8_t> &pixels) const;
+    void createFeedbackProgram(GLint positionLocation, GLint texCoordLocation);
+    void createFeedbackTarget(int width, int height);
+    void processFeedback(const uint8_t *pixels, int width, int height);
+    void requestTile(uint32_t level, uint32_t x, uint32_t y);
+    void uploadTile(LoadedTile &tile);
+    int allocateSlot();
+    void rebuildPageTable();
+    void workerLoop();
+
+    std::string path;
+    VirtualTextureInfo header;
+    int cacheTiles;
+    uint64_t frame = 0;
+
+    // GPU side
+    GLuint pageTable = 0;
+    GLuint cacheTexture = 0;
+    GLuint feedbackProgram = 0;
+    GLint feedbackModelLocation = -1;
+    GLuint feedbackFramebuffer = 0;
+    GLuint feedbackColor = 0;
+    GLuint feedbackDepth = 0;
+    int feedbackWidth = 0;
+    int feedbackHeight = 0;
+    static const int readbackCount = 3;
+    GLuint readbackBuffers[readbackCount] = {};
+    GLsync readbackFences[readbackCount] = {};
+    int readbackWidth[readbackCount] = {};
+    int readbackHeight[readbackCount] = {};
+    int readbackIndex = 0;
+
+    // Residency
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, int> tileToSlot;
+    std::unordered_set<uint64_t> pending;
+    std::unordered_set<uint64_t> failed; // Unreadable tiles, never requested again
+    std::vector<std::vector<uint8_t>> pageEntries; // CPU copy of every page table level (RGBA8UI)
+    uint32_t pageTableWidth = 0;
+    uint32_t pageTableHeight = 0;
+    bool pageTableDirty = true;
+
+    // Disk I/O workers
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{true};
+    std::mutex mutex;
+    std::condition_variable loadAvailable;
+    std::deque<uint64_t> loads;
+    std::deque<LoadedTile> loaded;
+};
+
+#endif /* VIRTUAL_TEXTURE_H */
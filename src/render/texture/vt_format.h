@@ -0,0 +1,81 @@
+#ifndef VT_FORMAT_H
+#define VT_FORMAT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+// Baked virtual texture (".vt"): a small header followed by every tile of every level,
+// level 0 first, row-major, top row first. Tiles are raw RGBA8 of (tileSize + 2 * border)^2
+// texels; the border repeats neighbouring texels so bilinear filtering never crosses tiles.
+// All tiles have the same size, so a tile's file offset is computed, not stored.
+
+static const char vtMagic[4] = {'V', 'T', 'E', 'X'};
+static const uint32_t vtVersion = 1;
+static const size_t vtHeaderSize = 4 + 6 * sizeof(uint32_t);
+
+struct VirtualTextureInfo
+{
+    uint32_t width = 0; // Level 0 size in texels
+    uint32_t height = 0;
+    uint32_t tileSize = 128; // Payload texels per tile side
+    uint32_t border = 4;
+    uint32_t levelCount = 0; // Last level fits in a single tile
+
+    uint32_t paddedTileSize() const { return tileSize + 2 * border; }
+    uint64_t tileBytes() const { return static_cast<uint64_t>(paddedTileSize()) * paddedTileSize() * 4; }
+    uint32_t levelWidth(uint32_t level) const { return std::max(width >> level, 1u); }
+    uint32_t levelHeight(uint32_t level) const { return std::max(height >> level, 1u); }
+    uint32_t tilesX(uint32_t level) const { return (levelWidth(level) + tileSize - 1) / tileSize; }
+    uint32_t tilesY(uint32_t level) const { return (levelHeight(level) + tileSize - 1) / tileSize; }
+
+    uint64_t tileIndex(uint32_t level, uint32_t x, uint32_t y) const
+    {
+        uint64_t index = 0;
+        for (uint32_t l = 0; l < level; l++)
+            index += static_cast<uint64_t>(tilesX(l)) * tilesY(l);
+        return index + static_cast<uint64_t>(y) * tilesX(level) + x;
+    }
+
+    uint64_t tileOffset(uint32_t level, uint32_t x, uint32_t y) const
+    {
+        return vtHeaderSize + tileIndex(level, x, y) * tileBytes();
+    }
+};
+
+// Levels needed until the whole image fits in one tile
+inline uint32_t vtLevelCount(uint32_t width, uint32_t height, uint32_t tileSize)
+{
+    uint32_t levels = 1;
+    while (std::max(width >> (levels - 1), height >> (levels - 1)) > tileSize)
+        levels++;
+    return levels;
+}
+
+inline void writeVirtualTextureHeader(std::ostream &out, const VirtualTextureInfo &info)
+{
+    const uint32_t fields[6] = {vtVersion, info.width, info.height, info.tileSize, info.border, info.levelCount};
+    out.write(vtMagic, sizeof(vtMagic));
+    out.write(reinterpret_cast<const char *>(fields), sizeof(fields));
+}
+
+inline bool readVirtualTextureHeader(std::istream &in, VirtualTextureInfo &info)
+{
+    char magic[4];
+    uint32_t fields[6];
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(fields), sizeof(fields));
+    if (!in || std::memcmp(magic, vtMagic, sizeof(magic)) != 0 || fields[0] != vtVersion)
+        return false;
+
+    info.width = fields[1];
+    info.height = fields[2];
+    info.tileSize = fields[3];
+    info.border = fields[4];
+    info.levelCount = fields[5];
+    return info.width > 0 && info.height > 0 && info.tileSize > 0 && info.levelCount > 0 && info.levelCount <= 32;
+}
+
+#endif /* VT_FORMAT_H */
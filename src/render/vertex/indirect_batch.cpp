@@ -0,0 +1,215 @@
+#include "indirect_batch.h"
+
+#include <algorithm>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include "../state/gl_state.h"
+
+// One invocation per object: box against the six planes, survivors append their command
+static const char *cullShaderText =
+    "#version 430\n"
+    "layout(local_size_x = 64) in;\n"
+    "struct DrawCommand { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n"
+    "layout(std430, binding = 1) readonly buffer ObjectBounds { vec4 bounds[]; }; // center, extent\n"
+    "layout(std430, binding = 2) readonly buffer SourceCommands { DrawCommand sourceCommands[]; };\n"
+    "layout(std430, binding = 3) writeonly buffer DrawCommands { DrawCommand drawCommands[]; };\n"
+    "layout(std430, binding = 4) buffer DrawCount { uint drawCount; };\n"
+    "uniform vec4 frustumPlanes[6];\n"
+    "uniform uint objectCount;\n"
+    "void main()\n"
+    "{\n"
+    "    uint object = gl_GlobalInvocationID.x;\n"
+    "    if (object >= objectCount)\n"
+    "        return;\n"
+    "    vec3 center = bounds[object * 2u].xyz;\n"
+    "    vec3 extent = bounds[object * 2u + 1u].xyz;\n"
+    "    for (int i = 0; i < 6; i++)\n"
+    "    {\n"
+    "        vec4 plane = frustumPlanes[i];\n"
+    "        if (dot(plane.xyz, center) + plane.w + dot(abs(plane.xyz), extent) < 0.0)\n"
+    "            return;\n"
+    "    }\n"
+    "    drawCommands[atomicAdd(drawCount, 1u)] = sourceCommands[object];\n"
+    "}\n";
+
+bool IndirectBatch::supported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+IndirectBatch::IndirectBatch(const Mesh &mesh, GLuint program, GLint objectIndexLocation, size_t capacity)
+    : indexType(mesh.indexType), objectCapacity(capacity), drawCountSupported(GLAD_GL_VERSION_4_6 != 0)
+{
+    glGenVertexArrays(1, &vertexArray);
+    setMesh(mesh, program);
+    glState().bindVertexArray(vertexArray);
+
+    // Instanced attributes start at the command's baseInstance, so element i of 0, 1, 2, ... is the
+    // object a command with baseInstance i draws. Portable to 4.3, unlike gl_DrawID / gl_BaseInstance.
+    std::vector<GLuint> objectIndices(capacity);
+    std::iota(objectIndices.begin(), objectIndices.end(), 0u);
+    glGenBuffers(1, &objectIndexBuffer);
+    glState().bindBuffer(GL_ARRAY_BUFFER, objectIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(GLuint)), objectIndices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(objectIndexLocation);
+    glVertexAttribIPointer(objectIndexLocation, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *)0);
+    glVertexAttribDivisor(objectIndexLocation, 1);
+    glState().bindVertexArray(0);
+
+    auto createStorage = [](GLuint &buffer, size_t bytes)
+    {
+        glGenBuffers(1, &buffer);
+        glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_DYNAMIC_DRAW);
+    };
+    createStorage(transformBuffer, capacity * sizeof(glm::mat4));
+    createStorage(boundsBuffer, capacity * 2 * sizeof(glm::vec4));
+    createStorage(sourceCommandBuffer, capacity * sizeof(DrawCommand));
+    createStorage(drawCommandBuffer, capacity * sizeof(DrawCommand));
+    createStorage(drawCountBuffer, sizeof(GLuint));
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &cullShaderText, NULL);
+    glCompileShader(shader);
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        spdlog::error("Indirect culling shader compilation failed: {}", infoLog);
+    }
+    cullProgram = glCreateProgram();
+    glAttachShader(cullProgram, shader);
+    glLinkProgram(cullProgram);
+    glGetProgramiv(cullProgram, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(cullProgram, 512, NULL, infoLog);
+        spdlog::error("Indirect culling program linking failed: {}", infoLog);
+    }
+    glDeleteShader(shader);
+    frustumPlanesLocation = glGetUniformLocation(cullProgram, "frustumPlanes");
+    objectCountLocation = glGetUniformLocation(cullProgram, "objectCount");
+
+    visibleCommands.reserve(capacity);
+}
+
+void IndirectBatch::setMesh(const Mesh &mesh, GLuint program)
+{
+    indexType = mesh.indexType;
+    glState().bindVertexArray(vertexArray);
+    bindVertexFormat(*mesh.format, program, mesh.vertexBuffer);
+    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.elementBuffer);
+    glState().bindVertexArray(0);
+}
+
+IndirectBatch::~IndirectBatch()
+{
+    glState().deleteVertexArrays(1, &vertexArray);
+    GLuint buffers[] = {objectIndexBuffer, transformBuffer, boundsBuffer, sourceCommandBuffer, drawCommandBuffer,
+                        drawCountBuffer};
+    glState().deleteBuffers(6, buffers);
+    glState().deleteProgram(cullProgram);
+}
+
+void IndirectBatch::setObjects(const glm::mat4 *models, const glm::vec3 *centers, const glm::vec3 *extents,
+                               const IndirectMesh *meshes, size_t count)
+{
+    objectCount = std::min(count, objectCapacity);
+    std::vector<glm::vec4> bounds(objectCount * 2);
+    commands.resize(objectCount);
+    for (size_t i = 0; i < objectCount; i++)
+    {
+        bounds[i * 2] = glm::vec4(centers[i], 0.0f);
+        bounds[i * 2 + 1] = glm::vec4(extents[i], 0.0f);
+        commands[i] = {meshes[i].indexCount, 1, meshes[i].firstIndex, meshes[i].baseVertex, static_cast<GLuint>(i)};
+    }
+
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, transformBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(objectCount * sizeof(glm::mat4)), models);
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(bounds.size() * sizeof(glm::vec4)), bounds.data());
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, sourceCommandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(objectCount * sizeof(DrawCommand)), commands.data());
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    drawCount = 0;
+    countOnGpu = false;
+}
+
+void IndirectBatch::setObjectMeshes(const IndirectMesh *meshes, size_t count)
+{
+    count = std::min(count, objectCount);
+    for (size_t i = 0; i < count; i++)
+        commands[i] = {meshes[i].indexCount, 1, meshes[i].firstIndex, meshes[i].baseVertex, static_cast<GLuint>(i)};
+
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, sourceCommandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(DrawCommand)), commands.data());
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void IndirectBatch::setVisible(const uint32_t *objects, size_t count)
+{
+    visibleCommands.clear();
+    for (size_t i = 0; i < count; i++)
+        if (objects[i] < objectCount)
+            visibleCommands.push_back(commands[objects[i]]);
+    drawCount = visibleCommands.size();
+    countOnGpu = false;
+
+    // Orphan first so a frame still reading the old commands never stalls the upload
+    glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(objectCapacity * sizeof(DrawCommand)), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, static_cast<GLsizeiptr>(drawCount * sizeof(DrawCommand)), visibleCommands.data());
+}
+
+void IndirectBatch::cull(const Frustum &frustum)
+{
+    countOnGpu = true;
+    if (objectCount == 0)
+        return;
+
+    // Without an indirect count the whole list is submitted, so the tail past the visible commands
+    // has to be empty (count 0) draws
+    const GLuint zero = 0;
+    glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, drawCountBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    if (!drawCountSupported)
+    {
+        glState().bindBuffer(GL_SHADER_STORAGE_BUFFER, drawCommandBuffer);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+
+    glState().useProgram(cullProgram);
+    glUniform4fv(frustumPlanesLocation, 6, &frustum.planes[0].x);
+    glUniform1ui(objectCountLocation, static_cast<GLuint>(objectCount));
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, boundsBuffer);
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sourceCommandBuffer);
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, drawCommandBuffer);
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, drawCountBuffer);
+    glDispatchCompute(static_cast<GLuint>((objectCount + 63) / 64), 1, 1);
+
+    // The draw reads the commands (and count) as indirect arguments, not through storage buffers
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void IndirectBatch::draw() const
+{
+    if (objectCount == 0 || (!countOnGpu && drawCount == 0))
+        return;
+
+    glState().bindVertexArray(vertexArray);
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, transformBuffer);
+    glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer);
+    if (!countOnGpu)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, 0, static_cast<GLsizei>(drawCount), 0);
+    else if (drawCountSupported)
+    {
+        glState().bindBuffer(GL_PARAMETER_BUFFER, drawCountBuffer);
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, indexType, 0, 0, static_cast<GLsizei>(objectCount), 0);
+    }
+    else
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, 0, static_cast<GLsizei>(objectCount), 0);
+}
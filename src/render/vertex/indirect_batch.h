@@ -0,0 +1,96 @@
+#ifndef INDIRECT_BATCH_H
+#define INDIRECT_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mesh.h"
+#include "../culling/frustum_culling.h"
+
+// Index range of one object's mesh in the shared element buffer
+struct IndirectMesh
+{
+    GLuint indexCount = 0;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+};
+
+// GPU-driven drawing: one DrawElementsIndirectCommand per object in a GL_DRAW_INDIRECT_BUFFER and a
+// single glMultiDrawElementsIndirect for all of them, so submission cost no longer grows with the
+// object count. Model matrices sit in a shader storage buffer (binding 0) indexed by `objectIndex`, a
+// per-instance attribute that each command's baseInstance points at its own object.
+//
+// The command list comes either from the CPU (setVisible, e.g. after BVH culling) or from cull(), a
+// compute pass that tests every object's box against the frustum and compacts the visible commands
+// on the GPU. Needs GL 4.3.
+class IndirectBatch
+{
+public:
+    static bool supported();
+
+    // Draws from mesh's buffers with attributes bound for program; objectIndexLocation is the
+    // shader's uint objectIndex. Object meshes are index ranges of it.
+    IndirectBatch(const Mesh &mesh, GLuint program, GLint objectIndexLocation, size_t capacity);
+    ~IndirectBatch();
+    IndirectBatch(const IndirectBatch &) = delete;
+    IndirectBatch &operator=(const IndirectBatch &) = delete;
+
+    // Draw from another mesh's buffers (it must outlive its use here); the objects' index ranges
+    // refer to the old one until setObjects() or setObjectMeshes() is called
+    void setMesh(const Mesh &mesh, GLuint program);
+
+    // Object i: model matrix, world box and mesh; replaces all objects (count is clamped to the capacity)
+    void setObjects(const glm::mat4 *models, const glm::vec3 *centers, const glm::vec3 *extents,
+                    const IndirectMesh *meshes, size_t count);
+
+    // Replace only the meshes of objects 0 .. count - 1, keeping their transforms and boxes
+    void setObjectMeshes(const IndirectMesh *meshes, size_t count);
+
+    // Draw only these objects: their commands are written from the CPU copy
+    void setVisible(const uint32_t *objects, size_t count);
+
+    // Draw the objects inside the frustum, selected and compacted by a compute pass. Binds the culling
+    // program, so call it before the draw program is bound.
+    void cull(const Frustum &frustum);
+
+    // Every command of the last setVisible() or cull() in one multi-draw
+    void draw() const;
+
+    size_t count() const { return objectCount; }
+    size_t capacity() const { return objectCapacity; }
+
+private:
+    // Layout fixed by GL; also the std430 layout of the culling shader's command arrays
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    GLuint vertexArray = 0;
+    GLenum indexType;
+    GLuint objectIndexBuffer = 0; // 0 .. capacity - 1, read at baseInstance
+    GLuint transformBuffer = 0;   // mat4 per object
+    GLuint boundsBuffer = 0;      // vec4 center, vec4 extent per object
+    GLuint sourceCommandBuffer = 0;
+    GLuint drawCommandBuffer = 0;
+    GLuint drawCountBuffer = 0; // Visible count written by cull()
+    GLuint cullProgram = 0;
+    GLint frustumPlanesLocation = -1;
+    GLint objectCountLocation = -1;
+
+    std::vector<DrawCommand> commands; // By object
+    std::vector<DrawCommand> visibleCommands;
+    size_t objectCapacity;
+    size_t objectCount = 0;
+    size_t drawCount = 0;        // Commands to submit when the CPU wrote them
+    bool countOnGpu = false;     // cull() ran: the count lives in drawCountBuffer
+    bool drawCountSupported;     // glMultiDrawElementsIndirectCount (GL 4.6)
+};
+
+#endif /* INDIRECT_BATCH_H */
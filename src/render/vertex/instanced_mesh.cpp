@@ -0,0 +1,76 @@
+#include "instanced_mesh.h"
+
+#include <algorithm>
+#include "../state/gl_state.h"
+
+InstancedMesh::InstancedMesh(const Mesh &mesh, GLuint program, GLint modelLocation, size_t capacity)
+    : indexCount(mesh.indexCount), indexType(mesh.indexType), instanceCapacity(capacity)
+{
+    glGenVertexArrays(1, &vertexArray);
+    setMesh(mesh, program);
+    glState().bindVertexArray(vertexArray);
+
+    // A mat4 attribute takes four consecutive locations, one column each, advancing once per instance
+    glGenBuffers(1, &instanceBuffer);
+    glState().bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(glm::mat4)), nullptr, GL_STREAM_DRAW);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        GLuint location = static_cast<GLuint>(modelLocation) + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void *)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glState().bindVertexArray(0);
+}
+
+void InstancedMesh::setMesh(const Mesh &mesh, GLuint program)
+{
+    indexCount = mesh.indexCount;
+    indexType = mesh.indexType;
+    glState().bindVertexArray(vertexArray);
+    bindVertexFormat(*mesh.format, program, mesh.vertexBuffer);
+    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.elementBuffer);
+    glState().bindVertexArray(0);
+}
+
+InstancedMesh::~InstancedMesh()
+{
+    glState().deleteVertexArrays(1, &vertexArray);
+    glState().deleteBuffers(1, &instanceBuffer);
+}
+
+void InstancedMesh::upload(const glm::mat4 *models, size_t count)
+{
+    begin(count);
+    write(0, models, count);
+}
+
+void InstancedMesh::begin(size_t count)
+{
+    instanceCount = std::min(count, instanceCapacity);
+    glState().bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instanceCapacity * sizeof(glm::mat4)), nullptr, GL_STREAM_DRAW);
+}
+
+void InstancedMesh::write(size_t first, const glm::mat4 *models, size_t count)
+{
+    if (first >= instanceCapacity)
+        return;
+    count = std::min(count, instanceCapacity - first);
+    if (count == 0)
+        return;
+    glState().bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first * sizeof(glm::mat4)),
+                    static_cast<GLsizeiptr>(count * sizeof(glm::mat4)), models);
+}
+
+void InstancedMesh::draw() const
+{
+    if (instanceCount == 0)
+        return;
+    glState().bindVertexArray(vertexArray);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, static_cast<GLsizei>(instanceCount));
+}
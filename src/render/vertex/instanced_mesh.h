@@ -0,0 +1,47 @@
+#ifndef INSTANCED_MESH_H
+#define INSTANCED_MESH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include "mesh.h"
+
+// Draws one indexed mesh many times with a single glDrawElementsInstanced. Per-instance model
+// matrices live in their own buffer, fed to a mat4 vertex attribute with divisor 1; the mesh's
+// vertex and index buffers are shared with the mesh's own VAO.
+class InstancedMesh
+{
+public:
+    // Vertex attributes are bound for program; modelLocation is the first of the mat4's four locations
+    InstancedMesh(const Mesh &mesh, GLuint program, GLint modelLocation, size_t capacity);
+    ~InstancedMesh();
+    InstancedMesh(const InstancedMesh &) = delete;
+    InstancedMesh &operator=(const InstancedMesh &) = delete;
+
+    // Draw another mesh with the same instances; it must outlive its use here
+    void setMesh(const Mesh &mesh, GLuint program);
+
+    // Replace the instance transforms (count is clamped to the capacity); the old buffer storage is
+    // orphaned so frames still drawing from it never stall the upload
+    void upload(const glm::mat4 *models, size_t count);
+
+    // upload() in pieces: begin() orphans the storage and sets the count, write() fills instances
+    // [first, first + count) of it (clamped to the capacity)
+    void begin(size_t count);
+    void write(size_t first, const glm::mat4 *models, size_t count);
+
+    void draw() const;
+
+    size_t count() const { return instanceCount; }
+    size_t capacity() const { return instanceCapacity; }
+
+private:
+    GLuint vertexArray = 0;
+    GLuint instanceBuffer = 0;
+    GLsizei indexCount;
+    GLenum indexType;
+    size_t instanceCapacity;
+    size_t instanceCount = 0;
+};
+
+#endif /* INSTANCED_MESH_H */
@@ -0,0 +1,72 @@
+#include "mesh.h"
+
+#include "../state/gl_state.h"
+
+GLenum smallestIndexType(size_t vertexCount)
+{
+    return vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+Mesh uploadMesh(const VertexFormat &format, const void *vertices, size_t vertexCount, const void *indices,
+                GLenum indexType, size_t indexCount, GLuint program)
+{
+    Mesh mesh;
+    mesh.format = &format;
+    mesh.vertexCount = vertexCount;
+    mesh.indexCount = static_cast<GLsizei>(indexCount);
+    mesh.indexType = indexType;
+
+    glGenBuffers(1, &mesh.vertexBuffer);
+    glState().bindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexCount * format.stride), vertices, GL_STATIC_DRAW);
+
+    // The element buffer binding is VAO state, so bind a VAO before creating it
+    glGenVertexArrays(1, &mesh.vertexArray);
+    glState().bindVertexArray(mesh.vertexArray);
+    glGenBuffers(1, &mesh.elementBuffer);
+    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.elementBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexCount * indexTypeSize(indexType)), indices,
+                 GL_STATIC_DRAW);
+    bindVertexFormat(format, program, mesh.vertexBuffer);
+    glState().bindVertexArray(0);
+    return mesh;
+}
+
+Mesh createMesh(const VertexFormat &format, const void *vertices, size_t vertexCount, const uint32_t *indices,
+                size_t indexCount, GLuint program, const PositionVertex *positions)
+{
+    const GLenum indexType = smallestIndexType(vertexCount);
+    std::vector<uint16_t> narrow;
+    if (indexType == GL_UNSIGNED_SHORT)
+        narrow.assign(indices, indices + indexCount);
+    Mesh mesh = uploadMesh(format, vertices, vertexCount,
+                           indexType == GL_UNSIGNED_SHORT ? static_cast<const void *>(narrow.data()) : indices,
+                           indexType, indexCount, program);
+
+    if (positions)
+    {
+        glGenBuffers(1, &mesh.positionBuffer);
+        glState().bindBuffer(GL_ARRAY_BUFFER, mesh.positionBuffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexCount * sizeof(PositionVertex)), positions,
+                     GL_STATIC_DRAW);
+        glGenVertexArrays(1, &mesh.positionArray);
+        glState().bindVertexArray(mesh.positionArray);
+        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.elementBuffer);
+        bindVertexFormat(vertexFormat<PositionVertex>(), program, mesh.positionBuffer);
+        glState().bindVertexArray(0);
+    }
+    return mesh;
+}
+
+void destroyMesh(Mesh &mesh)
+{
+    glState().deleteVertexArrays(1, &mesh.vertexArray);
+    glState().deleteBuffers(1, &mesh.vertexBuffer);
+    glState().deleteBuffers(1, &mesh.elementBuffer);
+    if (mesh.positionArray)
+    {
+        glState().deleteVertexArrays(1, &mesh.positionArray);
+        glState().deleteBuffers(1, &mesh.positionBuffer);
+    }
+    mesh = Mesh();
+}
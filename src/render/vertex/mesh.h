@@ -0,0 +1,64 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vertex.h"
+
+// A static indexed mesh on the GPU: vertex and element buffers plus a VAO binding them for one
+// program. The optional position stream is a second, position-only copy of the vertices with its
+// own VAO over the same element buffer, for passes that read nothing else.
+struct Mesh
+{
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+    GLuint elementBuffer = 0;
+    const VertexFormat *format = nullptr; // Of vertexBuffer
+    GLenum indexType = GL_UNSIGNED_INT;
+    GLsizei indexCount = 0;
+    size_t vertexCount = 0;
+
+    GLuint positionArray = 0; // 0 without a position stream
+    GLuint positionBuffer = 0;
+};
+
+// Bytes per index of a GL index type
+inline size_t indexTypeSize(GLenum type)
+{
+    return type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+}
+
+// The smallest index type addressing vertexCount vertices. Never GL_UNSIGNED_BYTE: many GPUs have
+// no 8-bit index fetch and the driver converts such buffers behind our back.
+GLenum smallestIndexType(size_t vertexCount);
+
+// Create a mesh from vertices already in `format`; positions, if not null, are vertexCount
+// PositionVertex for the position stream. Indices are narrowed to smallestIndexType(vertexCount).
+Mesh createMesh(const VertexFormat &format, const void *vertices, size_t vertexCount, const uint32_t *indices,
+                size_t indexCount, GLuint program, const PositionVertex *positions = nullptr);
+
+// Create a mesh from vertices in `format` and indices already stored as indexType, e.g. straight
+// from a mapped cache file
+Mesh uploadMesh(const VertexFormat &format, const void *vertices, size_t vertexCount, const void *indices,
+                GLenum indexType, size_t indexCount, GLuint program);
+
+void destroyMesh(Mesh &mesh);
+
+// Create a mesh in GPU format V from authoring-format vertices
+template <typename V>
+Mesh buildMesh(const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount, GLuint program,
+               bool positionStream = false)
+{
+    std::vector<V> converted(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+        convertVertex(vertices[i], converted[i]);
+    std::vector<PositionVertex> positions(positionStream ? vertexCount : 0);
+    for (size_t i = 0; i < positions.size(); i++)
+        convertVertex(vertices[i], positions[i]);
+    return createMesh(vertexFormat<V>(), converted.data(), vertexCount, indices, indexCount, program,
+                      positionStream ? positions.data() : nullptr);
+}
+
+#endif /* MESH_H */
@@ -2,11 +2,91 @@
 #define VERTEX_H
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "vertex_layout.h"
 
+// Authoring format: what meshes are written in and what the CPU (collision) reads
 struct Vertex {
     float pos[3];
     float col[3];
     float texCoord[2];  // Added texture coordinates
 };
 
+// GPU format, 16 bytes instead of 32: half-float position and texture coordinates (which keeps
+// tiling and negative coordinates) and a normalized 8-bit color
+struct PackedVertex
+{
+    Half pos[4];      // w unused, keeps col 4-byte aligned
+    uint8_t col[4];   // a unused
+    Half texCoord[2];
+};
+
+// Position only, for passes that need nothing else (depth-only occluders): 8 bytes per vertex
+struct PositionVertex
+{
+    Half pos[4]; // w unused
+};
+
+template <typename T>
+inline T normalizeUnsigned(float value)
+{
+    const float maximum = static_cast<float>(std::numeric_limits<T>::max());
+    return static_cast<T>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * maximum));
+}
+
+// Conversions from the authoring format, one per GPU format
+inline void convertVertex(const Vertex &in, Vertex &out)
+{
+    out = in;
+}
+
+inline void convertVertex(const Vertex &in, PackedVertex &out)
+{
+    out = PackedVertex{};
+    for (int i = 0; i < 3; i++)
+    {
+        out.pos[i] = Half(in.pos[i]);
+        out.col[i] = normalizeUnsigned<uint8_t>(in.col[i]);
+    }
+    out.col[3] = 255;
+    for (int i = 0; i < 2; i++)
+        out.texCoord[i] = Half(in.texCoord[i]);
+}
+
+inline void convertVertex(const Vertex &in, PositionVertex &out)
+{
+    out = PositionVertex{};
+    for (int i = 0; i < 3; i++)
+        out.pos[i] = Half(in.pos[i]);
+}
+
+template <>
+inline const VertexFormat &vertexFormat<Vertex>()
+{
+    static const VertexFormat format{sizeof(Vertex),
+                                     {vertexAttribute("vPos", &Vertex::pos),
+                                      vertexAttribute("vCol", &Vertex::col),
+                                      vertexAttribute("vTexCoord", &Vertex::texCoord)}};
+    return format;
+}
+
+template <>
+inline const VertexFormat &vertexFormat<PackedVertex>()
+{
+    static const VertexFormat format{sizeof(PackedVertex),
+                                     {vertexAttribute("vPos", &PackedVertex::pos),
+                                      vertexAttribute("vCol", &PackedVertex::col, true),
+                                      vertexAttribute("vTexCoord", &PackedVertex::texCoord)}};
+    return format;
+}
+
+template <>
+inline const VertexFormat &vertexFormat<PositionVertex>()
+{
+    static const VertexFormat format{sizeof(PositionVertex), {vertexAttribute("vPos", &PositionVertex::pos)}};
+    return format;
+}
+
 #endif /* VERTEX_H */
@@ -0,0 +1,17 @@
+#include "vertex_layout.h"
+
+#include "../state/gl_state.h"
+
+void bindVertexFormat(const VertexFormat &format, GLuint program, GLuint buffer, size_t offset)
+{
+    glState().bindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (const VertexAttribute &attribute : format.attributes)
+    {
+        GLint location = glGetAttribLocation(program, attribute.name);
+        if (location < 0)
+            continue;
+        glEnableVertexAttribArray(static_cast<GLuint>(location));
+        glVertexAttribPointer(static_cast<GLuint>(location), attribute.components, attribute.type, attribute.normalized,
+                              format.stride, reinterpret_cast<const void *>(offset + attribute.offset));
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 16-bit float as stored in vertex buffers (GL_HALF_FLOAT)
+struct Half
+{
+    uint16_t bits = 0;
+
+    Half() = default;
+    explicit Half(float value) : bits(glm::packHalf1x16(value)) {}
+};
+
+// GL component type of each type a vertex member may be an array of
+template <typename T>
+struct ComponentType;
+template <>
+struct ComponentType<float> { static const GLenum value = GL_FLOAT; };
+template <>
+struct ComponentType<Half> { static const GLenum value = GL_HALF_FLOAT; };
+template <>
+struct ComponentType<int8_t> { static const GLenum value = GL_BYTE; };
+template <>
+struct ComponentType<uint8_t> { static const GLenum value = GL_UNSIGNED_BYTE; };
+template <>
+struct ComponentType<int16_t> { static const GLenum value = GL_SHORT; };
+template <>
+struct ComponentType<uint16_t> { static const GLenum value = GL_UNSIGNED_SHORT; };
+
+// One shader input read from a vertex member
+struct VertexAttribute
+{
+    const char *name; // Shader input
+    GLint components;
+    GLenum type;
+    GLboolean normalized; // Integers map to [0, 1] (unsigned) or [-1, 1] (signed)
+    size_t offset;
+};
+
+// Everything glVertexAttribPointer needs to read one vertex struct
+struct VertexFormat
+{
+    GLsizei stride;
+    std::vector<VertexAttribute> attributes;
+};
+
+// Attribute for array member `member` of V (e.g. &Vertex::pos), with its component type and count
+// taken from the member's type
+template <typename V, typename Component, size_t Count>
+VertexAttribute vertexAttribute(const char *name, Component (V::*member)[Count], bool normalized = false)
+{
+    static const V probe{};
+    const size_t offset = reinterpret_cast<const unsigned char *>(&(probe.*member)) -
+                          reinterpret_cast<const unsigned char *>(&probe);
+    return {name, static_cast<GLint>(Count), ComponentType<Component>::value,
+            static_cast<GLboolean>(normalized ? GL_TRUE : GL_FALSE), offset};
+}
+
+// The format of vertex type V; specialized next to each vertex struct
+template <typename V>
+const VertexFormat &vertexFormat();
+
+// Point the bound VAO's attributes at `buffer`, which holds vertices in `format` starting at byte
+// `offset`. Each attribute goes to the location of its input in `program`; inputs the program does
+// not have (or optimized out) are skipped.
+void bindVertexFormat(const VertexFormat &format, GLuint program, GLuint buffer, size_t offset = 0);
+
+#endif /* VERTEX_LAYOUT_H */
@@ -0,0 +1,569 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <numeric>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+const uint32_t maxLeafSize = 4;    // Always split above this...
+const uint32_t maxSahLeafSize = 16; // ...unless the SAH says a leaf is cheaper, up to this
+const int binCount = 12;
+const int maxSahDepth = 64; // Deeper nodes split at the median, so a query stack never overflows
+const int stackSize = 128;
+const double rebuildAreaGrowth = 1.2; // Rebuild once refits grow the summed node area by this factor
+
+struct Bounds
+{
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    void grow(const glm::vec3 &lower, const glm::vec3 &upper)
+    {
+        min = glm::min(min, lower);
+        max = glm::max(max, upper);
+    }
+
+    float area() const
+    {
+        glm::vec3 size = max - min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+};
+
+struct Bin
+{
+    Bounds bounds;
+    uint32_t count = 0;
+};
+
+bool rayBox(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &min, const glm::vec3 &max,
+            float maxDistance, float &entry)
+{
+    glm::vec3 t0 = (min - origin) * inverseDirection;
+    glm::vec3 t1 = (max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+    entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return entry <= exit;
+}
+
+bool boxesOverlap(const glm::vec3 &minA, const glm::vec3 &maxA, const glm::vec3 &minB, const glm::vec3 &maxB)
+{
+    return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y &&
+           minA.z <= maxB.z && maxA.z >= minB.z;
+}
+} // namespace
+
+Bvh::~Bvh()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobAvailable.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void Bvh::build(const BoxArrays &boxes)
+{
+    const size_t count = boxes.size();
+    std::vector<glm::vec3> centers(count), extents(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        centers[i] = glm::vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        extents[i] = glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    buildTree(centers, extents, tree);
+    spdlog::info("BVH built: {} objects, {} nodes, {:.1f} ms", count, tree.nodes.size(),
+                 std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    sequence++; // Drops any rebuild still in flight
+    rebuildInFlight = false;
+    builtNodeArea = tree.nodeArea;
+    moved.clear();
+    movedFlag.assign(count, 0);
+}
+
+void Bvh::update(uint32_t object, const glm::vec3 &center, const glm::vec3 &extent)
+{
+    if (object >= tree.slots.size())
+        return;
+
+    const uint32_t slot = tree.slots[object];
+    tree.centers[slot] = center;
+    tree.extents[slot] = extent;
+    if (rebuildInFlight && !movedFlag[object])
+    {
+        movedFlag[object] = 1;
+        moved.push_back(object);
+    }
+
+    // The leaf from its objects, then each parent from its two children until one doesn't change
+    uint32_t index = tree.leaves[object];
+    Bounds bounds;
+    const Node &leaf = tree.nodes[index];
+    for (uint32_t i = leaf.first; i < leaf.first + leaf.count; i++)
+        bounds.grow(tree.centers[i] - tree.extents[i], tree.centers[i] + tree.extents[i]);
+    while (true)
+    {
+        Node &node = tree.nodes[index];
+        if (node.min == bounds.min && node.max == bounds.max)
+            break;
+        tree.nodeArea += static_cast<double>(bounds.area()) - Bounds{node.min, node.max}.area();
+        node.min = bounds.min;
+        node.max = bounds.max;
+        if (node.parent == UINT32_MAX)
+            break;
+
+        index = node.parent;
+        const Node &left = tree.nodes[tree.nodes[index].left];
+        const Node &right = tree.nodes[tree.nodes[index].left + 1];
+        bounds.min = glm::min(left.min, right.min);
+        bounds.max = glm::max(left.max, right.max);
+    }
+}
+
+void Bvh::maintain()
+{
+    if (rebuildInFlight)
+    {
+        uint32_t finishedSequence;
+        double milliseconds;
+        Tree finished;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!resultReady)
+                return;
+            resultReady = false;
+            finished = std::move(result);
+            finishedSequence = resultSequence;
+            milliseconds = resultMilliseconds;
+        }
+        if (finishedSequence != sequence)
+            return; // Built from an older snapshot; the current one is still coming
+        rebuildInFlight = false;
+
+        // The snapshot is stale for whatever moved since: carry those boxes over from the old tree
+        Tree previous = std::move(tree);
+        tree = std::move(finished);
+        builtNodeArea = tree.nodeArea;
+        for (uint32_t object : moved)
+        {
+            const uint32_t slot = previous.slots[object];
+            update(object, previous.centers[slot], previous.extents[slot]);
+            movedFlag[object] = 0;
+        }
+        spdlog::debug("BVH rebuilt in the background: {} nodes, {:.1f} ms, {} objects refitted after the snapshot",
+                      tree.nodes.size(), milliseconds, moved.size());
+        moved.clear();
+        return;
+    }
+
+    // Worth rebuilding once the refits have made queries noticeably more expensive. A single leaf has
+    // nothing to reorganize; one dragged cube barely moves the sum of a large tree.
+    if (tree.nodes.size() <= 1 || tree.nodeArea <= builtNodeArea * rebuildAreaGrowth)
+        return;
+
+    Job next;
+    next.sequence = ++sequence;
+    next.centers.resize(tree.objects.size());
+    next.extents.resize(tree.objects.size());
+    for (size_t slot = 0; slot < tree.objects.size(); slot++)
+    {
+        next.centers[tree.objects[slot]] = tree.centers[slot];
+        next.extents[tree.objects[slot]] = tree.extents[slot];
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = std::move(next);
+        jobPending = true;
+    }
+    jobAvailable.notify_one();
+    if (!worker.joinable())
+        worker = std::thread(&Bvh::workerLoop, this);
+    rebuildInFlight = true;
+}
+
+void Bvh::workerLoop()
+{
+    while (true)
+    {
+        Job current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]
+                              { return !running || jobPending; });
+            if (!running)
+                return;
+            current = std::move(job);
+            jobPending = false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Tree built;
+        buildTree(current.centers, current.extents, built);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        result = std::move(built);
+        resultSequence = current.sequence;
+        resultMilliseconds = milliseconds;
+        resultReady = true;
+    }
+}
+
+void Bvh::buildTree(const std::vector<glm::vec3> &centers, const std::vector<glm::vec3> &extents, Tree &tree)
+{
+    const uint32_t count = static_cast<uint32_t>(centers.size());
+    tree.nodes.clear();
+    tree.nodeArea = 0.0;
+    tree.objects.resize(count);
+    std::iota(tree.objects.begin(), tree.objects.end(), 0u);
+    if (count == 0)
+    {
+        tree.slots.clear();
+        tree.leaves.clear();
+        tree.centers.clear();
+        tree.extents.clear();
+        return;
+    }
+
+    struct Task
+    {
+        uint32_t node;
+        int depth;
+    };
+    std::vector<Task> tasks;
+    tree.nodes.reserve(2 * count / maxLeafSize + 1);
+    tree.nodes.push_back({glm::vec3(0.0f), 0, glm::vec3(0.0f), count, 0, UINT32_MAX});
+    tasks.push_back({0, 0});
+    uint32_t *objects = tree.objects.data();
+
+    while (!tasks.empty())
+    {
+        const Task task = tasks.back();
+        tasks.pop_back();
+        const uint32_t first = tree.nodes[task.node].first;
+        const uint32_t n = tree.nodes[task.node].count;
+
+        Bounds bounds, centroids;
+        for (uint32_t i = first; i < first + n; i++)
+        {
+            const uint32_t object = objects[i];
+            bounds.grow(centers[object] - extents[object], centers[object] + extents[object]);
+            centroids.grow(centers[object], centers[object]);
+        }
+        tree.nodes[task.node].min = bounds.min;
+        tree.nodes[task.node].max = bounds.max;
+        if (n <= maxLeafSize)
+            continue;
+
+        // Binned SAH: the cheapest of binCount - 1 candidate planes on each axis
+        const glm::vec3 span = centroids.max - centroids.min;
+        int bestAxis = -1, bestBin = 0;
+        float bestCost = FLT_MAX;
+        for (int axis = 0; axis < 3 && task.depth < maxSahDepth; axis++)
+        {
+            if (span[axis] <= 0.0f)
+                continue;
+            const float scale = binCount / span[axis];
+            const float origin = centroids.min[axis];
+            Bin bins[binCount];
+            for (uint32_t i = first; i < first + n; i++)
+            {
+                const uint32_t object = objects[i];
+                const int b = std::min(static_cast<int>((centers[object][axis] - origin) * scale), binCount - 1);
+                bins[b].count++;
+                bins[b].bounds.grow(centers[object] - extents[object], centers[object] + extents[object]);
+            }
+
+            float rightArea[binCount - 1];
+            uint32_t rightCount[binCount - 1];
+            Bounds right;
+            uint32_t binned = 0;
+            for (int b = binCount - 1; b > 0; b--)
+            {
+                right.grow(bins[b].bounds.min, bins[b].bounds.max);
+                binned += bins[b].count;
+                rightArea[b - 1] = binned ? right.area() : 0.0f;
+                rightCount[b - 1] = binned;
+            }
+            Bounds left;
+            binned = 0;
+            for (int b = 0; b < binCount - 1; b++)
+            {
+                left.grow(bins[b].bounds.min, bins[b].bounds.max);
+                binned += bins[b].count;
+                if (binned == 0 || rightCount[b] == 0)
+                    continue;
+                const float cost = binned * left.area() + rightCount[b] * rightArea[b];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        // Leaf cost n against one traversal step plus the children weighted by their relative area
+        const float area = bounds.area();
+        if (bestAxis >= 0 && n <= maxSahLeafSize && area > 0.0f && 1.0f + bestCost / area >= n)
+            continue;
+
+        uint32_t middle;
+        if (bestAxis >= 0)
+        {
+            const float scale = binCount / span[bestAxis];
+            const float origin = centroids.min[bestAxis];
+            middle = static_cast<uint32_t>(
+                std::partition(objects + first, objects + first + n, [&](uint32_t object)
+                               { return std::min(static_cast<int>((centers[object][bestAxis] - origin) * scale), binCount - 1) <= bestBin; }) -
+                objects);
+        }
+        else
+        {
+            // Too deep or all centroids on one spot: halve by count along the longest axis
+            const int axis = span.x >= span.y && span.x >= span.z ? 0 : (span.y >= span.z ? 1 : 2);
+            middle = first + n / 2;
+            std::nth_element(objects + first, objects + middle, objects + first + n, [&](uint32_t a, uint32_t b)
+                             { return centers[a][axis] < centers[b][axis]; });
+        }
+
+        const uint32_t left = static_cast<uint32_t>(tree.nodes.size());
+        tree.nodes[task.node].left = left;
+        tree.nodes.push_back({glm::vec3(0.0f), first, glm::vec3(0.0f), middle - first, 0, task.node});
+        tree.nodes.push_back({glm::vec3(0.0f), middle, glm::vec3(0.0f), first + n - middle, 0, task.node});
+        tasks.push_back({left, task.depth + 1});
+        tasks.push_back({left + 1, task.depth + 1});
+    }
+
+    tree.slots.resize(count);
+    tree.leaves.resize(count);
+    tree.centers.resize(count);
+    tree.extents.resize(count);
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        tree.slots[objects[slot]] = slot;
+        tree.centers[slot] = centers[objects[slot]];
+        tree.extents[slot] = extents[objects[slot]];
+    }
+    for (uint32_t index = 0; index < tree.nodes.size(); index++)
+    {
+        const Node &node = tree.nodes[index];
+        tree.nodeArea += Bounds{node.min, node.max}.area();
+        if (node.left == 0)
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++)
+                tree.leaves[objects[slot]] = index;
+    }
+}
+
+size_t Bvh::cullFrustum(const Frustum &frustum, uint32_t *visible, uint32_t root) const
+{
+    if (root >= tree.nodes.size())
+        return 0;
+
+    // Each entry carries the planes its box still straddles; children of a box fully inside a plane
+    // skip that plane
+    struct Entry
+    {
+        uint32_t node;
+        uint32_t planes;
+    };
+    Entry stack[stackSize];
+    int top = 0;
+    stack[top++] = {root, 0x3F};
+    size_t visibleCount = 0;
+    const uint32_t *objects = tree.objects.data();
+
+    while (top > 0)
+    {
+        const Entry entry = stack[--top];
+        const Node &node = tree.nodes[entry.node];
+        const glm::vec3 center = (node.min + node.max) * 0.5f;
+        const glm::vec3 extent = (node.max - node.min) * 0.5f;
+        uint32_t planes = entry.planes;
+        bool outside = false;
+        for (int p = 0; p < 6; p++)
+        {
+            if (!(planes & (1u << p)))
+                continue;
+            const glm::vec3 normal(frustum.planes[p]);
+            const float distance = glm::dot(normal, center) + frustum.planes[p].w;
+            const float radius = glm::dot(glm::abs(normal), extent);
+            if (distance + radius < 0.0f)
+            {
+                outside = true;
+                break;
+            }
+            if (distance - radius >= 0.0f)
+                planes &= ~(1u << p);
+        }
+        if (outside)
+            continue;
+
+        if (planes == 0)
+        {
+            std::copy(objects + node.first, objects + node.first + node.count, visible + visibleCount);
+            visibleCount += node.count;
+        }
+        else if (node.left == 0)
+        {
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++)
+            {
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; p++)
+                {
+                    if (!(planes & (1u << p)))
+                        continue;
+                    const glm::vec3 normal(frustum.planes[p]);
+                    inside = glm::dot(normal, tree.centers[slot]) + frustum.planes[p].w +
+                                 glm::dot(glm::abs(normal), tree.extents[slot]) >= 0.0f;
+                }
+                if (inside)
+                    visible[visibleCount++] = objects[slot];
+            }
+        }
+        else
+        {
+            stack[top++] = {node.left, planes};
+            stack[top++] = {node.left + 1, planes};
+        }
+    }
+    return visibleCount;
+}
+
+void Bvh::splitSubtrees(size_t count, std::vector<Subtree> &subtrees) const
+{
+    subtrees.clear();
+    if (tree.nodes.empty())
+        return;
+    subtrees.push_back({0, tree.nodes[0].first, tree.nodes[0].count});
+    while (subtrees.size() < count)
+    {
+        auto largest = std::max_element(subtrees.begin(), subtrees.end(), [](const Subtree &a, const Subtree &b)
+                                        { return a.count < b.count; });
+        const Node &node = tree.nodes[largest->node];
+        if (node.left == 0) // Every subtree is a leaf
+            break;
+        const Node &left = tree.nodes[node.left], &right = tree.nodes[node.left + 1];
+        *largest = {node.left, left.first, left.count};
+        subtrees.push_back({node.left + 1, right.first, right.count});
+    }
+}
+
+bool Bvh::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, const RayTest &exact,
+                  uint32_t &object, float &distance) const
+{
+    if (tree.nodes.empty())
+        return false;
+
+    struct Entry
+    {
+        uint32_t node;
+        float entry;
+    };
+    Entry stack[stackSize];
+    int top = 0;
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    float entry;
+    if (!rayBox(origin, inverseDirection, tree.nodes[0].min, tree.nodes[0].max, maxDistance, entry))
+        return false;
+    stack[top++] = {0, entry};
+
+    bool hit = false;
+    float nearest = maxDistance;
+    while (top > 0)
+    {
+        const Entry current = stack[--top];
+        if (current.entry > nearest)
+            continue;
+        const Node &node = tree.nodes[current.node];
+
+        if (node.left == 0)
+        {
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++)
+            {
+                float boxEntry, hitDistance;
+                if (!rayBox(origin, inverseDirection, tree.centers[slot] - tree.extents[slot],
+                            tree.centers[slot] + tree.extents[slot], nearest, boxEntry))
+                    continue;
+                hitDistance = boxEntry;
+                if (exact && !exact(tree.objects[slot], hitDistance))
+                    continue;
+                if (hitDistance <= nearest)
+                {
+                    nearest = hitDistance;
+                    object = tree.objects[slot];
+                    hit = true;
+                }
+            }
+            continue;
+        }
+
+        // Near child on top so it is searched first and tightens `nearest` for the far one
+        const Node &left = tree.nodes[node.left];
+        const Node &right = tree.nodes[node.left + 1];
+        float leftEntry, rightEntry;
+        const bool hitLeft = rayBox(origin, inverseDirection, left.min, left.max, nearest, leftEntry);
+        const bool hitRight = rayBox(origin, inverseDirection, right.min, right.max, nearest, rightEntry);
+        if (hitLeft && hitRight)
+        {
+            if (leftEntry <= rightEntry)
+            {
+                stack[top++] = {node.left + 1, rightEntry};
+                stack[top++] = {node.left, leftEntry};
+            }
+            else
+            {
+                stack[top++] = {node.left, leftEntry};
+                stack[top++] = {node.left + 1, rightEntry};
+            }
+        }
+        else if (hitLeft)
+            stack[top++] = {node.left, leftEntry};
+        else if (hitRight)
+            stack[top++] = {node.left + 1, rightEntry};
+    }
+
+    if (hit)
+        distance = nearest;
+    return hit;
+}
+
+void Bvh::queryBox(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &objects) const
+{
+    objects.clear();
+    if (tree.nodes.empty())
+        return;
+
+    uint32_t stack[stackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node &node = tree.nodes[stack[--top]];
+        if (!boxesOverlap(node.min, node.max, min, max))
+            continue;
+
+        if (glm::all(glm::greaterThanEqual(node.min, min)) && glm::all(glm::lessThanEqual(node.max, max)))
+            objects.insert(objects.end(), tree.objects.begin() + node.first, tree.objects.begin() + node.first + node.count);
+        else if (node.left == 0)
+        {
+            for (uint32_t slot = node.first; slot < node.first + node.count; slot++)
+                if (boxesOverlap(tree.centers[slot] - tree.extents[slot], tree.centers[slot] + tree.extents[slot], min, max))
+                    objects.push_back(tree.objects[slot]);
+        }
+        else
+        {
+            stack[top++] = node.left;
+            stack[top++] = node.left + 1;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../render/culling/frustum_culling.h"
+
+// Dynamic bounding volume hierarchy over world boxes, shared by frustum culling, picking and
+// collision broadphase. Object ids are the box indices given to build() (entity indices here).
+//
+// Moving an object refits its leaf and only the ancestors whose bounds actually change. Refits keep
+// the tree correct but loosen it: once they have grown the summed surface area of its nodes (the SAH
+// cost, up to a constant) well past what the last build left, maintain() snapshots the boxes and a
+// worker thread rebuilds the tree with the surface area heuristic; the new tree is swapped in on the
+// owning thread and the objects that moved meanwhile are refitted into it.
+class Bvh
+{
+public:
+    // Exact test for an object whose box the ray enters: true with the hit distance along the ray
+    using RayTest = std::function<bool(uint32_t object, float &distance)>;
+
+    Bvh() = default;
+    ~Bvh();
+    Bvh(const Bvh &) = delete;
+    Bvh &operator=(const Bvh &) = delete;
+
+    // Build synchronously over boxes; this fixes the object set until the next build()
+    void build(const BoxArrays &boxes);
+
+    // New world box of one object: a local refit
+    void update(uint32_t object, const glm::vec3 &center, const glm::vec3 &extent);
+
+    // Swap in a finished background rebuild, or start one when refits have degraded the tree; once per frame
+    void maintain();
+
+    // A subtree and the run of object slots it owns
+    struct Subtree
+    {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // Objects whose box touches the frustum, in no particular order; visible needs room for size().
+    // Subtrees fully inside are appended without testing their objects. Returns the visible count.
+    // With a root from splitSubtrees() only that subtree is culled, and visible needs room for its count.
+    size_t cullFrustum(const Frustum &frustum, uint32_t *visible, uint32_t root = 0) const;
+
+    // Up to `count` disjoint subtrees holding every object between them, splitting the largest first,
+    // so culling can be spread over threads. Replaces the contents of subtrees.
+    void splitSubtrees(size_t count, std::vector<Subtree> &subtrees) const;
+
+    // Nearest object along the ray within maxDistance. Without `exact` the box entry distance counts
+    // as the hit. Returns false when nothing is hit.
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, const RayTest &exact,
+                 uint32_t &object, float &distance) const;
+
+    // Objects whose box overlaps [min, max], replacing the contents of objects
+    void queryBox(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &objects) const;
+
+    size_t size() const { return tree.objects.size(); }
+    size_t nodeCount() const { return tree.nodes.size(); }
+    bool rebuilding() const { return rebuildInFlight; }
+
+private:
+    struct Node
+    {
+        glm::vec3 min;
+        uint32_t first; // First slot of the subtree's objects
+        glm::vec3 max;
+        uint32_t count;  // Objects in the subtree
+        uint32_t left;   // First child, the second is left + 1; 0 for leaves
+        uint32_t parent; // UINT32_MAX for the root
+    };
+
+    struct Tree
+    {
+        std::vector<Node> nodes;
+        std::vector<uint32_t> objects;           // Slot -> object; every subtree owns a contiguous run
+        std::vector<uint32_t> slots;             // Object -> slot
+        std::vector<uint32_t> leaves;            // Object -> leaf node
+        std::vector<glm::vec3> centers, extents; // By slot
+        double nodeArea = 0.0;                   // Surface area summed over every node, kept by refits
+    };
+
+    struct Job
+    {
+        std::vector<glm::vec3> centers, extents; // By object
+        uint32_t sequence = 0;
+    };
+
+    static void buildTree(const std::vector<glm::vec3> &centers, const std::vector<glm::vec3> &extents, Tree &tree);
+    void workerLoop();
+
+    Tree tree;
+    double builtNodeArea = 0.0;     // tree.nodeArea as the last build left it
+    uint32_t sequence = 0;          // Of the latest rebuild request or build(); older results are dropped
+    bool rebuildInFlight = false;
+    std::vector<uint32_t> moved;    // Objects updated while a rebuild was in flight
+    std::vector<uint8_t> movedFlag; // By object
+
+    // Started by the first rebuild
+    std::thread worker;
+    bool running = true;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    bool jobPending = false;
+    Job job;
+    bool resultReady = false;
+    Tree result;
+    uint32_t resultSequence = 0;
+    double resultMilliseconds = 0.0;
+};
+
+#endif /* BVH_H */
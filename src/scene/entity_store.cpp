@@ -0,0 +1,126 @@
+#include "entity_store.h"
+
+Entity EntityStore::create(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale,
+                           const Collider &collider, const RenderHandle &render)
+{
+    uint32_t id;
+    if (!freeIds.empty())
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else
+    {
+        id = static_cast<uint32_t>(denseIndex.size());
+        denseIndex.push_back(0);
+        generations.push_back(0);
+    }
+
+    denseIndex[id] = static_cast<uint32_t>(positionData.size());
+    entityIds.push_back(id);
+    positionData.push_back(position);
+    rotationData.push_back(rotation);
+    scaleData.push_back(scale);
+    velocityData.push_back(glm::vec3(0.0f));
+    colliderData.push_back(collider);
+    renderData.push_back(render);
+    return {id, generations[id]};
+}
+
+void EntityStore::destroy(Entity entity)
+{
+    if (!alive(entity))
+        return;
+
+    // Move the last entity into the hole so the arrays stay dense
+    const size_t index = denseIndex[entity.id];
+    const size_t last = positionData.size() - 1;
+    if (index != last)
+    {
+        positionData[index] = positionData[last];
+        rotationData[index] = rotationData[last];
+        scaleData[index] = scaleData[last];
+        velocityData[index] = velocityData[last];
+        colliderData[index] = colliderData[last];
+        renderData[index] = renderData[last];
+        entityIds[index] = entityIds[last];
+        denseIndex[entityIds[index]] = static_cast<uint32_t>(index);
+    }
+    positionData.pop_back();
+    rotationData.pop_back();
+    scaleData.pop_back();
+    velocityData.pop_back();
+    colliderData.pop_back();
+    renderData.pop_back();
+    entityIds.pop_back();
+
+    generations[entity.id]++;
+    freeIds.push_back(entity.id);
+}
+
+bool EntityStore::alive(Entity entity) const
+{
+    return entity.id < generations.size() && generations[entity.id] == entity.generation;
+}
+
+void EntityStore::reserve(size_t count)
+{
+    positionData.reserve(count);
+    rotationData.reserve(count);
+    scaleData.reserve(count);
+    velocityData.reserve(count);
+    colliderData.reserve(count);
+    renderData.reserve(count);
+    entityIds.reserve(count);
+    denseIndex.reserve(count);
+    generations.reserve(count);
+}
+
+void EntityStore::clear()
+{
+    // Bump every live generation so outstanding handles die with their entities
+    for (uint32_t id : entityIds)
+    {
+        generations[id]++;
+        freeIds.push_back(id);
+    }
+    positionData.clear();
+    rotationData.clear();
+    scaleData.clear();
+    velocityData.clear();
+    colliderData.clear();
+    renderData.clear();
+    entityIds.clear();
+}
+
+void EntityStore::integrate(float deltaTime)
+{
+    glm::vec3 *position = positionData.data();
+    const glm::vec3 *velocity = velocityData.data();
+    const size_t count = positionData.size();
+    for (size_t i = 0; i < count; i++)
+        position[i] += velocity[i] * deltaTime;
+}
+
+void EntityStore::writeModelMatrices(glm::mat4 *models, size_t first, size_t count) const
+{
+    const glm::vec3 *position = positionData.data() + first;
+    const glm::quat *rotation = rotationData.data() + first;
+    const glm::vec3 *scale = scaleData.data() + first;
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::mat4 model = glm::mat4_cast(rotation[i]);
+        model[0] *= scale[i].x;
+        model[1] *= scale[i].y;
+        model[2] *= scale[i].z;
+        model[3] = glm::vec4(position[i], 1.0f);
+        models[i] = model;
+    }
+}
+
+glm::mat4 EntityStore::modelMatrix(Entity entity) const
+{
+    glm::mat4 model;
+    writeModelMatrices(&model, denseIndex[entity.id], 1);
+    return model;
+}
@@ -0,0 +1,93 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Handle to an entity. The generation makes handles to destroyed entities fail alive() instead of
+// aliasing whatever reuses their slot.
+struct Entity
+{
+    uint32_t id = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+// Axis-aligned box in the entity's local space, before rotation and scale
+struct Collider
+{
+    glm::vec3 halfExtents = glm::vec3(0.5f);
+};
+
+// What to draw for an entity: material layer (see setupRenderer.h) and its slot in an instance
+// buffer, or -1 when it is drawn on its own
+struct RenderHandle
+{
+    int material = 0;
+    int instance = -1;
+};
+
+// Structure-of-arrays entity storage. Every component lives in its own dense array and index i
+// of each array belongs to the same entity, so systems stream through exactly the components they
+// touch. Destroying swaps the last entity into the hole, keeping the arrays packed; handles stay
+// valid because they go through an id -> index table.
+class EntityStore
+{
+public:
+    Entity create(const glm::vec3 &position, const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                  const glm::vec3 &scale = glm::vec3(1.0f), const Collider &collider = Collider(),
+                  const RenderHandle &render = RenderHandle());
+    void destroy(Entity entity);
+    bool alive(Entity entity) const;
+    void reserve(size_t count);
+    void clear();
+
+    size_t size() const { return positionData.size(); }
+    size_t indexOf(Entity entity) const { return denseIndex[entity.id]; }
+    Entity entityAt(size_t index) const { return {entityIds[index], generations[entityIds[index]]}; }
+
+    // Dense component arrays, size() entries each
+    glm::vec3 *positions() { return positionData.data(); }
+    glm::quat *rotations() { return rotationData.data(); }
+    glm::vec3 *scales() { return scaleData.data(); }
+    glm::vec3 *velocities() { return velocityData.data(); }
+    Collider *colliders() { return colliderData.data(); }
+    RenderHandle *renderHandles() { return renderData.data(); }
+    const glm::vec3 *positions() const { return positionData.data(); }
+    const glm::quat *rotations() const { return rotationData.data(); }
+    const glm::vec3 *scales() const { return scaleData.data(); }
+    const glm::vec3 *velocities() const { return velocityData.data(); }
+    const Collider *colliders() const { return colliderData.data(); }
+    const RenderHandle *renderHandles() const { return renderData.data(); }
+
+    // Single-entity access for the few places that deal with one specific entity
+    glm::vec3 &position(Entity entity) { return positionData[indexOf(entity)]; }
+    glm::quat &rotation(Entity entity) { return rotationData[indexOf(entity)]; }
+    glm::vec3 &velocity(Entity entity) { return velocityData[indexOf(entity)]; }
+
+    // position += velocity * deltaTime for every entity
+    void integrate(float deltaTime);
+
+    // Translation * rotation * scale of entities [first, first + count) into models[0 .. count)
+    void writeModelMatrices(glm::mat4 *models, size_t first, size_t count) const;
+    glm::mat4 modelMatrix(Entity entity) const;
+
+private:
+    // Components, indexed densely
+    std::vector<glm::vec3> positionData;
+    std::vector<glm::quat> rotationData;
+    std::vector<glm::vec3> scaleData;
+    std::vector<glm::vec3> velocityData;
+    std::vector<Collider> colliderData;
+    std::vector<RenderHandle> renderData;
+    std::vector<uint32_t> entityIds; // Dense index -> id
+
+    // Indexed by id
+    std::vector<uint32_t> denseIndex;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeIds;
+};
+
+#endif /* ENTITY_STORE_H */
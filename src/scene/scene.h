@@ -0,0 +1,59 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <glm/glm.hpp>
+#include "entity_store.h"
+#include "bvh.h"
+
+// Free camera, or the view from the cube in cube POV mode
+struct Camera
+{
+    glm::vec3 position = glm::vec3(5.0f, 0.0f, 5.0f); // Start at the plane just in front of the cube
+    glm::vec2 angles = glm::vec2(0.0f);               // Pitch, yaw (degrees)
+    glm::vec2 mouseDelta = glm::vec2(0.0f);           // Mouse motion not yet applied to the angles
+    bool cubePOV = false;                             // Toggled with V
+    glm::mat4 viewProjection = glm::mat4(1.0f);       // Of the last rendered frame, for picking
+};
+
+// What the simulation reads from the window, taken on the main thread after polling events
+struct InputSnapshot
+{
+    bool moveForward = false, moveBackward = false, moveLeft = false, moveRight = false; // WASD
+    bool lookUp = false, lookDown = false, lookLeft = false, lookRight = false;         // Arrow keys
+    bool dragging = false;
+    bool cubePOV = false;
+    bool debugMode = false;
+    glm::vec2 mousePosition = glm::vec2(0.0f);
+    glm::dvec2 mouseTravel = glm::dvec2(0.0); // Total cursor motion so far; steps apply the difference
+    int width = 1, height = 1;                 // Framebuffer
+    glm::mat4 viewProjection = glm::mat4(1.0f); // Of the last rendered frame, for picking
+};
+
+// What the renderer reads from the simulation, published after each batch of steps
+struct SceneSnapshot
+{
+    Camera camera;
+    size_t cubeIndex = 0;
+    glm::vec3 cubePosition = glm::vec3(0.0f);
+    glm::mat4 cubeModel = glm::mat4(1.0f);
+    glm::vec3 cubeBoxCenter = glm::vec3(0.0f); // World box
+    glm::vec3 cubeBoxExtent = glm::vec3(0.0f);
+    bool cubeOnPlane = false;
+    bool mouseOverCube = false;
+};
+
+// Everything that moves: the cubes live in the entity store, `cube` is the draggable one. The BVH
+// indexes their world boxes by entity index for culling, picking and collisions.
+struct Scene
+{
+    EntityStore entities;
+    Bvh bvh;
+    Entity cube;
+    Camera camera;
+};
+
+// Set up by main.cpp and the renderer, then owned by the simulation thread; the renderer reads
+// snapshots of it
+static Scene scene;
+
+#endif /* SCENE_H */
@@ -0,0 +1,107 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "triple_buffer.h"
+
+// Fixed-step simulation on its own thread. The main thread hands input over through one triple
+// buffer; after each batch of steps the simulation publishes a snapshot of its state through
+// another, which the render thread picks up when it starts a frame. Neither side waits for the
+// other, so a slow frame does not hold back the steps and a slow step does not hold back frames.
+template <typename Input, typename Snapshot>
+class SimulationThread
+{
+public:
+    using Step = std::function<void(const Input &input, float deltaTime)>;
+    using Publish = std::function<void(const Input &input, Snapshot &snapshot)>;
+
+    SimulationThread(double stepSeconds, Step step, Publish publish)
+        : stepSeconds(stepSeconds), step(std::move(step)), publish(std::move(publish))
+    {
+    }
+
+    ~SimulationThread() { stop(); }
+
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator=(const SimulationThread &) = delete;
+
+    // Publish the initial state from the calling thread, so the first frame has a snapshot, then
+    // start stepping. Publish an input first.
+    void start()
+    {
+        inputs.acquire();
+        publish(inputs.front(), snapshots.back());
+        snapshots.publish();
+        running = true;
+        thread = std::thread(&SimulationThread::run, this);
+    }
+
+    // After this the state belongs to the calling thread again
+    void stop()
+    {
+        running = false;
+        if (thread.joinable())
+            thread.join();
+    }
+
+    // Main thread: fill input().back(), then input().publish()
+    TripleBuffer<Input> &input() { return inputs; }
+    // Render thread: output().acquire(), then read output().front()
+    TripleBuffer<Snapshot> &output() { return snapshots; }
+
+    uint64_t stepCount() const { return steps.load(std::memory_order_relaxed); }
+    // Duration of the last step
+    double stepMilliseconds() const { return lastStepMilliseconds.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run()
+    {
+        Clock::time_point previous = Clock::now();
+        double accumulator = 0.0;
+        while (running)
+        {
+            Clock::time_point now = Clock::now();
+            accumulator += std::min(std::chrono::duration<double>(now - previous).count(), 0.1); // Skip long stalls
+            previous = now;
+
+            inputs.acquire();
+            bool stepped = false;
+            while (accumulator >= stepSeconds)
+            {
+                Clock::time_point start = Clock::now();
+                step(inputs.front(), static_cast<float>(stepSeconds));
+                lastStepMilliseconds.store(std::chrono::duration<double, std::milli>(Clock::now() - start).count(),
+                                           std::memory_order_relaxed);
+                steps.fetch_add(1, std::memory_order_relaxed);
+                accumulator -= stepSeconds;
+                stepped = true;
+            }
+            if (stepped)
+            {
+                publish(inputs.front(), snapshots.back());
+                snapshots.publish();
+            }
+            std::this_thread::sleep_until(now + std::chrono::duration_cast<Clock::duration>(
+                                                    std::chrono::duration<double>(stepSeconds - accumulator)));
+        }
+    }
+
+    double stepSeconds;
+    Step step;
+    Publish publish;
+    TripleBuffer<Input> inputs;
+    TripleBuffer<Snapshot> snapshots;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> steps{0};
+    std::atomic<double> lastStepMilliseconds{0.0};
+    std::thread thread;
+};
+
+#endif /* SIMULATION_H */
@@ -0,0 +1,46 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-over of the latest value from one writer thread to one reader thread. The writer
+// fills back() and publishes it; the reader acquires the newest published value into front(). Values
+// the reader never got to are overwritten, and neither side ever waits: each owns one slot, the
+// third sits in the middle and is swapped with an atomic exchange.
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Writer: the slot to fill next
+    T &back() { return slots[backIndex]; }
+
+    // Writer: hand back() over; the slot returned in its place holds stale data to overwrite
+    void publish()
+    {
+        backIndex = middle.exchange(static_cast<uint8_t>(backIndex | fresh), std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader: take the newest published value, if any arrived since the last call; true when it did
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & fresh))
+            return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    // Reader: the value last acquired
+    const T &front() const { return slots[frontIndex]; }
+
+private:
+    static const uint8_t indexMask = 3;
+    static const uint8_t fresh = 4; // Set in middle while it holds a value the reader has not taken
+
+    T slots[3];
+    uint8_t backIndex = 0;
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t frontIndex = 2;
+};
+
+#endif /* TRIPLE_BUFFER_H */
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Generate an embedded resource table (resources.h / resources.cpp).
+
+Every file under the given resource roots is linked into the executable as raw bytes and
+registered as "resources/<path relative to root>" (lowercase, forward slashes).
+GCC/Clang builds pull the files in with .incbin; MSVC builds get plain byte arrays.
+"""
+
+import argparse
+import os
+
+HEADER = """// Generated by tools/embed_resources.py - do not edit
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include <cstddef>
+#include <string>
+
+struct EmbeddedResource
+{
+    const char *name;
+    const unsigned char *data;
+    size_t size;
+};
+
+extern const EmbeddedResource embeddedResources[];
+extern const size_t embeddedResourceCount;
+
+// Look up a resource by path ("resources/textures/wood.jpg"); returns nullptr if not embedded
+const EmbeddedResource *findEmbeddedResource(const std::string &name);
+
+#endif /* RESOURCES_H */
+"""
+
+LOOKUP = """
+const size_t embeddedResourceCount = {count};
+
+const EmbeddedResource *findEmbeddedResource(const std::string &name)
+{{
+    std::string key = name;
+    for (char &c : key)
+    {{
+        c = c == '\\\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }}
+
+    const EmbeddedResource *end = embeddedResources + embeddedResourceCount;
+    const EmbeddedResource *it = std::lower_bound(embeddedResources, end, key,
+                                                  [](const EmbeddedResource &resource, const std::string &value)
+                                                  {{ return value.compare(resource.name) > 0; }});
+    return (it != end && key == it->name) ? it : nullptr;
+}}
+"""
+
+
+def collect(roots):
+    resources = {}
+    for root in roots:
+        if not os.path.isdir(root):
+            continue
+        for directory, _, files in os.walk(root):
+            for filename in sorted(files):
+                path = os.path.join(directory, filename)
+                name = "resources/" + os.path.relpath(path, root).replace(os.sep, "/").lower()
+                resources[name] = os.path.abspath(path).replace(os.sep, "/")
+    return sorted(resources.items())
+
+
+def incbin_block(symbol, path):
+    return (
+        "__asm__(\".section \" RESOURCE_SECTION \"\\n\"\n"
+        "        \".balign 16\\n\"\n"
+        f"        RESOURCE_SYMBOL(\"{symbol}\") \":\\n\"\n"
+        f"        \".incbin \\\"{path}\\\"\\n\"\n"
+        f"        RESOURCE_SYMBOL(\"{symbol}_end\") \":\\n\"\n"
+        "        \".byte 0\\n\"\n"
+        "        \".previous\\n\");\n"
+        f"extern \"C\" const unsigned char {symbol}[];\n"
+        f"extern \"C\" const unsigned char {symbol}_end[];\n"
+    )
+
+
+def array_block(symbol, path):
+    with open(path, "rb") as f:
+        data = f.read()
+    lines = []
+    for offset in range(0, len(data), 24):
+        lines.append("    " + ", ".join(f"0x{b:02x}" for b in data[offset:offset + 24]) + ",")
+    body = "\n".join(lines) if lines else "    0,"
+    return f"static const unsigned char {symbol}[] = {{\n{body}\n}};\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--mode", choices=["incbin", "array"], default="incbin")
+    parser.add_argument("--header", required=True)
+    parser.add_argument("--source", required=True)
+    parser.add_argument("roots", nargs="+")
+    args = parser.parse_args()
+
+    resources = collect(args.roots)
+
+    source = [
+        "// Generated by tools/embed_resources.py - do not edit",
+        "#include \"resources.h\"",
+        "",
+        "#include <algorithm>",
+        "#include <cctype>",
+        "",
+    ]
+    if args.mode == "incbin":
+        source += [
+            "#if defined(__APPLE__)",
+            "#define RESOURCE_SECTION \"__TEXT,__const\"",
+            "#define RESOURCE_SYMBOL(name) \".globl _\" name \"\\n_\" name",
+            "#else",
+            "#define RESOURCE_SECTION \".rodata\"",
+            "#define RESOURCE_SYMBOL(name) \".globl \" name \"\\n\" name",
+            "#endif",
+            "",
+        ]
+
+    entries = []
+    for index, (name, path) in enumerate(resources):
+        symbol = f"embedded_resource_{index}"
+        if args.mode == "incbin":
+            source.append(incbin_block(symbol, path))
+            entries.append(f"    {{\"{name}\", {symbol}, static_cast<size_t>({symbol}_end - {symbol})}},")
+        else:
+            source.append(array_block(symbol, path))
+            entries.append(f"    {{\"{name}\", {symbol}, sizeof({symbol})}},")
+
+    # Keep the table valid C++ even when nothing is embedded
+    if not entries:
+        entries.append("    {\"\", nullptr, 0},")
+    source.append("const EmbeddedResource embeddedResources[] = {")
+    source += entries
+    source.append("};")
+    source.append(LOOKUP.format(count=len(resources)))
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.header)), exist_ok=True)
+    os.makedirs(os.path.dirname(os.path.abspath(args.source)), exist_ok=True)
+    with open(args.header, "w", newline="\n") as f:
+        f.write(HEADER)
+    with open(args.source, "w", newline="\n") as f:
+        f.write("\n".join(source))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+// Offline texture compressor: decodes an image, builds its (Kaiser-filtered) mip chain and writes a BC1 or BC7 KTX2 file.
+// Usage: texture_compressor <bc1|bc7> <input image> <output.ktx2>
+
+#include <spdlog/spdlog.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "render/texture/block_compressor.h"
+#include "render/texture/image_decoder.h"
+#include "render/texture/ktx2.h"
+#include "render/texture/mipmap.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4)
+    {
+        spdlog::error("Usage: {} <bc1|bc7> <input image> <output.ktx2>", argv[0]);
+        return 1;
+    }
+
+    std::string format = argv[1];
+    if (format != "bc1" && format != "bc7")
+    {
+        spdlog::error("Unknown format: {}", format);
+        return 1;
+    }
+    const bool bc7 = format == "bc7";
+
+    // Rows stay top row first, the KTX2 default orientation and what the runtime decoders produce
+    std::ifstream file(argv[2], std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    DecodedImage image;
+    if (bytes.empty() || !decodeImage(bytes.data(), bytes.size(), 4, image))
+    {
+        spdlog::error("Failed to load image: {}", argv[2]);
+        return 1;
+    }
+    const int width = image.width;
+    const int height = image.height;
+
+    // Gamma-correct mip chain, then every level is block compressed
+    std::vector<MipLevel> mips = buildMipChain(image.data(), width, height, 4, MipFilter::Kaiser);
+
+    std::vector<std::vector<uint8_t>> levels = compressMipChain(mips, bc7 ? BlockFormat::BC7 : BlockFormat::BC1);
+
+    uint32_t vkFormat = bc7 ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    if (!writeKtx2(argv[3], vkFormat, width, height, levels))
+    {
+        spdlog::error("Failed to write {}", argv[3]);
+        return 1;
+    }
+
+    spdlog::info("{} -> {} ({}x{}, {} levels, {})", argv[2], argv[3], width, height, levels.size(), format);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Virtual texture baker: cuts an image (optionally repeated N x N to build a very large surface)
+// into the bordered, pre-mipmapped tiles read by VirtualTexture at runtime.
+// Usage: vt_baker <input image> <output.vt> [repeat] [tileSize]
+
+#include <spdlog/spdlog.h>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "render/texture/image_decoder.h"
+#include "render/texture/mipmap.h"
+#include "render/texture/vt_format.h"
+
+// Levels larger than this are never materialized: they are the source mip repeated
+static const uint32_t materializeLimit = 4096;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 5)
+    {
+        spdlog::error("Usage: {} <input image> <output.vt> [repeat] [tileSize]", argv[0]);
+        return 1;
+    }
+    const uint32_t repeat = argc > 3 ? static_cast<uint32_t>(std::max(std::atoi(argv[3]), 1)) : 1;
+    const uint32_t tileSize = argc > 4 ? static_cast<uint32_t>(std::max(std::atoi(argv[4]), 16)) : 128;
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    DecodedImage image;
+    if (bytes.empty() || !decodeImage(bytes.data(), bytes.size(), 4, image))
+    {
+        spdlog::error("Failed to load image: {}", argv[1]);
+        return 1;
+    }
+
+    VirtualTextureInfo info;
+    info.width = static_cast<uint32_t>(image.width) * repeat;
+    info.height = static_cast<uint32_t>(image.height) * repeat;
+    info.tileSize = tileSize;
+    info.levelCount = vtLevelCount(info.width, info.height, tileSize);
+
+    // A repeated image's mip L is (approximately) the source's mip L repeated, so huge levels
+    // are never held in memory. Once a level is small enough it is built for real and mipped on.
+    std::vector<MipLevel> sourceMips = buildMipChain(image.data(), image.width, image.height, 4);
+    std::vector<MipLevel> smallMips;
+    uint32_t smallStart = info.levelCount;
+
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out)
+    {
+        spdlog::error("Failed to open {}", argv[2]);
+        return 1;
+    }
+    writeVirtualTextureHeader(out, info);
+
+    const uint32_t padded = info.paddedTileSize();
+    std::vector<uint8_t> tile(info.tileBytes());
+    for (uint32_t level = 0; level < info.levelCount; level++)
+    {
+        const uint32_t levelWidth = info.levelWidth(level);
+        const uint32_t levelHeight = info.levelHeight(level);
+        if (smallStart == info.levelCount && std::max(levelWidth, levelHeight) <= materializeLimit)
+        {
+            const MipLevel &mip = sourceMips[std::min<size_t>(level, sourceMips.size() - 1)];
+            std::vector<uint8_t> pixels(static_cast<size_t>(levelWidth) * levelHeight * 4);
+            for (uint32_t y = 0; y < levelHeight; y++)
+                for (uint32_t x = 0; x < levelWidth; x++)
+                    std::memcpy(&pixels[(static_cast<size_t>(y) * levelWidth + x) * 4],
+                                &mip.pixels[(static_cast<size_t>(y % mip.height) * mip.width + x % mip.width) * 4], 4);
+            smallMips = buildMipChain(pixels.data(), levelWidth, levelHeight, 4);
+            smallStart = level;
+        }
+        const MipLevel &source = level >= smallStart ? smallMips[std::min<size_t>(level - smallStart, smallMips.size() - 1)]
+                                                     : sourceMips[std::min<size_t>(level, sourceMips.size() - 1)];
+
+        for (uint32_t tileY = 0; tileY < info.tilesY(level); tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < info.tilesX(level); tileX++)
+            {
+                // Borders and the ragged last row/column wrap around, like the repeating ground
+                for (uint32_t y = 0; y < padded; y++)
+                {
+                    int64_t sy = static_cast<int64_t>(tileY) * tileSize + y - info.border;
+                    sy = ((sy % levelHeight) + levelHeight) % levelHeight % source.height;
+                    for (uint32_t x = 0; x < padded; x++)
+                    {
+                        int64_t sx = static_cast<int64_t>(tileX) * tileSize + x - info.border;
+                        sx = ((sx % levelWidth) + levelWidth) % levelWidth % source.width;
+                        std::memcpy(&tile[(static_cast<size_t>(y) * padded + x) * 4],
+                                    &source.pixels[(static_cast<size_t>(sy) * source.width + sx) * 4], 4);
+                    }
+                }
+                out.write(reinterpret_cast<const char *>(tile.data()), static_cast<std::streamsize>(tile.size()));
+            }
+        }
+        spdlog::info("Level {}: {}x{} ({}x{} tiles)", level, levelWidth, levelHeight, info.tilesX(level), info.tilesY(level));
+    }
+
+    if (!out)
+    {
+        spdlog::error("Failed to write {}", argv[2]);
+        return 1;
+    }
+    spdlog::info("{} -> {} ({}x{} virtual, {} levels, {} tiles of {}px)", argv[1], argv[2], info.width, info.height,
+                 info.levelCount, info.tileIndex(info.levelCount, 0, 0), tileSize);
+    return 0;
+}